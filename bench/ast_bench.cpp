@@ -0,0 +1,156 @@
+/*
+AST construction benchmarks. Builds and drops the same expression trees
+with the arena-backed P<T>/Slice<T> links of amyr::ast and with the
+shared_ptr links it used to have, and reports how much memory each takes.
+*/
+#include<cstdio>
+#include<cstdlib>
+#include<memory>
+#include<new>
+#include<string>
+#include<utility>
+#include<vector>
+
+#include "bench.hpp"
+#include "amyr-ast/ast.hpp"
+
+namespace {
+
+size_t heap_bytes = 0;
+
+} // namespace
+
+// Counts every heap allocation, so both layouts can be weighed the same way.
+void* operator new(size_t size) {
+    heap_bytes += size;
+    if (void* p = std::malloc(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+
+// The shared_ptr layout the nodes had before P<T>, kept here for comparison.
+namespace shared {
+
+    struct Expr {
+        using Kind = amyr::ast::Expr::Kind;
+        Kind kind;
+        explicit Expr(Kind kind) : kind(kind) {}
+        virtual ~Expr() = default;
+    };
+
+    struct BinaryExpr : Expr {
+        std::shared_ptr<Expr> lhs;
+        std::shared_ptr<Expr> rhs;
+        std::string op;
+        BinaryExpr(std::shared_ptr<Expr> lhs, std::shared_ptr<Expr> rhs, std::string op)
+            : Expr(Kind::Binary), lhs(std::move(lhs)), rhs(std::move(rhs)), op(std::move(op)) {}
+    };
+
+    struct LiteralExpr : Expr {
+        std::variant<int, double, std::string> value;
+        explicit LiteralExpr(std::variant<int, double, std::string> value)
+            : Expr(Kind::Literal), value(std::move(value)) {}
+    };
+
+    struct BlockExpr : Expr {
+        std::vector<std::shared_ptr<Expr>> statements;
+        explicit BlockExpr(std::vector<std::shared_ptr<Expr>> statements)
+            : Expr(Kind::Block), statements(std::move(statements)) {}
+    };
+
+} // namespace shared
+
+constexpr int FUNCTIONS = 2000;
+constexpr int STATEMENTS = 20;
+constexpr int DEPTH = 4;
+
+// A full binary tree of `depth` levels of operators over literals.
+std::shared_ptr<shared::Expr> shared_tree(int depth, int& next) {
+    if (depth == 0) {
+        return std::make_shared<shared::LiteralExpr>(next++);
+    }
+    auto lhs = shared_tree(depth - 1, next);
+    auto rhs = shared_tree(depth - 1, next);
+    return std::make_shared<shared::BinaryExpr>(std::move(lhs), std::move(rhs), depth % 2 ? "+" : "*");
+}
+
+std::shared_ptr<shared::Expr> shared_crate() {
+    int next = 0;
+    std::vector<std::shared_ptr<shared::Expr>> functions;
+    for (int f = 0; f < FUNCTIONS; ++f) {
+        std::vector<std::shared_ptr<shared::Expr>> statements;
+        for (int s = 0; s < STATEMENTS; ++s) {
+            statements.push_back(shared_tree(DEPTH, next));
+        }
+        functions.push_back(std::make_shared<shared::BlockExpr>(std::move(statements)));
+    }
+    return std::make_shared<shared::BlockExpr>(std::move(functions));
+}
+
+amyr::ast::P<amyr::ast::Expr> arena_tree(amyr::ast::Arena& arena, int depth, int& next) {
+    if (depth == 0) {
+        return arena.alloc<amyr::ast::LiteralExpr>(next++);
+    }
+    auto lhs = arena_tree(arena, depth - 1, next);
+    auto rhs = arena_tree(arena, depth - 1, next);
+    return arena.alloc<amyr::ast::BinaryExpr>(std::move(lhs), std::move(rhs), depth % 2 ? "+" : "*");
+}
+
+amyr::ast::P<amyr::ast::Expr> arena_crate(amyr::ast::Arena& arena) {
+    int next = 0;
+    std::vector<amyr::ast::P<amyr::ast::Expr>> functions;
+    for (int f = 0; f < FUNCTIONS; ++f) {
+        std::vector<amyr::ast::P<amyr::ast::Expr>> statements;
+        for (int s = 0; s < STATEMENTS; ++s) {
+            statements.push_back(arena_tree(arena, DEPTH, next));
+        }
+        functions.push_back(arena.alloc<amyr::ast::BlockExpr>(arena.alloc_slice(std::move(statements))));
+    }
+    return arena.alloc<amyr::ast::BlockExpr>(arena.alloc_slice(std::move(functions)));
+}
+
+} // namespace
+
+int main() {
+    const size_t nodes = FUNCTIONS * (1 + STATEMENTS * ((2 << DEPTH) - 1)) + 1;
+    std::printf("crate: %zu nodes\n", nodes);
+
+    heap_bytes = 0;
+    {
+        auto crate = shared_crate();
+        std::printf("memory/shared_ptr (before)      %10zu bytes\n", heap_bytes);
+    }
+    heap_bytes = 0;
+    {
+        amyr::ast::Arena arena;
+        arena_crate(arena);
+        std::printf("memory/arena P<T> (after)       %10zu bytes\n", heap_bytes + arena.allocated_bytes());
+    }
+
+    // The harness counts bytes; here each "byte" is a node.
+    const bench::Measurement before = bench::measure(nodes, [&] {
+        auto crate = shared_crate();
+        bench::do_not_optimize(crate.get());
+    });
+    std::printf("build+drop/shared_ptr (before)  %10.2f Mnodes/s\n", before.bytes_per_sec / 1e6);
+
+    const bench::Measurement after = bench::measure(nodes, [&] {
+        amyr::ast::Arena arena;
+        auto crate = arena_crate(arena);
+        bench::do_not_optimize(crate.get());
+    });
+    std::printf("build+drop/arena P<T> (after)   %10.2f Mnodes/s\n", after.bytes_per_sec / 1e6);
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+/*
+Stored benchmark results, for catching regressions.
+
+A baseline is a flat JSON object mapping case names to their throughput:
+
+    {
+      "tokenize/identifiers": {"mb_per_s": 80.10, "mtok_per_s": 11.42},
+      ...
+    }
+
+Only this shape is read back, so the reader is a small scanner rather than a
+JSON parser. Cases missing from the baseline are reported as new.
+*/
+#pragma once
+
+#include<cstdio>
+#include<cstdlib>
+#include<fstream>
+#include<map>
+#include<sstream>
+#include<stdexcept>
+#include<string>
+
+namespace bench {
+
+struct Throughput {
+    double mb_per_s = 0;
+    double mtok_per_s = 0;
+};
+
+using Baseline = std::map<std::string, Throughput>;
+
+inline void save_baseline(const std::string& path, const Baseline& baseline) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("cannot write baseline " + path);
+    }
+    out << "{\n";
+    size_t i = 0;
+    for (const auto& [name, result] : baseline) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "  \"%s\": {\"mb_per_s\": %.2f, \"mtok_per_s\": %.2f}%s\n",
+                      name.c_str(), result.mb_per_s, result.mtok_per_s, ++i == baseline.size() ? "" : ",");
+        out << line;
+    }
+    out << "}\n";
+}
+
+namespace baseline_detail {
+
+    // Value of `"key": <number>` in `text`, 0 if it's missing.
+    inline double number_after(const std::string& text, const char* key) {
+        const size_t at = text.find(std::string("\"") + key + "\"");
+        if (at == std::string::npos) {
+            return 0;
+        }
+        const size_t colon = text.find(':', at);
+        return std::strtod(text.c_str() + colon + 1, nullptr);
+    }
+
+} // namespace baseline_detail
+
+inline Baseline load_baseline(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("cannot read baseline " + path);
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string text = buffer.str();
+
+    Baseline baseline;
+    // Each case is `"name": {...}`; the values are the numbers inside the braces.
+    size_t pos = 0;
+    while ((pos = text.find('"', pos)) != std::string::npos) {
+        const size_t name_end = text.find('"', pos + 1);
+        const size_t open = text.find_first_not_of(" \t\r\n:", name_end + 1);
+        if (name_end == std::string::npos || open == std::string::npos || text[open] != '{') {
+            throw std::runtime_error("malformed baseline " + path);
+        }
+        const size_t close = text.find('}', open);
+        if (close == std::string::npos) {
+            throw std::runtime_error("malformed baseline " + path);
+        }
+        const std::string body = text.substr(open, close - open);
+        baseline[text.substr(pos + 1, name_end - pos - 1)] = Throughput{
+            baseline_detail::number_after(body, "mb_per_s"),
+            baseline_detail::number_after(body, "mtok_per_s"),
+        };
+        pos = close + 1;
+    }
+    return baseline;
+}
+
+} // namespace bench
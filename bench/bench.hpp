@@ -0,0 +1,56 @@
+/*
+Minimal self-contained benchmark harness.
+
+Each case runs a callable repeatedly for at least `min_time` and reports the
+best observed throughput, which is less noisy than the mean on a shared box.
+*/
+#pragma once
+
+#include<chrono>
+#include<cstdio>
+#include<string>
+#include<utility>
+
+namespace bench {
+
+// Keeps the optimizer from discarding a computed value.
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Measurement {
+    double seconds_per_iter;
+    double bytes_per_sec;
+};
+
+// Times `func` without printing anything.
+template <typename Func>
+Measurement measure(size_t bytes_per_iter, Func&& func,
+                    std::chrono::duration<double> min_time = std::chrono::milliseconds(500)) {
+    using clock = std::chrono::steady_clock;
+
+    double best = 1e300;
+    std::chrono::duration<double> total{0};
+    while (total < min_time) {
+        const auto start = clock::now();
+        func();
+        const std::chrono::duration<double> elapsed = clock::now() - start;
+        total += elapsed;
+        if (elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+
+    return Measurement{best, static_cast<double>(bytes_per_iter) / best};
+}
+
+template <typename Func>
+Measurement run(const std::string& name, size_t bytes_per_iter, Func&& func,
+                std::chrono::duration<double> min_time = std::chrono::milliseconds(500)) {
+    const Measurement m = measure(bytes_per_iter, std::forward<Func>(func), min_time);
+    std::printf("%-40s %10.2f MB/s\n", name.c_str(), m.bytes_per_sec / (1024.0 * 1024.0));
+    return m;
+}
+
+} // namespace bench
@@ -0,0 +1,112 @@
+/*
+The expression grammar parsed the way it was before BINOP_TABLE: one
+recursive-descent function per precedence level, each calling the next
+tighter one for its operands. Kept only so the benchmark can compare
+against it. Builds the same nodes as node::Parser; it skips the borrow
+check and the chained comparison error, which cost nothing per operand.
+*/
+#pragma once
+
+#include<cstdint>
+#include<memory>
+#include<optional>
+#include<stdexcept>
+#include<string>
+#include<unordered_set>
+#include<vector>
+
+#include "parser.hpp"
+
+namespace cascade_parser {
+
+using node::BinOp;
+using node::ExprAST;
+
+class Parser {
+public:
+    explicit Parser(std::unique_ptr<TokenSource> source) : tokens(std::move(source)) {}
+
+    node::ParsedAst parse_program() {
+        std::vector<ExprAST*> expressions;
+        while (peek() != TokenType::EOF_TOKEN) {
+            expressions.push_back(parse_level<1>());
+            match(TokenType::Semicolon);
+        }
+        ExprAST* root = arena->make<node::BlockExprAST>(arena->make_list(expressions));
+        return node::ParsedAst(std::move(arena), root);
+    }
+
+private:
+    TokenBuffer tokens;
+    std::unordered_set<amyr::span::Symbol> declared_variables;
+    std::unique_ptr<node::AstArena> arena = std::make_unique<node::AstArena>();
+
+    TokenType peek() const { return tokens.peek().token.type; }
+
+    bool match(TokenType type) {
+        if (peek() == type && type != TokenType::EOF_TOKEN) {
+            tokens.bump();
+            return true;
+        }
+        return false;
+    }
+
+    // Level `prec` in the same numbering as node::BINOP_TABLE; 10 is a primary.
+    template <uint8_t prec>
+    ExprAST* parse_level() {
+        if constexpr (prec == 10) {
+            return parse_primary();
+        } else {
+            ExprAST* expr = parse_level<prec + 1>();
+            for (;;) {
+                const node::BinOpInfo info = node::binop_info(peek());
+                if (info.prec != prec) {
+                    return expr;
+                }
+                tokens.bump();
+                ExprAST* right = parse_level<prec + 1>();
+                expr = arena->make<node::BinaryExprAST>(info.op, expr, right);
+            }
+        }
+    }
+
+    ExprAST* parse_primary() {
+        if (match(TokenType::Integer)) {
+            std::optional<int> value = tokens.previous().literal.as_int();
+            if (!value) {
+                throw std::runtime_error("Integer literal out of range.");
+            }
+            return arena->make<node::IntExprAST>(*value);
+        }
+        if (match(TokenType::Identifier)) {
+            amyr::span::Symbol name(tokens.previous().token.index);
+            if (declared_variables.find(name) == declared_variables.end()) {
+                throw std::runtime_error("Use of undeclared variable: " + std::string(name.as_str()));
+            }
+            return arena->make<node::VariableExprAST>(name);
+        }
+        if (match(TokenType::LeftParen)) {
+            ExprAST* expr = parse_level<1>();
+            if (!match(TokenType::RightParen)) {
+                throw std::runtime_error("Expect ')' after expression.");
+            }
+            return expr;
+        }
+        if (match(TokenType::Let)) {
+            if (!match(TokenType::Identifier)) {
+                throw std::runtime_error("Expect identifier after 'let'.");
+            }
+            amyr::span::Symbol name(tokens.previous().token.index);
+            const bool is_mutable = match(TokenType::Mut);
+            if (!match(TokenType::Equals)) {
+                throw std::runtime_error("Expect '=' after variable name.");
+            }
+            ExprAST* init = parse_level<1>();
+            declared_variables.insert(name);
+            return arena->make<node::LetExprAST>(name, is_mutable, init);
+        }
+        throw std::runtime_error("Expect expression.");
+    }
+};
+
+} // namespace cascade_parser
@@ -0,0 +1,479 @@
+/*
+Lexer benchmarks.
+
+The suite runs Tokenizer::tokenize() and the low-level TokenIterator over the
+synthetic corpora in corpora.hpp and reports MB/s and tokens/s for each. With
+`--baseline FILE` it compares against stored results and exits with status 1
+if any case lost more than `--tolerance` percent (default 10) of its MB/s;
+`--save-baseline FILE` writes the current results. The stored baseline is
+bench/lexer_baseline.json.
+
+Unless `--suite` is given, the before/after comparisons run first: bytes/second
+for the hot trivia paths of the Cursor and for keyword recognition,
+tokens/second for the low-level lexer core, bytes/second for
+tokenize_parallel against its thread count, and bytes/second for turning
+string literal contents into values.
+*/
+#include<algorithm>
+#include<cstdio>
+#include<cstdlib>
+#include<cstring>
+#include<functional>
+#include<string>
+#include<string_view>
+#include<thread>
+#include<unordered_map>
+#include<vector>
+
+#include "bench.hpp"
+#include "baseline.hpp"
+#include "corpora.hpp"
+#include "amyr-span/source_map.hpp"
+#include "amyr-tokenizer/cursor.hpp"
+#include "amyr-tokenizer/tokenizer.hpp"
+#include "amyr-tokenizer/low_lexer.hpp"
+#include "amyr-tokenizer/parallel_lexer.hpp"
+#include "amyr-tokenizer/unicode_escape.hpp"
+#include "variant_lexer.hpp"
+
+namespace {
+
+// Indentation-heavy source with line and block comments, like our generated modules.
+std::string make_trivia_corpus(size_t target_bytes) {
+    std::string out;
+    out.reserve(target_bytes + 256);
+    size_t line = 0;
+    while (out.size() < target_bytes) {
+        out.append(4 + (line % 5) * 4, ' ');
+        switch (line % 4) {
+            case 0: out += "// generated: keep in sync with the schema definition\n"; break;
+            case 1: out += "let value_" + std::to_string(line) + " = 42;\n"; break;
+            case 2: out += "/* field offset table entry, see layout.rs for details */\n"; break;
+            default: out += "\t\t\n"; break;
+        }
+        ++line;
+    }
+    return out;
+}
+
+// Skips trivia the way the byte-at-a-time lexer used to.
+size_t skip_trivia_bytewise(std::string_view src) {
+    Cursor cursor(src);
+    size_t tokens = 0;
+    while (!cursor.is_eof()) {
+        const char c = cursor.first();
+        if (amyr::simd::is_ascii_whitespace(static_cast<unsigned char>(c))) {
+            cursor.eat_while([](char ch) { return amyr::simd::is_ascii_whitespace(static_cast<unsigned char>(ch)); });
+        } else if (c == '/' && cursor.second() == '/') {
+            cursor.eat_while([](char ch) { return ch != '\n'; });
+        } else if (c == '/' && cursor.second() == '*') {
+            cursor.bump();
+            cursor.bump();
+            while (!cursor.is_eof() && !(cursor.first() == '*' && cursor.second() == '/')) {
+                cursor.bump();
+            }
+            cursor.bump();
+            cursor.bump();
+        } else {
+            cursor.bump();
+        }
+        ++tokens;
+    }
+    return tokens;
+}
+
+// Same walk using the bulk Cursor scanners.
+size_t skip_trivia_bulk(std::string_view src) {
+    Cursor cursor(src);
+    size_t tokens = 0;
+    while (!cursor.is_eof()) {
+        const char c = cursor.first();
+        if (amyr::simd::is_ascii_whitespace(static_cast<unsigned char>(c))) {
+            cursor.eat_ascii_whitespace();
+        } else if (c == '/' && cursor.second() == '/') {
+            cursor.eat_until('\n');
+        } else if (c == '/' && cursor.second() == '*') {
+            cursor.bump();
+            cursor.bump();
+            while (true) {
+                cursor.eat_until_either('*', '/');
+                auto ch = cursor.bump();
+                if (!ch.has_value() || (ch == '*' && cursor.first() == '/')) {
+                    break;
+                }
+            }
+            cursor.bump();
+        } else {
+            cursor.bump();
+        }
+        ++tokens;
+    }
+    return tokens;
+}
+
+// Identifier-heavy word list: mostly plain identifiers, with a keyword every few words.
+std::vector<std::string_view> make_identifier_words(std::string& storage, size_t count) {
+    static const char* const samples[] = {
+        "let", "value", "mut", "buffer_len", "if", "else", "result", "func", "index",
+        "return", "node_kind", "x", "while", "type_id", "fn", "self", "parent_scope",
+    };
+    for (size_t i = 0; i < count; ++i) {
+        storage += samples[i % (sizeof(samples) / sizeof(samples[0]))];
+        if (i % 3 == 0) {
+            storage += std::to_string(i % 100);
+        }
+        storage += ' ';
+    }
+
+    std::vector<std::string_view> words;
+    std::string_view rest = storage;
+    while (!rest.empty()) {
+        const size_t space = rest.find(' ');
+        words.push_back(rest.substr(0, space));
+        rest.remove_prefix(space + 1);
+    }
+    return words;
+}
+
+// The keyword table the Tokenizer used before the perfect hash.
+const std::unordered_map<std::string, TokenType> legacy_keywords = {
+    {"let", TokenType::Let},
+    {"mut", TokenType::Mut},
+    {"func", TokenType::Func},
+    {"return", TokenType::Return},
+    {"if", TokenType::If},
+    {"else", TokenType::Else}
+};
+
+// Ordinary source: items, literals of every kind, comments and indentation.
+std::string make_source_corpus(size_t target_bytes) {
+    std::string out;
+    out.reserve(target_bytes + 256);
+    size_t n = 0;
+    while (out.size() < target_bytes) {
+        out += "/// Computes entry " + std::to_string(n) + " of the table.\n";
+        out += "fn entry_" + std::to_string(n) + "(idx: u32, scale: f64) -> Result<u64, Error> {\n";
+        out += "    let mut acc = 0x" + std::to_string(n % 997) + "_u64 + idx as u64 * " + std::to_string(n) + ";\n";
+        out += "    if scale > 1.5e3 { acc <<= 2; } // clamp\n";
+        out += "    let name = \"entry\\n\"; let tag = b'x'; let raw = r#\"a \"q\" b\"#;\n";
+        out += "    match acc % 3 { 0 => Ok(acc), _ => Err(Error::new('e', &name[..])) }\n";
+        out += "}\n\n";
+        ++n;
+    }
+    return out;
+}
+
+template <typename Lexer>
+size_t count_tokens(std::string_view src, Lexer advance) {
+    Cursor cursor(src);
+    size_t tokens = 0;
+    while (advance(cursor)) {
+        ++tokens;
+    }
+    return tokens;
+}
+
+bool advance_table(Cursor& cursor) {
+    return amyr::lexer::advance_token(cursor).kind != amyr::lexer::TokenKind::Eof;
+}
+
+bool advance_variant(Cursor& cursor) {
+    return !std::holds_alternative<variant_lexer::Eof>(variant_lexer::advance_token(cursor).kind);
+}
+
+// Commented-out regions full of `*` and `/`, and raw strings holding JSON blobs.
+std::string make_delimiter_corpus(size_t target_bytes) {
+    std::string out;
+    out.reserve(target_bytes + 512);
+    size_t n = 0;
+    while (out.size() < target_bytes) {
+        out += "/" + std::string(70, '*') + "\n";
+        out += " * see src/amyr-parser/arena.hpp and src/amyr-tokenizer/low_lexer.hpp for entry " + std::to_string(n) + "\n";
+        out += " * " + std::string(66, '-') + " *\n " + std::string(70, '*') + "/\n";
+        out += "let blob = r#\"{\"id\": " + std::to_string(n) + ", \"tags\": [\"a\", \"b\", \"c\"], "
+               "\"meta\": {\"owner\": \"build\", \"path\": \"/usr/share/data\"}}\"#;\n";
+        ++n;
+    }
+    return out;
+}
+
+void report_tokens(const char* name, const bench::Measurement& m, size_t tokens) {
+    std::printf("%-40s %10.2f Mtok/s\n", name, static_cast<double>(tokens) / m.seconds_per_iter / 1e6);
+}
+
+// String literal contents: mostly plain text, one in eight with escapes.
+std::vector<std::string> make_string_literals(size_t count, size_t& total_bytes) {
+    std::vector<std::string> literals;
+    literals.reserve(count);
+    total_bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        std::string lit = "message " + std::to_string(i) + ": the quick brown fox jumps over the lazy dog";
+        if (i % 8 == 0) {
+            lit += "\\n\\t\\x41\\u{e9} and \\\"quoted\\\"";
+        }
+        total_bytes += lit.size();
+        literals.push_back(std::move(lit));
+    }
+    return literals;
+}
+
+using EscapeCallback = std::function<void(amyr::lexer::EscapeRange, const amyr::lexer::ResultEsc<amyr::lexer::MixedUnit>&)>;
+
+// Unescapes into a std::string one character at a time, through the callback `wrap` makes.
+template <typename Wrap>
+size_t unescape_per_char(const std::vector<std::string>& literals, Wrap wrap) {
+    using namespace amyr::lexer;
+    size_t total = 0;
+    std::string value;
+    auto append = [&](EscapeRange, const ResultEsc<MixedUnit>& res) {
+        char buf[4];
+        value.append(buf, res.unwrap().encode(buf));
+    };
+    auto callback = wrap(append);
+    for (const std::string& lit : literals) {
+        value.clear();
+        unescape_unicode(lit, Mode::Str, callback);
+        total += value.size();
+    }
+    return total;
+}
+
+// Tokens that aren't whitespace or comments, so both lexers count the same things.
+size_t count_significant(std::string_view src) {
+    using amyr::lexer::TokenKind;
+    size_t tokens = 0;
+    amyr::lexer::TokenIterator iter(src);
+    while (auto token = iter.next()) {
+        tokens += token->kind != TokenKind::Whitespace && token->kind != TokenKind::LineComment &&
+                  token->kind != TokenKind::BlockComment;
+    }
+    return tokens;
+}
+
+void report_suite_case(bench::Baseline& results, const std::string& name, const bench::Measurement& m, size_t tokens) {
+    const bench::Throughput t{m.bytes_per_sec / (1024.0 * 1024.0), static_cast<double>(tokens) / m.seconds_per_iter / 1e6};
+    std::printf("%-40s %10.2f MB/s %10.2f Mtok/s\n", name.c_str(), t.mb_per_s, t.mtok_per_s);
+    results[name] = t;
+}
+
+bench::Baseline run_suite() {
+    struct Corpus {
+        const char* name;
+        std::string text;
+        // The Tokenizer has no string literals, so it only runs where it can lex everything.
+        bool tokenizer;
+    };
+    constexpr size_t bytes = 8 * 1024 * 1024;
+    // Best of more runs than the comparisons use: the baseline check should not flap.
+    constexpr std::chrono::seconds min_time(2);
+    const Corpus corpora[] = {
+        {"identifiers", corpora::identifiers(bytes), true},
+        {"numbers", corpora::numbers(bytes), true},
+        {"comments", corpora::comments(bytes), true},
+        {"strings", corpora::strings(bytes), false},
+        {"unicode", corpora::unicode(bytes), true},
+    };
+
+    bench::Baseline results;
+    for (const Corpus& corpus : corpora) {
+        if (corpus.tokenizer) {
+            Tokenizer check(corpus.text);
+            const size_t tokens = check.tokenize().size() - 1;
+            if (!check.diagnostics().empty()) {
+                std::fprintf(stderr, "corpus %s has lex errors\n", corpus.name);
+                std::exit(2);
+            }
+            const bench::Measurement m = bench::measure(corpus.text.size(), [&] {
+                Tokenizer tokenizer(corpus.text);
+                bench::do_not_optimize(tokenizer.tokenize().size());
+            }, min_time);
+            report_suite_case(results, std::string("tokenize/") + corpus.name, m, tokens);
+        }
+
+        const size_t tokens = count_significant(corpus.text);
+        const bench::Measurement m = bench::measure(corpus.text.size(), [&] {
+            bench::do_not_optimize(count_significant(corpus.text));
+        }, min_time);
+        report_suite_case(results, std::string("token iterator/") + corpus.name, m, tokens);
+    }
+    return results;
+}
+
+// Prints the change against `baseline` per case. Returns the number of regressions.
+size_t compare_with_baseline(const bench::Baseline& results, const bench::Baseline& baseline, double tolerance) {
+    size_t regressions = 0;
+    std::printf("\n%-40s %10s %10s %8s\n", "vs baseline", "MB/s", "was", "change");
+    for (const auto& [name, now] : results) {
+        auto it = baseline.find(name);
+        if (it == baseline.end() || it->second.mb_per_s <= 0) {
+            std::printf("%-40s %10.2f %10s %8s\n", name.c_str(), now.mb_per_s, "-", "new");
+            continue;
+        }
+        const double change = (now.mb_per_s / it->second.mb_per_s - 1.0) * 100.0;
+        const bool regressed = change < -tolerance;
+        regressions += regressed;
+        std::printf("%-40s %10.2f %10.2f %+7.1f%%%s\n", name.c_str(), now.mb_per_s, it->second.mb_per_s, change,
+                    regressed ? "  REGRESSION" : "");
+    }
+    return regressions;
+}
+
+void run_comparisons() {
+    const std::string corpus = make_trivia_corpus(16 * 1024 * 1024);
+    std::printf("trivia corpus: %zu bytes\n", corpus.size());
+
+    bench::run("cursor/trivia/bytewise (before)", corpus.size(), [&] {
+        bench::do_not_optimize(skip_trivia_bytewise(corpus));
+    });
+
+    amyr::simd::set_level(amyr::simd::Level::Scalar);
+    bench::run("cursor/trivia/bulk scalar", corpus.size(), [&] {
+        bench::do_not_optimize(skip_trivia_bulk(corpus));
+    });
+
+    amyr::simd::set_level(amyr::simd::Level::SSE2);
+    bench::run("cursor/trivia/bulk sse2", corpus.size(), [&] {
+        bench::do_not_optimize(skip_trivia_bulk(corpus));
+    });
+
+    amyr::simd::set_level(amyr::simd::Level::AVX2);
+    bench::run("cursor/trivia/bulk avx2 (after)", corpus.size(), [&] {
+        bench::do_not_optimize(skip_trivia_bulk(corpus));
+    });
+
+    amyr::simd::set_level(amyr::simd::detect_level());
+
+    std::string word_storage;
+    const std::vector<std::string_view> words = make_identifier_words(word_storage, 1 << 20);
+    std::printf("identifier corpus: %zu words, %zu bytes\n", words.size(), word_storage.size());
+
+    bench::run("keywords/unordered_map (before)", word_storage.size(), [&] {
+        size_t hits = 0;
+        for (std::string_view word : words) {
+            hits += legacy_keywords.find(std::string(word)) != legacy_keywords.end();
+        }
+        bench::do_not_optimize(hits);
+    });
+
+    bench::run("keywords/perfect hash (after)", word_storage.size(), [&] {
+        size_t hits = 0;
+        for (std::string_view word : words) {
+            hits += amyr::lexer::lookup_keyword(word).is_keyword();
+        }
+        bench::do_not_optimize(hits);
+    });
+
+    const std::string source = make_source_corpus(16 * 1024 * 1024);
+    const size_t n_tokens = count_tokens(source, advance_table);
+    std::printf("source corpus: %zu bytes, %zu tokens\n", source.size(), n_tokens);
+
+    const bench::Measurement variant = bench::run("low lexer/switch+variant (before)", source.size(), [&] {
+        bench::do_not_optimize(count_tokens(source, advance_variant));
+    });
+    report_tokens("low lexer/switch+variant (before)", variant, n_tokens);
+
+    const bench::Measurement table = bench::run("low lexer/dispatch table (after)", source.size(), [&] {
+        bench::do_not_optimize(count_tokens(source, advance_table));
+    });
+    report_tokens("low lexer/dispatch table (after)", table, n_tokens);
+
+    // tokenize_parallel collects into a vector, so the sequential reference does too.
+    bench::run("low lexer/sequential collect", source.size(), [&] {
+        std::vector<amyr::lexer::Token> tokens;
+        amyr::lexer::TokenIterator iter(source);
+        while (auto token = iter.next()) {
+            tokens.push_back(*token);
+        }
+        bench::do_not_optimize(tokens.data());
+    });
+    const size_t hardware = std::max<size_t>(1, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= std::max<size_t>(8, hardware); threads *= 2) {
+        ThreadPool pool(threads);
+        const std::string name = "low lexer/tokenize_parallel " + std::to_string(threads) + " thread(s)";
+        bench::run(name, source.size(), [&] {
+            bench::do_not_optimize(amyr::lexer::tokenize_parallel(source, pool).data());
+        });
+    }
+
+    const std::string delimiters = make_delimiter_corpus(16 * 1024 * 1024);
+    std::printf("comment/raw string corpus: %zu bytes\n", delimiters.size());
+
+    bench::run("low lexer/stop at every delimiter (before)", delimiters.size(), [&] {
+        bench::do_not_optimize(count_tokens(delimiters, advance_variant));
+    });
+    bench::run("low lexer/two-byte delimiter search (after)", delimiters.size(), [&] {
+        bench::do_not_optimize(count_tokens(delimiters, advance_table));
+    });
+
+    amyr::simd::set_level(amyr::simd::Level::Scalar);
+    bench::run("line index/memchr per line (before)", source.size(), [&] {
+        bench::do_not_optimize(amyr::span::LineIndex(source).line_count());
+    });
+    amyr::simd::set_level(amyr::simd::detect_level());
+    bench::run("line index/vector newline mask (after)", source.size(), [&] {
+        bench::do_not_optimize(amyr::span::LineIndex(source).line_count());
+    });
+
+    size_t literal_bytes = 0;
+    const std::vector<std::string> literals = make_string_literals(1 << 18, literal_bytes);
+    std::printf("string literals: %zu, %zu bytes\n", literals.size(), literal_bytes);
+
+    bench::run("unescape/std::function per char (before)", literal_bytes, [&] {
+        bench::do_not_optimize(unescape_per_char(literals, [](auto& f) { return EscapeCallback(f); }));
+    });
+
+    bench::run("unescape/template callback per char", literal_bytes, [&] {
+        bench::do_not_optimize(unescape_per_char(literals, [](auto& f) { return f; }));
+    });
+
+    bench::run("unescape/arena, borrowed fast path (after)", literal_bytes, [&] {
+        DroplessArena arena;
+        size_t total = 0;
+        for (const std::string& lit : literals) {
+            total += amyr::lexer::unescape_into_arena(lit, amyr::lexer::Mode::Str, arena).unwrap().size();
+        }
+        bench::do_not_optimize(total);
+    });
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    bool suite_only = false;
+    const char* baseline_path = nullptr;
+    const char* save_path = nullptr;
+    double tolerance = 10.0;
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--suite") == 0) {
+            suite_only = true;
+        } else if (std::strcmp(argv[i], "--baseline") == 0 && has_value) {
+            baseline_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--save-baseline") == 0 && has_value) {
+            save_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && has_value) {
+            tolerance = std::atof(argv[++i]);
+        } else {
+            std::fprintf(stderr, "usage: %s [--suite] [--baseline FILE] [--save-baseline FILE] [--tolerance PCT]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (!suite_only) {
+        run_comparisons();
+        std::printf("\n");
+    }
+
+    const bench::Baseline results = run_suite();
+    if (save_path) {
+        bench::save_baseline(save_path, results);
+    }
+    if (baseline_path) {
+        const size_t regressions = compare_with_baseline(results, bench::load_baseline(baseline_path), tolerance);
+        if (regressions > 0) {
+            std::printf("%zu case(s) regressed by more than %.0f%%\n", regressions, tolerance);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,183 @@
+/*
+Parser benchmarks. Compares the two-pass pipeline (lex the whole file into a
+TokenStream, then parse it) with the fused ones, where the parser pulls
+tokens from a lexer as it goes, then borrow checks the parsed program as a
+pointer tree and as a FlatAst. The expression-heavy program compares the
+precedence-climbing parser with a cascade of one function per level, and
+the function-heavy one parsing bodies eagerly with reading signatures only
+and with parsing them on a thread pool.
+*/
+#include<cstdio>
+#include<memory>
+#include<string>
+#include<thread>
+#include<vector>
+
+#include "bench.hpp"
+#include "cascade_parser.hpp"
+#include "FlatAST.hpp"
+#include "parser.hpp"
+#include "amyr-utils/thread_pool.hpp"
+
+namespace {
+
+// Straight-line code: every statement uses the one before, with some comments in between.
+std::string make_program(size_t target_bytes) {
+    std::string out;
+    out.reserve(target_bytes + 256);
+    out += "let v0 = 1;\n";
+    size_t n = 1;
+    while (out.size() < target_bytes) {
+        const std::string prev = "v" + std::to_string(n - 1);
+        out += "let v" + std::to_string(n) + " = " + prev + " * 3 + (" + std::to_string(n % 97) + " - " + prev + ") / 2;";
+        out += n % 4 == 0 ? " // running total\n" : "\n";
+        ++n;
+    }
+    return out;
+}
+
+// Long initializers mixing every binary operator, mostly nested a few levels deep.
+std::string make_expression_program(size_t target_bytes) {
+    static const char* const shapes[] = {
+        "(a + 3) * b - a % 7 << 1 | 5 ^ b & 12",
+        "a * b + c / 3 - (a - c) * 2",
+        "a < b + 1 && b >= c || a == 7 * c",
+        "(a | b) & (c ^ 255) >> 2 + a % 5",
+        "a - b - c - 1 + a * b * c / 9",
+    };
+    std::string out;
+    out.reserve(target_bytes + 256);
+    out += "let v0 = 1;\nlet v1 = 2;\nlet v2 = 3;\n";
+    size_t n = 3;
+    while (out.size() < target_bytes) {
+        std::string expr = shapes[n % 5];
+        for (size_t at = 0; at < expr.size(); ++at) {
+            if (expr[at] >= 'a' && expr[at] <= 'c') {
+                const std::string var = "v" + std::to_string(n - 1 - (expr[at] - 'a'));
+                expr.replace(at, 1, var);
+                at += var.size() - 1;
+            }
+        }
+        out += "let v" + std::to_string(n) + " = " + expr + ";\n";
+        ++n;
+    }
+    return out;
+}
+
+// Functions of a few statements each, like most of a large build.
+std::string make_function_program(size_t target_bytes) {
+    std::string out;
+    out.reserve(target_bytes + 256);
+    size_t n = 0;
+    while (out.size() < target_bytes) {
+        out += "func f" + std::to_string(n) + "(a, b, c) {\n";
+        out += "    let x = a * 3 + (b - c) / 2;\n";
+        out += "    let y = x << 2 | a & 15 ^ b % 7;\n";
+        out += "    let z = (x + y) * (c - 1) - a / (b + 1);\n";
+        out += "    z - x + y >> 1 // result\n";
+        out += "}\n";
+        ++n;
+    }
+    return out;
+}
+
+size_t statement_count(const node::ParsedAst& ast) {
+    return static_cast<const node::BlockExprAST&>(*ast).getExpressions().size();
+}
+
+} // namespace
+
+int main() {
+    const std::string source = make_program(10 * 1024 * 1024);
+    std::printf("program: %zu bytes\n", source.size());
+
+    bench::run("parse/tokenize, then parse (before)", source.size(), [&] {
+        Tokenizer tokenizer(source);
+        node::Parser parser(tokenizer.tokenize());
+        bench::do_not_optimize(statement_count(parser.parse_program()));
+    });
+
+    bench::run("parse/fused, Tokenizer", source.size(), [&] {
+        node::Parser parser(std::make_unique<LexingTokenSource>(source));
+        bench::do_not_optimize(statement_count(parser.parse_program()));
+    });
+
+    bench::run("parse/fused, low lexer (after)", source.size(), [&] {
+        node::Parser parser(std::make_unique<LowLexerTokenSource>(source));
+        bench::do_not_optimize(statement_count(parser.parse_program()));
+    });
+
+    node::Parser parser(std::make_unique<LowLexerTokenSource>(source));
+    const node::ParsedAst program = parser.parse_program();
+    node::FlatAst flat;
+    const node::ExprId root = flat.add(program.get());
+    std::printf("flat tree: %zu nodes, %zu bytes each (BinaryExprAST is %zu)\n",
+                flat.size(), node::FlatAst::bytes_per_node(), sizeof(node::BinaryExprAST));
+
+    // Statements are all `let`s; the checker only looks into their initializers.
+    amyr::borrow::BorrowChecker checker;
+    bench::run("check/pointer tree", source.size(), [&] {
+        bool ok = true;
+        for (const node::ExprAST* statement : static_cast<const node::BlockExprAST&>(*program).getExpressions()) {
+            ok &= checker.check(static_cast<const node::LetExprAST*>(statement)->getInitExpr());
+        }
+        bench::do_not_optimize(ok);
+    });
+
+    bench::run("check/flat tree", source.size(), [&] {
+        bool ok = true;
+        for (node::ExprId statement : flat.items(root)) {
+            ok &= checker.check(flat, flat.init(statement));
+        }
+        bench::do_not_optimize(ok);
+    });
+
+    const std::string expressions = make_expression_program(10 * 1024 * 1024);
+    std::printf("expression program: %zu bytes\n", expressions.size());
+
+    bench::run("expr/one function per level (before)", expressions.size(), [&] {
+        cascade_parser::Parser cascade(std::make_unique<LowLexerTokenSource>(expressions));
+        bench::do_not_optimize(statement_count(cascade.parse_program()));
+    });
+
+    bench::run("expr/precedence climbing (after)", expressions.size(), [&] {
+        node::Parser climbing(std::make_unique<LowLexerTokenSource>(expressions));
+        bench::do_not_optimize(statement_count(climbing.parse_program()));
+    });
+
+    const std::string functions = make_function_program(10 * 1024 * 1024);
+    std::printf("function program: %zu bytes\n", functions.size());
+
+    bench::run("items/eager bodies (before)", functions.size(), [&] {
+        node::Parser parser(std::make_unique<LowLexerTokenSource>(functions));
+        bench::do_not_optimize(statement_count(parser.parse_program()));
+    });
+
+    bench::run("items/lazy, signatures only (after)", functions.size(), [&] {
+        node::Parser parser(std::make_unique<LowLexerTokenSource>(functions), node::FunctionBodies::Lazy);
+        bench::do_not_optimize(statement_count(parser.parse_program()));
+    });
+
+    bench::run("items/lazy, then every body", functions.size(), [&] {
+        node::Parser parser(std::make_unique<LowLexerTokenSource>(functions), node::FunctionBodies::Lazy);
+        const node::ParsedAst program = parser.parse_program();
+        for (const node::ExprAST* item : static_cast<const node::BlockExprAST&>(*program).getExpressions()) {
+            bench::do_not_optimize(static_cast<const node::FunctionAST*>(item)->getBody());
+        }
+    });
+
+    std::vector<size_t> pool_sizes{1};
+    if (std::thread::hardware_concurrency() > 1) {
+        pool_sizes.push_back(std::thread::hardware_concurrency());
+    }
+    for (size_t workers : pool_sizes) {
+        ThreadPool pool(workers);
+        const std::string name = "items/parallel bodies, " + std::to_string(workers) + " workers";
+        bench::run(name.c_str(), functions.size(), [&] {
+            node::Parser parser(std::make_unique<LowLexerTokenSource>(functions));
+            bench::do_not_optimize(statement_count(parser.parse_program(pool)));
+        });
+    }
+
+    return 0;
+}
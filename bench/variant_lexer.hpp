@@ -0,0 +1,339 @@
+/*
+The low-level lexer core as it was before the dispatch table: a `switch` on
+the first character building a `std::variant` TokenKind. Kept only so the
+benchmark can compare against it. Block comments and raw strings still stop
+at every `*`, `/` or `"`, as before the two-byte delimiter search; the other
+scanning helpers don't depend on the token representation, so they are
+shared with amyr::lexer.
+*/
+#pragma once
+
+#include<functional>
+#include<optional>
+#include<variant>
+
+#include "amyr-tokenizer/low_lexer.hpp"
+
+namespace variant_lexer {
+
+using amyr::lexer::Base;
+using amyr::lexer::DocStyle;
+using namespace amyr::lexer;
+
+namespace namespace_Literal {
+    struct Int { Base base; bool empty_int; };
+    struct Float { Base base; bool empty_exponent; };
+    struct Char { bool terminated; };
+    struct Byte { bool terminated; };
+    struct Str { bool terminated; };
+    struct ByteStr { bool terminated; };
+    struct CStr { bool terminated; };
+    struct RawStr { std::optional<unsigned short> n_hashes; };
+    struct RawByteStr { std::optional<unsigned short> n_hashes; };
+    struct RawCStr { std::optional<unsigned short> n_hashes; };
+}
+
+using LiteralKind = std::variant<
+    namespace_Literal::Int, namespace_Literal::Float, namespace_Literal::Char,
+    namespace_Literal::Byte, namespace_Literal::Str, namespace_Literal::ByteStr,
+    namespace_Literal::CStr, namespace_Literal::RawStr, namespace_Literal::RawByteStr,
+    namespace_Literal::RawCStr
+>;
+
+struct LineComment { std::optional<DocStyle> doc_style; };
+struct BlockComment { std::optional<DocStyle> doc_style; bool terminated; };
+struct Literal { LiteralKind kind; uint32_t suffix_start; };
+struct Lifetime { bool starts_with_number; };
+struct Whitespace {};
+struct Ident { amyr::span::Symbol keyword = amyr::span::kw::Empty; };
+struct InvalidIdent {};
+struct RawIdent {};
+struct UnknownPrefix {};
+struct UnknownPrefixLifetime {};
+struct RawLifetime {};
+struct GuardedStrPrefix {};
+struct Semi {}; struct Comma {}; struct Dot {}; struct OpenParen {}; struct CloseParen {};
+struct OpenBrace {}; struct CloseBrace {}; struct OpenBracket {}; struct CloseBracket {};
+struct At {}; struct Pound {}; struct Tilde {}; struct Question {}; struct Colon {};
+struct Dollar {}; struct Eq {}; struct Bang {}; struct Lt {}; struct Gt {}; struct Minus {};
+struct And {}; struct Or {}; struct Plus {}; struct Star {}; struct Slash {}; struct Caret {};
+struct Percent {}; struct Unknown {}; struct Eof {};
+
+using TokenKind = std::variant<
+    LineComment, BlockComment, Whitespace, Ident, InvalidIdent, RawIdent, UnknownPrefix,
+    UnknownPrefixLifetime, RawLifetime, GuardedStrPrefix, Literal, Lifetime, Semi, Comma,
+    Dot, OpenParen, CloseParen, OpenBrace, CloseBrace, OpenBracket, CloseBracket, At, Pound,
+    Tilde, Question, Colon, Dollar, Eq, Bang, Lt, Gt, Minus, And, Or, Plus, Star, Slash,
+    Caret, Percent, Unknown, Eof
+>;
+
+struct Token {
+    TokenKind kind;
+    unsigned int len;
+};
+
+inline TokenKind line_comment(Cursor &cursor) {
+    cursor.bump();
+    std::optional<DocStyle> doc_style;
+    const char next = cursor.first();
+    if (next == '!') {
+        doc_style = DocStyle::Inner;
+    } else if (next == '/' && cursor.second() != '/') {
+        doc_style = DocStyle::Outer;
+    }
+    cursor.eat_until('\n');
+    return LineComment{doc_style};
+}
+
+inline TokenKind block_comment(Cursor &cursor) {
+    cursor.bump();
+    std::optional<DocStyle> doc_style;
+    const char next = cursor.first();
+    if (next == '!') {
+        doc_style = DocStyle::Inner;
+    } else if (next == '*' && cursor.second() != '*' && cursor.second() != '/') {
+        doc_style = DocStyle::Outer;
+    }
+    size_t depth = 1;
+    while (true) {
+        cursor.eat_until_either('*', '/');
+        auto c = cursor.bump();
+        if (!c.has_value()) {
+            break;
+        }
+        if (c == '/' && cursor.first() == '*') {
+            cursor.bump();
+            depth++;
+        } else if (c == '*' && cursor.first() == '/') {
+            cursor.bump();
+            if (--depth == 0) {
+                return BlockComment{doc_style, true};
+            }
+        }
+    }
+    return BlockComment{doc_style, false};
+}
+
+// Raw string body, stopping at every quote. Returns the hash count if terminated.
+inline std::optional<unsigned short> raw_double_quoted_string(Cursor &cursor) {
+    unsigned short n_start_hashes = 0;
+    while (cursor.first() == '#') {
+        cursor.bump();
+        n_start_hashes++;
+    }
+    if (cursor.bump() != '"') {
+        return std::nullopt;
+    }
+    while (true) {
+        cursor.eat_until('"');
+        if (!cursor.bump().has_value()) {
+            return std::nullopt;
+        }
+        unsigned short n_end_hashes = 0;
+        while (cursor.first() == '#' && n_end_hashes < n_start_hashes) {
+            n_end_hashes++;
+            cursor.bump();
+        }
+        if (n_end_hashes == n_start_hashes) {
+            return n_start_hashes;
+        }
+    }
+}
+
+inline TokenKind ident_or_unknown_prefix(Cursor &cursor) {
+    cursor.eat_while(is_id_continue);
+    const char32_t c = cursor.first();
+    if (c == '#' || c == '\'' || c == '"') {
+        return UnknownPrefix{};
+    }
+    return Ident{lookup_keyword(cursor.token_text())};
+}
+
+inline TokenKind c_or_byte_string(
+    Cursor &cursor,
+    std::function<LiteralKind(bool)> mk_kind,
+    std::function<LiteralKind(std::optional<unsigned short>)> mk_kind_raw,
+    std::optional<std::function<LiteralKind(bool)>> single_quoted
+) {
+    const char next1 = cursor.first();
+    const char next2 = cursor.second();
+    if (next1 == '\'' && single_quoted.has_value()) {
+        cursor.bump();
+        bool terminated = single_quoted_string(cursor);
+        uint32_t suffix_start = cursor.pos_within_token();
+        if (terminated) {
+            eat_literal_suffix(cursor);
+        }
+        return Literal{single_quoted.value()(terminated), suffix_start};
+    } else if (next1 == '"') {
+        cursor.bump();
+        bool terminated = double_quoted_string(cursor);
+        uint32_t suffix_start = cursor.pos_within_token();
+        if (terminated) {
+            eat_literal_suffix(cursor);
+        }
+        return Literal{mk_kind(terminated), suffix_start};
+    } else if (next1 == 'r' && (next2 == '"' || next2 == '#')) {
+        cursor.bump();
+        auto res = raw_double_quoted_string(cursor);
+        uint32_t suffix_start = cursor.pos_within_token();
+        if (res.has_value()) {
+            eat_literal_suffix(cursor);
+        }
+        return Literal{mk_kind_raw(res), suffix_start};
+    }
+    return ident_or_unknown_prefix(cursor);
+}
+
+inline LiteralKind number(Cursor &cursor, char first_char) {
+    amyr::lexer::Token token = amyr::lexer::number(cursor, static_cast<char32_t>(first_char));
+    if (token.literal_kind == amyr::lexer::LiteralKind::Float) {
+        return namespace_Literal::Float{token.base(), token.empty_exponent()};
+    }
+    return namespace_Literal::Int{token.base(), token.empty_int()};
+}
+
+inline TokenKind lifetime_or_char(Cursor &cursor) {
+    amyr::lexer::Token token = amyr::lexer::lifetime_or_char(cursor);
+    switch (token.kind) {
+        case amyr::lexer::TokenKind::Literal:
+            return Literal{namespace_Literal::Char{token.terminated()}, token.suffix_start()};
+        case amyr::lexer::TokenKind::RawLifetime:
+            return RawLifetime{};
+        case amyr::lexer::TokenKind::UnknownPrefixLifetime:
+            return UnknownPrefixLifetime{};
+        default:
+            return Lifetime{token.starts_with_number()};
+    }
+}
+
+inline Token advance_token(Cursor &cursor) {
+    auto bump = cursor.bump();
+    if (!bump.has_value()) {
+        return Token{Eof{}, 0};
+    }
+
+    const char first_char = bump.value();
+    TokenKind kind;
+
+    switch (first_char) {
+        case '/': {
+            const char next_char = cursor.first();
+            if (next_char == '/') {
+                kind = line_comment(cursor);
+            } else if (next_char == '*') {
+                kind = block_comment(cursor);
+            } else {
+                kind = Slash{};
+            }
+            break;
+        }
+
+        case '\t': case '\n': case '\v': case '\f': case '\r': case ' ':
+            cursor.eat_ascii_whitespace();
+            cursor.eat_while(is_whitespace);
+            kind = Whitespace{};
+            break;
+
+        case 'r': {
+            const char next1 = cursor.first();
+            const char next2 = cursor.second();
+            if (next1 == '#' && is_id_start(next2)) {
+                cursor.bump();
+                eat_identifier(cursor);
+                kind = RawIdent{};
+            } else if (next1 == '#' || next1 == '"') {
+                auto res = raw_double_quoted_string(cursor);
+                const uint32_t suffix_start = cursor.pos_within_token();
+                if (res.has_value()) {
+                    eat_literal_suffix(cursor);
+                }
+                kind = Literal{namespace_Literal::RawStr{res}, suffix_start};
+            } else {
+                kind = ident_or_unknown_prefix(cursor);
+            }
+            break;
+        }
+
+        case 'b':
+            kind = c_or_byte_string(
+                cursor,
+                [] (bool t) -> LiteralKind { return namespace_Literal::ByteStr{t}; },
+                [] (std::optional<unsigned short> h) -> LiteralKind { return namespace_Literal::RawByteStr{h}; },
+                [] (bool t) -> LiteralKind { return namespace_Literal::Byte{t}; }
+            );
+            break;
+
+        case 'c':
+            kind = c_or_byte_string(
+                cursor,
+                [] (bool t) -> LiteralKind { return namespace_Literal::CStr{t}; },
+                [] (std::optional<unsigned short> h) -> LiteralKind { return namespace_Literal::RawCStr{h}; },
+                std::nullopt
+            );
+            break;
+
+        case '0'...'9': {
+            LiteralKind lit_kind = number(cursor, first_char);
+            const uint32_t suffix_start = cursor.pos_within_token();
+            eat_literal_suffix(cursor);
+            kind = Literal{lit_kind, suffix_start};
+            break;
+        }
+
+        case ';': kind = Semi{}; break;
+        case ',': kind = Comma{}; break;
+        case '.': kind = Dot{}; break;
+        case '(': kind = OpenParen{}; break;
+        case ')': kind = CloseParen{}; break;
+        case '{': kind = OpenBrace{}; break;
+        case '}': kind = CloseBrace{}; break;
+        case '[': kind = OpenBracket{}; break;
+        case ']': kind = CloseBracket{}; break;
+        case '@': kind = At{}; break;
+        case '#': kind = Pound{}; break;
+        case '~': kind = Tilde{}; break;
+        case '?': kind = Question{}; break;
+        case ':': kind = Colon{}; break;
+        case '$': kind = Dollar{}; break;
+        case '=': kind = Eq{}; break;
+        case '!': kind = Bang{}; break;
+        case '<': kind = Lt{}; break;
+        case '>': kind = Gt{}; break;
+        case '-': kind = Minus{}; break;
+        case '&': kind = And{}; break;
+        case '|': kind = Or{}; break;
+        case '+': kind = Plus{}; break;
+        case '*': kind = Star{}; break;
+        case '^': kind = Caret{}; break;
+        case '%': kind = Percent{}; break;
+
+        case '\'':
+            kind = lifetime_or_char(cursor);
+            break;
+
+        case '"': {
+            const bool terminated = double_quoted_string(cursor);
+            const uint32_t suffix_start = cursor.pos_within_token();
+            if (terminated) {
+                eat_literal_suffix(cursor);
+            }
+            kind = Literal{namespace_Literal::Str{terminated}, suffix_start};
+            break;
+        }
+
+        default:
+            if (is_id_start(static_cast<char32_t>(first_char))) {
+                kind = ident_or_unknown_prefix(cursor);
+            } else {
+                kind = Unknown{};
+            }
+            break;
+    }
+
+    Token res{kind, cursor.pos_within_token()};
+    cursor.reset_pos_within_token();
+    return res;
+}
+
+} // namespace variant_lexer
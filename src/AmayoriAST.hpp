@@ -1,225 +1,374 @@
-#pragma once
-#include <memory>
-#include <string_view>
-#include <vector>
-#include <stdexcept>
-#include <optional>
-
-namespace node {
-    // Forward declarations
-    class ASTVisitor;
-
-    // Borrow checking types
-    enum class BorrowKind {
-        None,
-        Shared,    // &
-        Mutable,   // &mut
-        Move       // ownership transfer
-    };
-
-    struct BorrowInfo {
-        BorrowKind kind = BorrowKind::None;
-        bool is_mutable = false;
-        std::string scope_id;
-    };
-
-    // Base Expression AST with Visitor support and borrow checking
-    class ExprAST {
-    protected:
-        BorrowInfo borrow_info;
-        bool has_error = false;
-        std::string error_message;
-
-    public:
-        virtual ~ExprAST() = default;
-
-        // Visitor pattern support
-        virtual void accept(ASTVisitor* visitor) = 0;
-
-        // Error handling
-        virtual bool hasError() const { return has_error; }
-        virtual std::string getErrorMessage() const { return error_message; }
-
-        // Borrow checking support
-        void setBorrowKind(BorrowKind kind) { borrow_info.kind = kind; }
-        void setMutable(bool is_mut) { borrow_info.is_mutable = is_mut; }
-        void setScopeId(const std::string& scope) { borrow_info.scope_id = scope; }
-
-        BorrowKind getBorrowKind() const { return borrow_info.kind; }
-        bool isMutable() const { return borrow_info.is_mutable; }
-        const std::string& getScopeId() const { return borrow_info.scope_id; }
-    };
-
-    // Integer Expression
-    class IntExprAST : public ExprAST {
-    private:
-        int val;
-
-    public:
-        explicit IntExprAST(int val) : val(val) {
-            setBorrowKind(BorrowKind::None); // Literals don't need borrowing
-        }
-
-        int getVal() const { return val; }
-
-        void accept(ASTVisitor* visitor) override;
-    };
-
-    // Variable Expression
-    class VariableExprAST : public ExprAST {
-    private:
-        std::string_view name;
-
-// Replacing std::string with std::string_view for identifiers, function names, and other string-based data to avoid unnecessary memory allocations and copying.
-    public:
-        explicit VariableExprAST(std::string_view name) : name(name) {
-            setBorrowKind(BorrowKind::Shared); // Default to shared borrow
-        }
-
-        const std::string_view& getName() const { return name; }
-        void accept(ASTVisitor* visitor) override;
-    };
-
-    // Let Expression for variable declarations
-    class LetExprAST : public ExprAST {
-    private:
-        std::string_view name;
-        bool is_mutable;
-        std::shared_ptr<ExprAST> init_expr;
-
-    public:
-        LetExprAST(std::string_view name, bool is_mut, ExprAST* init)
-            : name(name), is_mutable(is_mut), init_expr(init) {
-            setMutable(is_mut);
-            setBorrowKind(BorrowKind::None);
-        }
-
-        const std::string_view& getName() const { return name; }
-        bool isMutable() const { return is_mutable; }
-        const std::shared_ptr<ExprAST>& getInitExpr() const { return init_expr; }
-        void accept(ASTVisitor* visitor) override;
-    };
-
-    // Binary Operation Expression
-    class BinaryExprAST : public ExprAST {
-    private:
-        char op;
-        std::shared_ptr<ExprAST> lhs;
-        std::shared_ptr<ExprAST> rhs;
-
-    public:
-        BinaryExprAST(char op, ExprAST* lhs, ExprAST* rhs)
-            : op(op), lhs(lhs), rhs(rhs) {
-            setBorrowKind(BorrowKind::None);
-        }
-
-        char getOp() const { return op; }
-        const std::shared_ptr<ExprAST>& getLHS() const { return lhs; }
-        const std::shared_ptr<ExprAST>& getRHS() const { return rhs; }
-
-        void accept(ASTVisitor* visitor) override;
-    };
-
-    // Block Expression for scopes
-    class BlockExprAST : public ExprAST {
-    private:
-        std::vector<std::shared_ptr<ExprAST>> expressions;
-
-    public:
-        explicit BlockExprAST(std::vector<std::shared_ptr<ExprAST>> exprs)
-            : expressions(std::move(exprs)) {}
-
-        const std::vector<std::shared_ptr<ExprAST>>& getExpressions() const { return expressions; }
-
-        void accept(ASTVisitor* visitor) override;
-    };
-
-    // Function Call Expression
-    class FuncCallExprAST : public ExprAST {
-    private:
-        std::string_view callee;
-        std::vector<ExprAST*> args;
-
-    public:
-        FuncCallExprAST(std::string_view callee, std::vector<ExprAST*> args)
-            : callee(callee), args(std::move(args)) {
-            setBorrowKind(BorrowKind::None);
-        }
-
-        const std::string_view& getCallee() const { return callee; }
-        const std::vector<ExprAST*>& getArgs() const { return args; }
-
-        void accept(ASTVisitor* visitor) override;
-    };
-
-    // Function Prototype AST
-    class FuncPrototypeAST {
-    private:
-        std::string_view name;
-        std::vector<std::string> args;
-
-    public:
-        FuncPrototypeAST(std::string_view name, std::vector<std::string> args)
-            : name(name), args(std::move(args)) {}
-
-        const std::string_view& getName() const { return name; }
-        const std::vector<std::string>& getArgs() const { return args; }
-    };
-
-    // Function AST
-    class FunctionAST : public ExprAST {
-    private:
-        std::unique_ptr<FuncPrototypeAST> proto;
-        std::unique_ptr<ExprAST> body;
-
-    public:
-        FunctionAST(std::unique_ptr<FuncPrototypeAST> proto, std::unique_ptr<ExprAST> body)
-            : proto(std::move(proto)), body(std::move(body)) {}
-
-        const FuncPrototypeAST* getProto() const { return proto.get(); }
-        const ExprAST& getBody() const { return *body; }
-
-        void accept(ASTVisitor* visitor) override;
-    };
-
-    // Abstract Visitor for AST Traversal
-    class ASTVisitor {
-    public:
-        virtual void visitIntExpr(IntExprAST* node) = 0;
-        virtual void visitVariableExpr(VariableExprAST* node) = 0;
-        virtual void visitLetExpr(LetExprAST* node) = 0;
-        virtual void visitBinaryExpr(BinaryExprAST* node) = 0;
-        virtual void visitBlockExpr(BlockExprAST* node) = 0;
-        virtual void visitFuncCallExpr(FuncCallExprAST* node) = 0;
-        virtual ~ASTVisitor() = default;
-    };
-
-    // Visitor Method Implementations
-    inline void IntExprAST::accept(ASTVisitor* visitor) {
-        visitor->visitIntExpr(this);
-    }
-
-    inline void VariableExprAST::accept(ASTVisitor* visitor) {
-        visitor->visitVariableExpr(this);
-    }
-
-    inline void LetExprAST::accept(ASTVisitor* visitor) {
-        visitor->visitLetExpr(this);
-    }
-
-    inline void BinaryExprAST::accept(ASTVisitor* visitor) {
-        visitor->visitBinaryExpr(this);
-    }
-
-    inline void BlockExprAST::accept(ASTVisitor* visitor) {
-        visitor->visitBlockExpr(this);
-    }
-
-    inline void FuncCallExprAST::accept(ASTVisitor* visitor) {
-        visitor->visitFuncCallExpr(this);
-    }
-
-    inline void FunctionAST::accept(ASTVisitor* visitor) {
-        // Implement visitor logic for FunctionAST
-    }
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include <stdexcept>
+#include <optional>
+
+#include "amyr-ast/ast.hpp"
+#include "amyr-parser/arena.hpp"
+#include "amyr-span/symbol.hpp"
+
+/*
+AST nodes are allocated from an AstArena and point at each other with plain
+pointers. Nothing in the tree owns anything: the whole tree is freed at once
+when its arena is dropped, which a ParsedAst does for trees from the parser.
+*/
+
+namespace node {
+    // Forward declarations
+    class ASTVisitor;
+    class ExprAST;
+
+    // Binary operators are the ones of the full AST.
+    using BinOp = amyr::ast::BinOpKind::Kind;
+
+    // Child pointers copied into the arena, for nodes with any number of children.
+    class ExprList {
+    private:
+        ExprAST* const* items = nullptr;
+        size_t count = 0;
+
+    public:
+        ExprList() = default;
+        ExprList(ExprAST* const* items, size_t count) : items(items), count(count) {}
+
+        ExprAST* const* begin() const { return items; }
+        ExprAST* const* end() const { return items + count; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        ExprAST* operator[](size_t i) const { return items[i]; }
+    };
+
+    // Borrow checking types
+    enum class BorrowKind {
+        None,
+        Shared,    // &
+        Mutable,   // &mut
+        Move       // ownership transfer
+    };
+
+    struct BorrowInfo {
+        BorrowKind kind = BorrowKind::None;
+        bool is_mutable = false;
+        std::string scope_id;
+    };
+
+    // Base Expression AST with Visitor support and borrow checking
+    class ExprAST {
+    protected:
+        BorrowInfo borrow_info;
+        bool has_error = false;
+        std::string error_message;
+
+    public:
+        virtual ~ExprAST() = default;
+
+        // Visitor pattern support
+        virtual void accept(ASTVisitor* visitor) = 0;
+
+        // Error handling
+        virtual bool hasError() const { return has_error; }
+        virtual std::string getErrorMessage() const { return error_message; }
+
+        // Borrow checking support
+        void setBorrowKind(BorrowKind kind) { borrow_info.kind = kind; }
+        void setMutable(bool is_mut) { borrow_info.is_mutable = is_mut; }
+        void setScopeId(const std::string& scope) { borrow_info.scope_id = scope; }
+
+        BorrowKind getBorrowKind() const { return borrow_info.kind; }
+        bool isMutable() const { return borrow_info.is_mutable; }
+        const std::string& getScopeId() const { return borrow_info.scope_id; }
+    };
+
+    // Integer Expression
+    class IntExprAST : public ExprAST {
+    private:
+        int val;
+
+    public:
+        explicit IntExprAST(int val) : val(val) {
+            setBorrowKind(BorrowKind::None); // Literals don't need borrowing
+        }
+
+        int getVal() const { return val; }
+
+        void accept(ASTVisitor* visitor) override;
+    };
+
+    // Variable Expression
+    class VariableExprAST : public ExprAST {
+    private:
+        // Identifiers are interned, so comparing and hashing names is an integer op.
+        amyr::span::Symbol name;
+
+    public:
+        explicit VariableExprAST(amyr::span::Symbol name) : name(name) {
+            setBorrowKind(BorrowKind::Shared); // Default to shared borrow
+        }
+
+        amyr::span::Symbol getName() const { return name; }
+        void accept(ASTVisitor* visitor) override;
+    };
+
+    // Let Expression for variable declarations
+    class LetExprAST : public ExprAST {
+    private:
+        amyr::span::Symbol name;
+        bool is_mutable;
+        ExprAST* init_expr;
+
+    public:
+        LetExprAST(amyr::span::Symbol name, bool is_mut, ExprAST* init)
+            : name(name), is_mutable(is_mut), init_expr(init) {
+            setMutable(is_mut);
+            setBorrowKind(BorrowKind::None);
+        }
+
+        amyr::span::Symbol getName() const { return name; }
+        bool isMutable() const { return is_mutable; }
+        ExprAST* getInitExpr() const { return init_expr; }
+        void accept(ASTVisitor* visitor) override;
+    };
+
+    // Binary Operation Expression
+    class BinaryExprAST : public ExprAST {
+    private:
+        BinOp op;
+        ExprAST* lhs;
+        ExprAST* rhs;
+
+    public:
+        BinaryExprAST(BinOp op, ExprAST* lhs, ExprAST* rhs)
+            : op(op), lhs(lhs), rhs(rhs) {
+            setBorrowKind(BorrowKind::None);
+        }
+
+        BinOp getOp() const { return op; }
+        ExprAST* getLHS() const { return lhs; }
+        ExprAST* getRHS() const { return rhs; }
+
+        void accept(ASTVisitor* visitor) override;
+    };
+
+    // Block Expression for scopes
+    class BlockExprAST : public ExprAST {
+    private:
+        ExprList expressions;
+
+    public:
+        explicit BlockExprAST(ExprList exprs) : expressions(exprs) {}
+
+        ExprList getExpressions() const { return expressions; }
+
+        void accept(ASTVisitor* visitor) override;
+    };
+
+    // Function Call Expression
+    class FuncCallExprAST : public ExprAST {
+    private:
+        amyr::span::Symbol callee;
+        ExprList args;
+
+    public:
+        FuncCallExprAST(amyr::span::Symbol callee, ExprList args)
+            : callee(callee), args(args) {
+            setBorrowKind(BorrowKind::None);
+        }
+
+        amyr::span::Symbol getCallee() const { return callee; }
+        ExprList getArgs() const { return args; }
+
+        void accept(ASTVisitor* visitor) override;
+    };
+
+    // Function Prototype AST
+    class FuncPrototypeAST {
+    private:
+        amyr::span::Symbol name;
+        std::vector<std::string> args;
+
+    public:
+        FuncPrototypeAST(amyr::span::Symbol name, std::vector<std::string> args)
+            : name(name), args(std::move(args)) {}
+
+        amyr::span::Symbol getName() const { return name; }
+        const std::vector<std::string>& getArgs() const { return args; }
+    };
+
+    /*
+    A function body the parser skipped over. parse() builds it on first use;
+    the nodes it returns live as long as the LazyBody does.
+    */
+    class LazyBody {
+    public:
+        virtual ~LazyBody() = default;
+        virtual ExprAST* parse() = 0;
+    };
+
+    // Function AST
+    class FunctionAST : public ExprAST {
+    private:
+        FuncPrototypeAST* proto;
+        mutable ExprAST* body;
+        // Set until a skipped body has been parsed.
+        mutable LazyBody* lazy_body = nullptr;
+
+    public:
+        FunctionAST(FuncPrototypeAST* proto, ExprAST* body)
+            : proto(proto), body(body) {}
+
+        FunctionAST(FuncPrototypeAST* proto, LazyBody* lazy_body)
+            : proto(proto), body(nullptr), lazy_body(lazy_body) {}
+
+        const FuncPrototypeAST* getProto() const { return proto; }
+
+        /*
+        Parses a skipped body the first time it's asked for. Parse errors are
+        thrown from here. Not thread-safe: the body is built into the tree's
+        arena, which is shared with every other lazy body, so a tree whose
+        bodies may still be unparsed must stay on one thread. Trees from an
+        eager or a pooled parse have every body filled in and can be read
+        from anywhere.
+        */
+        ExprAST* getBody() const {
+            if (lazy_body) {
+                body = lazy_body->parse();
+                lazy_body = nullptr;
+            }
+            return body;
+        }
+
+        bool isBodyParsed() const { return lazy_body == nullptr; }
+
+        // Fills in a skipped body that was parsed elsewhere, like on a worker of a parallel parse.
+        void setBody(ExprAST* parsed) {
+            body = parsed;
+            lazy_body = nullptr;
+        }
+
+        void accept(ASTVisitor* visitor) override;
+    };
+
+    // Abstract Visitor for AST Traversal
+    class ASTVisitor {
+    public:
+        virtual void visitIntExpr(IntExprAST* node) = 0;
+        virtual void visitVariableExpr(VariableExprAST* node) = 0;
+        virtual void visitLetExpr(LetExprAST* node) = 0;
+        virtual void visitBinaryExpr(BinaryExprAST* node) = 0;
+        virtual void visitBlockExpr(BlockExprAST* node) = 0;
+        virtual void visitFuncCallExpr(FuncCallExprAST* node) = 0;
+        virtual ~ASTVisitor() = default;
+    };
+
+    // Visitor Method Implementations
+    inline void IntExprAST::accept(ASTVisitor* visitor) {
+        visitor->visitIntExpr(this);
+    }
+
+    inline void VariableExprAST::accept(ASTVisitor* visitor) {
+        visitor->visitVariableExpr(this);
+    }
+
+    inline void LetExprAST::accept(ASTVisitor* visitor) {
+        visitor->visitLetExpr(this);
+    }
+
+    inline void BinaryExprAST::accept(ASTVisitor* visitor) {
+        visitor->visitBinaryExpr(this);
+    }
+
+    inline void BlockExprAST::accept(ASTVisitor* visitor) {
+        visitor->visitBlockExpr(this);
+    }
+
+    inline void FuncCallExprAST::accept(ASTVisitor* visitor) {
+        visitor->visitFuncCallExpr(this);
+    }
+
+    inline void FunctionAST::accept(ASTVisitor* visitor) {
+        // Implement visitor logic for FunctionAST
+    }
+
+    /*
+    Owns every node of one or more trees. Each node type has its own
+    TypedArena, so nodes are packed back to back without a malloc header or
+    refcount, and their destructors still run when the arena goes away.
+    */
+    class AstArena {
+    private:
+        std::tuple<
+            TypedArena<IntExprAST>,
+            TypedArena<VariableExprAST>,
+            TypedArena<LetExprAST>,
+            TypedArena<BinaryExprAST>,
+            TypedArena<BlockExprAST>,
+            TypedArena<FuncCallExprAST>,
+            TypedArena<FuncPrototypeAST>,
+            TypedArena<FunctionAST>
+        > nodes;
+        // Child lists are plain pointers, which need no destructor.
+        DroplessArena lists;
+        // Skipped function bodies, with whatever they hold to be parsed later.
+        std::vector<std::unique_ptr<LazyBody>> lazy_bodies;
+        // Arenas holding nodes this tree points to, like bodies parsed on other threads.
+        std::vector<std::unique_ptr<AstArena>> adopted;
+
+    public:
+        AstArena() = default;
+        AstArena(const AstArena&) = delete;
+        AstArena& operator=(const AstArena&) = delete;
+
+        template <typename T, typename... Args>
+        T* make(Args&&... args) {
+            return std::get<TypedArena<T>>(nodes).allocate(std::forward<Args>(args)...);
+        }
+
+        // Takes over a skipped body for as long as the tree lives.
+        LazyBody* keep(std::unique_ptr<LazyBody> body) {
+            lazy_bodies.push_back(std::move(body));
+            return lazy_bodies.back().get();
+        }
+
+        // Keeps `other` and its nodes alive as long as this arena.
+        void adopt(std::unique_ptr<AstArena> other) {
+            adopted.push_back(std::move(other));
+        }
+
+        ExprList make_list(const std::vector<ExprAST*>& exprs) {
+            if (exprs.empty()) {
+                return ExprList();
+            }
+            auto* items = static_cast<ExprAST**>(lists.allocate(exprs.size() * sizeof(ExprAST*), alignof(ExprAST*)));
+            std::copy(exprs.begin(), exprs.end(), items);
+            return ExprList(items, exprs.size());
+        }
+    };
+
+    /*
+    A tree together with the arena it lives in. Pointers taken from it stay
+    valid as long as the handle does.
+    */
+    class ParsedAst {
+    private:
+        std::unique_ptr<AstArena> arena;
+        ExprAST* root = nullptr;
+
+    public:
+        ParsedAst() = default;
+        ParsedAst(std::unique_ptr<AstArena> arena, ExprAST* root)
+            : arena(std::move(arena)), root(root) {}
+
+        ExprAST* get() const { return root; }
+        ExprAST* operator->() const { return root; }
+        ExprAST& operator*() const { return *root; }
+        explicit operator bool() const { return root != nullptr; }
+
+        friend bool operator==(const ParsedAst& ast, std::nullptr_t) { return ast.root == nullptr; }
+        friend bool operator!=(const ParsedAst& ast, std::nullptr_t) { return ast.root != nullptr; }
+    };
 }
\ No newline at end of file
@@ -0,0 +1,260 @@
+#pragma once
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "./AmayoriAST.hpp"
+
+/*
+A flat, struct-of-arrays form of the expression tree.
+
+Nodes are numbered with u32 ids and stored column by column: a packed kind
+byte, one payload word and two operand words each. Children are always added
+before their parent, so a subtree is the contiguous id range
+[first(root), root] and passes that need every node of it become a forward
+(or backward) loop over a few arrays instead of a pointer chase.
+
+Per kind:
+
+    kind      data            a                   b
+    Int       value bits      -                   -
+    Variable  symbol          -                   -
+    Let       symbol          init                is_mutable
+    Binary    op              lhs                 rhs
+    Block     -               first in children   child count
+    FuncCall  callee symbol   first in children   argument count
+
+Borrow info and errors are rare, so they live in side tables keyed by id;
+nodes without an entry have the defaults the pointer tree gives them.
+*/
+
+namespace node {
+
+    using ExprId = uint32_t;
+
+    enum class ExprKind : uint8_t {
+        Int,
+        Variable,
+        Let,
+        Binary,
+        Block,
+        FuncCall
+    };
+
+    // Ids of a Block's expressions or a FuncCall's arguments.
+    class ExprIds {
+    private:
+        const ExprId* items;
+        size_t count;
+
+    public:
+        ExprIds(const ExprId* items, size_t count) : items(items), count(count) {}
+
+        const ExprId* begin() const { return items; }
+        const ExprId* end() const { return items + count; }
+        size_t size() const { return count; }
+        ExprId operator[](size_t i) const { return items[i]; }
+    };
+
+    class FlatAst {
+    private:
+        std::vector<ExprKind> kinds;
+        std::vector<uint32_t> data;
+        std::vector<uint32_t> a;
+        std::vector<uint32_t> b;
+        // Lowest id in each node's subtree.
+        std::vector<ExprId> firsts;
+        std::vector<ExprId> children;
+
+        std::unordered_map<ExprId, BorrowInfo> borrow_infos;
+        std::unordered_map<ExprId, std::string> errors;
+
+        ExprId push(ExprKind kind, uint32_t value, uint32_t x, uint32_t y, ExprId first) {
+            const ExprId id = static_cast<ExprId>(kinds.size());
+            kinds.push_back(kind);
+            data.push_back(value);
+            a.push_back(x);
+            b.push_back(y);
+            firsts.push_back(first);
+            return id;
+        }
+
+        ExprId push_list(ExprKind kind, uint32_t value, const std::vector<ExprId>& items) {
+            const ExprId next = static_cast<ExprId>(kinds.size());
+            const uint32_t at = static_cast<uint32_t>(children.size());
+            children.insert(children.end(), items.begin(), items.end());
+            return push(kind, value, at, static_cast<uint32_t>(items.size()), items.empty() ? next : firsts[items.front()]);
+        }
+
+    public:
+        ExprId add_int(int value) {
+            const ExprId id = static_cast<ExprId>(kinds.size());
+            return push(ExprKind::Int, static_cast<uint32_t>(value), 0, 0, id);
+        }
+
+        ExprId add_variable(amyr::span::Symbol name) {
+            const ExprId id = static_cast<ExprId>(kinds.size());
+            return push(ExprKind::Variable, name.as_u32(), 0, 0, id);
+        }
+
+        ExprId add_let(amyr::span::Symbol name, bool is_mut, ExprId init) {
+            return push(ExprKind::Let, name.as_u32(), init, is_mut, firsts[init]);
+        }
+
+        ExprId add_binary(BinOp op, ExprId lhs, ExprId rhs) {
+            return push(ExprKind::Binary, static_cast<uint32_t>(op), lhs, rhs, firsts[lhs]);
+        }
+
+        // The items must have been added in order, like every other child.
+        ExprId add_block(const std::vector<ExprId>& exprs) {
+            return push_list(ExprKind::Block, 0, exprs);
+        }
+
+        ExprId add_call(amyr::span::Symbol callee, const std::vector<ExprId>& args) {
+            return push_list(ExprKind::FuncCall, callee.as_u32(), args);
+        }
+
+        /*
+        Copies a pointer tree in, children first. Returns the id of its root.
+        The walk keeps its own stacks, so trees of any depth can be copied:
+        a node with children queues a step that adds it once their ids are
+        on `ids`, queues all but its first child, and goes on into that one.
+        */
+        ExprId add(const ExprAST* root) {
+            struct Step {
+                const ExprAST* expr;
+                ExprKind kind;
+                bool finish;
+            };
+            std::vector<Step> work;
+            std::vector<ExprId> ids;
+            auto pop_id = [&ids] {
+                const ExprId id = ids.back();
+                ids.pop_back();
+                return id;
+            };
+            // The last `n` ids, in order, removed from `ids`.
+            auto pop_ids = [&ids](size_t n) {
+                std::vector<ExprId> items(ids.end() - n, ids.end());
+                ids.resize(ids.size() - n);
+                return items;
+            };
+            // Queues the finishing step and children[1..], returns children[0].
+            auto open = [&work](ExprKind kind, const ExprAST* expr, ExprList children) -> const ExprAST* {
+                work.push_back({expr, kind, true});
+                for (size_t i = children.size(); i-- > 1;) {
+                    work.push_back({children[i], ExprKind::Int, false});
+                }
+                return children.size() != 0 ? children[0] : nullptr;
+            };
+
+            const ExprAST* expr = root;
+            for (;;) {
+                // Go down first children until a leaf or an empty list.
+                while (expr) {
+                    if (auto* int_expr = dynamic_cast<const IntExprAST*>(expr)) {
+                        ids.push_back(add_int(int_expr->getVal()));
+                        expr = nullptr;
+                    } else if (auto* var = dynamic_cast<const VariableExprAST*>(expr)) {
+                        ids.push_back(add_variable(var->getName()));
+                        expr = nullptr;
+                    } else if (auto* let = dynamic_cast<const LetExprAST*>(expr)) {
+                        work.push_back({expr, ExprKind::Let, true});
+                        expr = let->getInitExpr();
+                    } else if (auto* binary = dynamic_cast<const BinaryExprAST*>(expr)) {
+                        work.push_back({expr, ExprKind::Binary, true});
+                        work.push_back({binary->getRHS(), ExprKind::Int, false});
+                        expr = binary->getLHS();
+                    } else if (auto* block = dynamic_cast<const BlockExprAST*>(expr)) {
+                        expr = open(ExprKind::Block, expr, block->getExpressions());
+                    } else if (auto* call = dynamic_cast<const FuncCallExprAST*>(expr)) {
+                        expr = open(ExprKind::FuncCall, expr, call->getArgs());
+                    } else {
+                        throw std::runtime_error("Expression has no flat form.");
+                    }
+                }
+
+                if (work.empty()) {
+                    return ids.back();
+                }
+                const Step step = work.back();
+                work.pop_back();
+                if (!step.finish) {
+                    expr = step.expr;
+                    continue;
+                }
+                switch (step.kind) {
+                    case ExprKind::Let: {
+                        auto* let = static_cast<const LetExprAST*>(step.expr);
+                        ids.push_back(add_let(let->getName(), let->isMutable(), pop_id()));
+                        break;
+                    }
+                    case ExprKind::Binary: {
+                        const ExprId rhs = pop_id();
+                        const ExprId lhs = pop_id();
+                        ids.push_back(add_binary(static_cast<const BinaryExprAST*>(step.expr)->getOp(), lhs, rhs));
+                        break;
+                    }
+                    case ExprKind::Block:
+                        ids.push_back(add_block(pop_ids(static_cast<const BlockExprAST*>(step.expr)->getExpressions().size())));
+                        break;
+                    case ExprKind::FuncCall: {
+                        auto* call = static_cast<const FuncCallExprAST*>(step.expr);
+                        ids.push_back(add_call(call->getCallee(), pop_ids(call->getArgs().size())));
+                        break;
+                    }
+                    default:
+                        break;
+                }
+            }
+        }
+
+        size_t size() const { return kinds.size(); }
+
+        // Array bytes per node, not counting the side tables or the shared child list.
+        static constexpr size_t bytes_per_node() {
+            return sizeof(ExprKind) + 4 * sizeof(uint32_t);
+        }
+
+        ExprKind kind(ExprId id) const { return kinds[id]; }
+        ExprId first(ExprId id) const { return firsts[id]; }
+
+        int int_value(ExprId id) const { return static_cast<int>(data[id]); }
+        // Name of a Variable or Let, callee of a FuncCall.
+        amyr::span::Symbol symbol(ExprId id) const { return amyr::span::Symbol(data[id]); }
+
+        BinOp op(ExprId id) const { return static_cast<BinOp>(data[id]); }
+        ExprId lhs(ExprId id) const { return a[id]; }
+        ExprId rhs(ExprId id) const { return b[id]; }
+
+        ExprId init(ExprId id) const { return a[id]; }
+        bool is_mutable(ExprId id) const { return b[id] != 0; }
+
+        // Expressions of a Block, arguments of a FuncCall.
+        ExprIds items(ExprId id) const { return ExprIds(children.data() + a[id], b[id]); }
+
+        // Side tables
+        void set_borrow_info(ExprId id, BorrowInfo info) { borrow_infos[id] = std::move(info); }
+
+        BorrowKind borrow_kind(ExprId id) const {
+            auto it = borrow_infos.find(id);
+            if (it != borrow_infos.end()) {
+                return it->second.kind;
+            }
+            // Same defaults as the node constructors.
+            return kinds[id] == ExprKind::Variable ? BorrowKind::Shared : BorrowKind::None;
+        }
+
+        void set_error(ExprId id, std::string message) { errors[id] = std::move(message); }
+
+        bool has_error(ExprId id) const { return errors.count(id) != 0; }
+
+        std::string error_message(ExprId id) const {
+            auto it = errors.find(id);
+            return it != errors.end() ? it->second : std::string();
+        }
+    };
+}
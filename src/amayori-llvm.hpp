@@ -3,12 +3,15 @@
 #include <iostream>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Verifier.h"
 #include "./AmayoriAST.hpp"
+#include "./FlatAST.hpp"
 
 using namespace llvm;
 
@@ -17,43 +20,192 @@ private:
     std::unique_ptr<LLVMContext> TheContext;
     std::unique_ptr<Module> TheModule;
     std::unique_ptr<IRBuilder<>> Builder;
+    // Values bound by `let`, looked up by the variables that read them.
+    std::unordered_map<amyr::span::Symbol, Value*> NamedValues;
+    // Scratch stacks for generateIR, kept to avoid two allocations per call.
+    struct Step {
+        node::ExprAST* Expr;
+        node::ExprKind Kind;
+        bool Finish;
+    };
+    std::vector<Step> WorkStack;
+    std::vector<Value*> ValueStack;
 
 public:
     IRGenerator() : TheContext(std::make_unique<LLVMContext>()),
                     TheModule(std::make_unique<Module>("MyLLVMModule", *TheContext)),
                     Builder(std::make_unique<IRBuilder<>>(*TheContext)) {}
 
+    /*
+    Post-order walk with explicit stacks, so deeply nested expressions don't
+    overflow the native one. Like FlatAst::add, it goes down first children
+    directly and queues a finishing step, tagged with the node's kind, that
+    combines the children's values once they are on ValueStack. A `let`
+    yields its initializer and a block its last expression.
+    */
     Value* generateIR(node::ExprAST* Expr) {
-    if (auto* IntExpr = dynamic_cast<node::IntExprAST*>(Expr)) {
-        return ConstantInt::get(*TheContext, APInt(32, IntExpr->getVal(), true));
+        WorkStack.clear();
+        ValueStack.clear();
+        for (;;) {
+            // Go down first children until a leaf or an empty block.
+            while (Expr) {
+                if (auto* IntExpr = dynamic_cast<node::IntExprAST*>(Expr)) {
+                    ValueStack.push_back(ConstantInt::get(*TheContext, APInt(32, IntExpr->getVal(), true)));
+                    Expr = nullptr;
+                } else if (auto* BinaryExpr = dynamic_cast<node::BinaryExprAST*>(Expr)) {
+                    WorkStack.push_back({Expr, node::ExprKind::Binary, true});
+                    WorkStack.push_back({BinaryExpr->getRHS(), node::ExprKind::Int, false});
+                    Expr = BinaryExpr->getLHS();
+                } else if (auto* VarExpr = dynamic_cast<node::VariableExprAST*>(Expr)) {
+                    auto It = NamedValues.find(VarExpr->getName());
+                    ValueStack.push_back(It != NamedValues.end() ? It->second : nullptr);
+                    Expr = nullptr;
+                } else if (auto* LetExpr = dynamic_cast<node::LetExprAST*>(Expr)) {
+                    WorkStack.push_back({Expr, node::ExprKind::Let, true});
+                    Expr = LetExpr->getInitExpr();
+                } else if (auto* BlockExpr = dynamic_cast<node::BlockExprAST*>(Expr)) {
+                    const node::ExprList Exprs = BlockExpr->getExpressions();
+                    WorkStack.push_back({Expr, node::ExprKind::Block, true});
+                    for (size_t I = Exprs.size(); I-- > 1;) {
+                        WorkStack.push_back({Exprs[I], node::ExprKind::Int, false});
+                    }
+                    Expr = Exprs.empty() ? nullptr : Exprs[0];
+                } else {
+                    // Handle other expression types as needed
+                    ValueStack.push_back(nullptr);
+                    Expr = nullptr;
+                }
+            }
+
+            if (WorkStack.empty()) {
+                return ValueStack.back();
+            }
+            const Step S = WorkStack.back();
+            WorkStack.pop_back();
+            if (!S.Finish) {
+                Expr = S.Expr;
+                continue;
+            }
+            switch (S.Kind) {
+                case node::ExprKind::Binary: {
+                    Value* R = ValueStack.back();
+                    ValueStack.pop_back();
+                    Value* L = ValueStack.back();
+                    ValueStack.pop_back();
+                    auto* BinaryExpr = static_cast<node::BinaryExprAST*>(S.Expr);
+                    ValueStack.push_back(L && R ? generateBinary(BinaryExpr->getOp(), L, R) : nullptr);
+                    break;
+                }
+                case node::ExprKind::Let:
+                    NamedValues[static_cast<node::LetExprAST*>(S.Expr)->getName()] = ValueStack.back();
+                    break;
+                case node::ExprKind::Block: {
+                    const size_t Count = static_cast<node::BlockExprAST*>(S.Expr)->getExpressions().size();
+                    Value* Last = Count == 0 ? nullptr : ValueStack.back();
+                    ValueStack.resize(ValueStack.size() - Count);
+                    ValueStack.push_back(Last);
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
     }
-    if (node::BinaryExprAST* BinaryExpr = dynamic_cast<node::BinaryExprAST*>(Expr)) {
-        Value* L = generateIR(&BinaryExpr->getLHS());
-        Value* R = generateIR(&BinaryExpr->getRHS());
-        if (!L || !R) return nullptr;
-
-        switch (BinaryExpr->getOp()) {
-            case '+': return Builder->CreateAdd(L, R, "addtmp");
-            case '-': return Builder->CreateSub(L, R, "subtmp");
-            case '*': return Builder->CreateMul(L, R, "multmp");
-            case '/': return Builder->CreateSDiv(L, R, "divtmp");
-            default: return nullptr;
+
+    /*
+    Children come before parents in a FlatAst, so one forward pass over the
+    subtree has every child's value ready at its parent, and a `let` is
+    reached before the variables after it. Nodes the pointer walk skips can
+    only fold constants, so visiting them emits nothing.
+    */
+    Value* generateIR(const node::FlatAst& Ast, node::ExprId Root) {
+        const node::ExprId First = Ast.first(Root);
+        std::vector<Value*> Values(Root - First + 1, nullptr);
+        for (node::ExprId Id = First; Id <= Root; ++Id) {
+            switch (Ast.kind(Id)) {
+                case node::ExprKind::Int:
+                    Values[Id - First] = ConstantInt::get(*TheContext, APInt(32, Ast.int_value(Id), true));
+                    break;
+                case node::ExprKind::Binary: {
+                    Value* L = Values[Ast.lhs(Id) - First];
+                    Value* R = Values[Ast.rhs(Id) - First];
+                    if (L && R) {
+                        Values[Id - First] = generateBinary(Ast.op(Id), L, R);
+                    }
+                    break;
+                }
+                case node::ExprKind::Let:
+                    Values[Id - First] = Values[Ast.init(Id) - First];
+                    NamedValues[Ast.symbol(Id)] = Values[Id - First];
+                    break;
+                case node::ExprKind::Variable: {
+                    auto It = NamedValues.find(Ast.symbol(Id));
+                    Values[Id - First] = It != NamedValues.end() ? It->second : nullptr;
+                    break;
+                }
+                case node::ExprKind::Block: {
+                    const node::ExprIds Items = Ast.items(Id);
+                    if (Items.size() != 0) {
+                        Values[Id - First] = Values[Items[Items.size() - 1] - First];
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
         }
+        return Values[Root - First];
+    }
+
+    /*
+    Every value is an i32, so comparisons and `&&`/`||` widen their i1
+    result back to i32. Operands can't have side effects yet, so evaluating
+    both sides of `&&` and `||` gives the same result as short-circuiting.
+    */
+    Value* generateBinary(node::BinOp Op, Value* L, Value* R) {
+        using node::BinOp;
+        switch (Op) {
+            case BinOp::Add: return Builder->CreateAdd(L, R, "addtmp");
+            case BinOp::Sub: return Builder->CreateSub(L, R, "subtmp");
+            case BinOp::Mul: return Builder->CreateMul(L, R, "multmp");
+            case BinOp::Div: return Builder->CreateSDiv(L, R, "divtmp");
+            case BinOp::Rem: return Builder->CreateSRem(L, R, "remtmp");
+            case BinOp::BitAnd: return Builder->CreateAnd(L, R, "andtmp");
+            case BinOp::BitOr: return Builder->CreateOr(L, R, "ortmp");
+            case BinOp::BitXor: return Builder->CreateXor(L, R, "xortmp");
+            case BinOp::Shl: return Builder->CreateShl(L, R, "shltmp");
+            case BinOp::Shr: return Builder->CreateAShr(L, R, "shrtmp");
+            case BinOp::Eq: return widen(Builder->CreateICmpEQ(L, R, "eqtmp"));
+            case BinOp::Ne: return widen(Builder->CreateICmpNE(L, R, "netmp"));
+            case BinOp::Lt: return widen(Builder->CreateICmpSLT(L, R, "lttmp"));
+            case BinOp::Le: return widen(Builder->CreateICmpSLE(L, R, "letmp"));
+            case BinOp::Gt: return widen(Builder->CreateICmpSGT(L, R, "gttmp"));
+            case BinOp::Ge: return widen(Builder->CreateICmpSGE(L, R, "getmp"));
+            case BinOp::And: return widen(Builder->CreateAnd(truthy(L), truthy(R), "landtmp"));
+            case BinOp::Or: return widen(Builder->CreateOr(truthy(L), truthy(R), "lortmp"));
+        }
+        return nullptr;
+    }
+
+    Value* truthy(Value* V) {
+        return Builder->CreateICmpNE(V, ConstantInt::get(*TheContext, APInt(32, 0, true)), "booltmp");
+    }
+
+    Value* widen(Value* Bit) {
+        return Builder->CreateZExt(Bit, Type::getInt32Ty(*TheContext), "widetmp");
     }
-    // Handle other expression types as needed
-    return nullptr;
-}
 
     Function* generateFunctionIR(node::FunctionAST* FnAST) {
         std::vector<Type*> Ints(FnAST->getProto()->getArgs().size(), Type::getInt32Ty(*TheContext));
         FunctionType* FT = FunctionType::get(Type::getInt32Ty(*TheContext), Ints, false);
-        Function* F = Function::Create(FT, Function::ExternalLinkage, FnAST->getProto()->getName(), TheModule.get());
+        const std::string_view name = FnAST->getProto()->getName().as_str();
+        Function* F = Function::Create(FT, Function::ExternalLinkage, StringRef(name.data(), name.size()), TheModule.get());
 
         BasicBlock* BB = BasicBlock::Create(*TheContext, "entry", F);
         Builder->SetInsertPoint(BB);
 
         // Generate IR for function body
-        if (Value* RetVal = generateIR(&FnAST->getBody())) {
+        if (Value* RetVal = generateIR(FnAST->getBody())) {
             Builder->CreateRet(RetVal);
             verifyFunction(*F);
             return F;
@@ -74,22 +226,25 @@ int main() {
 
     IRGenerator IRGen;
 
+    // All nodes live in the arena and are freed with it
+    node::AstArena arena;
+
     // Create AST nodes for the integers 10 and 20
-    auto LHS = std::make_unique<node::IntExprAST>(10);
-    auto RHS = std::make_unique<node::IntExprAST>(20);
+    auto* LHS = arena.make<node::IntExprAST>(10);
+    auto* RHS = arena.make<node::IntExprAST>(20);
 
     // Create a binary expression AST node for addition
-    auto BinaryExpr = std::make_unique<node::BinaryExprAST>('+', std::move(LHS), std::move(RHS));
+    auto* BinaryExpr = arena.make<node::BinaryExprAST>(node::BinOp::Add, LHS, RHS);
 
     // Create a function prototype (no arguments in this case)
     std::vector<std::string> Args = {"int a"};
-    auto Proto = std::make_unique<node::FuncPrototypeAST>("add_example", std::move(Args));
+    auto* Proto = arena.make<node::FuncPrototypeAST>(amyr::span::Symbol::intern("add_example"), std::move(Args));
 
     // Create the function AST node
-    auto FnAST = std::make_unique<node::FunctionAST>(std::move(Proto), std::move(BinaryExpr));
+    auto* FnAST = arena.make<node::FunctionAST>(Proto, BinaryExpr);
 
     // Generate IR for the function
-    IRGen.generateFunctionIR(FnAST.get()); 
+    IRGen.generateFunctionIR(FnAST);
 
     std::cout << "Generated LLVM IR:" << std::endl;
     IRGen.dumpModule();
@@ -0,0 +1,208 @@
+#pragma once
+
+/*
+Owning pointers and child lists for the AST, backed by an arena.
+
+`P<T>` is the single owner of a node, like Rust's `P<T>`: it moves but never
+copies, so every node has exactly one parent and nothing needs a refcount.
+`Slice<T>` is a fixed run of children, allocated in one piece instead of a
+vector of separately allocated pointers.
+
+Neither frees anything itself. Their memory comes from an `Arena`, which
+runs the destructors and releases every chunk at once when it is dropped,
+so a tree must not outlive the arena it was built in.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../amyr-parser/arena.hpp"
+
+namespace amyr {
+namespace ast {
+
+template <typename T>
+class P {
+public:
+    P() = default;
+    P(std::nullptr_t) {}
+
+    P(const P&) = delete;
+    P& operator=(const P&) = delete;
+
+    P(P&& other) noexcept : ptr(other.ptr) { other.ptr = nullptr; }
+
+    P& operator=(P&& other) noexcept {
+        ptr = other.ptr;
+        other.ptr = nullptr;
+        return *this;
+    }
+
+    // A P<Derived> hands its node over to a P<Base>.
+    template <typename U, typename = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+    P(P<U>&& other) noexcept : ptr(other.release()) {}
+
+    T* get() const { return ptr; }
+    T& operator*() const { return *ptr; }
+    T* operator->() const { return ptr; }
+    explicit operator bool() const { return ptr != nullptr; }
+
+    // Gives up ownership without destroying anything; the arena still does that.
+    T* release() {
+        T* out = ptr;
+        ptr = nullptr;
+        return out;
+    }
+
+    friend bool operator==(const P& p, std::nullptr_t) { return p.ptr == nullptr; }
+    friend bool operator!=(const P& p, std::nullptr_t) { return p.ptr != nullptr; }
+
+private:
+    friend class Arena;
+
+    explicit P(T* ptr) : ptr(ptr) {}
+
+    T* ptr = nullptr;
+};
+
+template <typename T>
+class Slice {
+public:
+    Slice() = default;
+
+    Slice(const Slice&) = delete;
+    Slice& operator=(const Slice&) = delete;
+
+    Slice(Slice&& other) noexcept : items(other.items), count(other.count) {
+        other.items = nullptr;
+        other.count = 0;
+    }
+
+    Slice& operator=(Slice&& other) noexcept {
+        items = other.items;
+        count = other.count;
+        other.items = nullptr;
+        other.count = 0;
+        return *this;
+    }
+
+    T* begin() { return items; }
+    T* end() { return items + count; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T& operator[](size_t i) { return items[i]; }
+    const T& operator[](size_t i) const { return items[i]; }
+
+    T& front() { return items[0]; }
+    const T& front() const { return items[0]; }
+    T& back() { return items[count - 1]; }
+    const T& back() const { return items[count - 1]; }
+
+private:
+    friend class Arena;
+
+    Slice(T* items, size_t count) : items(items), count(count) {}
+
+    T* items = nullptr;
+    size_t count = 0;
+};
+
+/*
+Memory for one AST. Types with a trivial destructor are bump allocated
+together from a DroplessArena. Every other type gets a TypedArena of its
+own, created on first use, which keeps its objects side by side and
+destroys them when the arena goes away, without a record per object.
+*/
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    template <typename T, typename... Args>
+    P<T> alloc(Args&&... args) {
+        if constexpr (std::is_trivially_destructible_v<T>) {
+            return P<T>(new (memory.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...));
+        } else {
+            return P<T>(typed<T>().allocate(std::forward<Args>(args)...));
+        }
+    }
+
+    // Moves `items` into one arena allocation.
+    template <typename T>
+    Slice<T> alloc_slice(std::vector<T>&& items) {
+        const size_t n = items.size();
+        if (n == 0) {
+            return Slice<T>();
+        }
+        T* out;
+        if constexpr (std::is_trivially_destructible_v<T>) {
+            out = static_cast<T*>(memory.allocate(sizeof(T) * n, alignof(T)));
+            for (size_t i = 0; i < n; ++i) {
+                new (out + i) T(std::move(items[i]));
+            }
+        } else {
+            out = typed<T>().allocate_from(std::move(items));
+        }
+        return Slice<T>(out, n);
+    }
+
+    // Bytes taken from the system for nodes and slices.
+    size_t allocated_bytes() const {
+        size_t total = memory.allocated_bytes();
+        for (const auto& arena : typed_arenas) {
+            if (arena) {
+                total += arena->allocated_bytes();
+            }
+        }
+        return total;
+    }
+
+private:
+    struct AnyTypedArena {
+        virtual ~AnyTypedArena() = default;
+        virtual size_t allocated_bytes() const = 0;
+    };
+
+    template <typename T>
+    struct OneTypedArena : AnyTypedArena {
+        TypedArena<T> arena;
+        size_t allocated_bytes() const override { return arena.allocated_bytes(); }
+    };
+
+    // Each type gets a fixed slot in `typed_arenas`, the same in every Arena.
+    static inline std::atomic<size_t> next_slot{0};
+
+    template <typename T>
+    static size_t slot() {
+        static const size_t slot = next_slot++;
+        return slot;
+    }
+
+    template <typename T>
+    TypedArena<T>& typed() {
+        const size_t i = slot<T>();
+        if (i >= typed_arenas.size()) {
+            typed_arenas.resize(i + 1);
+        }
+        if (!typed_arenas[i]) {
+            typed_arenas[i] = std::make_unique<OneTypedArena<T>>();
+        }
+        return static_cast<OneTypedArena<T>&>(*typed_arenas[i]).arena;
+    }
+
+    DroplessArena memory;
+    std::vector<std::unique_ptr<AnyTypedArena>> typed_arenas;
+};
+
+} // namespace ast
+} // namespace amyr
@@ -4,7 +4,10 @@
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
-#include "../parser.hpp"
+#include "../AmayoriAST.hpp"
+#include "../FlatAST.hpp"
+#include "../amyr-span/source_map.hpp"
+#include "../amyr-span/symbol.hpp"
 
 namespace amyr {
 namespace borrow {
@@ -21,29 +24,29 @@ enum class ViolationType {
     InvalidBorrow
 };
 
+// Positions are SourceMap offsets; line and column are only resolved when the violation is reported.
 struct Violation {
     ViolationType type;
     std::string message;
-    int line;
+    amyr::span::BytePos pos;
 
-    Violation(ViolationType t, std::string msg, int ln)
-        : type(t), message(std::move(msg)), line(ln) {}
+    Violation(ViolationType t, std::string msg, amyr::span::BytePos p)
+        : type(t), message(std::move(msg)), pos(p) {}
 };
 
 struct Location {
-    int line;
-    int column;
+    amyr::span::BytePos pos;
 
-    Location(int l, int c) : line(l), column(c) {}
+    explicit Location(amyr::span::BytePos p) : pos(p) {}
 
     bool operator==(const Location& other) const {
-        return line == other.line && column == other.column;
+        return pos == other.pos;
     }
 };
 
 struct LocationHash {
     std::size_t operator()(const Location& loc) const {
-        return std::hash<int>()(loc.line) ^ std::hash<int>()(loc.column);
+        return std::hash<uint32_t>()(loc.pos.value);
     }
 };
 
@@ -58,31 +61,31 @@ struct BorrowData {
     TwoPhaseActivation activation_location;
     BorrowKind kind;
     std::string region;
-    std::string borrowed_place;
-    std::string assigned_place;
+    amyr::span::Symbol borrowed_place;
+    amyr::span::Symbol assigned_place;
 
     BorrowData(Location reserve, TwoPhaseActivation activation, BorrowKind kind,
-               std::string region, std::string borrowed, std::string assigned)
+               std::string region, amyr::span::Symbol borrowed, amyr::span::Symbol assigned)
         : reserve_location(reserve), activation_location(activation), kind(kind),
-          region(std::move(region)), borrowed_place(std::move(borrowed)),
-          assigned_place(std::move(assigned)) {}
+          region(std::move(region)), borrowed_place(borrowed),
+          assigned_place(assigned) {}
 };
 
 class BorrowSet {
 public:
-    std::unordered_map<Location, BorrowData> location_map;
-    std::unordered_map<Location, std::vector<int>> activation_map;
-    std::unordered_map<std::string, std::unordered_set<int>> local_map;
+    std::unordered_map<Location, BorrowData, LocationHash> location_map;
+    std::unordered_map<Location, std::vector<int>, LocationHash> activation_map;
+    std::unordered_map<amyr::span::Symbol, std::unordered_set<int>> local_map;
 
     void add_borrow(Location location, BorrowData borrow) {
-        location_map[location] = std::move(borrow);
+        location_map.insert_or_assign(location, std::move(borrow));
     }
 
     void add_activation(Location location, int borrow_index) {
         activation_map[location].push_back(borrow_index);
     }
 
-    void add_local_borrow(const std::string& local, int borrow_index) {
+    void add_local_borrow(amyr::span::Symbol local, int borrow_index) {
         local_map[local].insert(borrow_index);
     }
 
@@ -101,26 +104,36 @@ class BorrowChecker {
 private:
     BorrowSet borrow_set;
     std::vector<Violation> errors;
+    // Scratch for the walks, kept to avoid an allocation per check.
+    std::vector<uint8_t> reached;
+    std::vector<const node::ExprAST*> work;
 
     void check_borrow(const BorrowData& borrow) {
         if (borrow.kind == BorrowKind::Mutable && borrow.activation_location == TwoPhaseActivation::ActivatedAt) {
             errors.emplace_back(ViolationType::BorrowWhileMutable,
-                                "Cannot mutably borrow '" + borrow.borrowed_place + "' while it is already borrowed",
-                                borrow.reserve_location.line);
+                                "Cannot mutably borrow '" + std::string(borrow.borrowed_place.as_str()) + "' while it is already borrowed",
+                                borrow.reserve_location.pos);
         }
     }
 
+    // Visits variables left to right through binary operators, on `work` rather than the native stack.
     void check_expr(const node::ExprAST* expr) {
-        if (auto* binary = dynamic_cast<const node::BinaryExprAST*>(expr)) {
-            check_expr(binary->getLHS());
-            check_expr(binary->getRHS());
-        } else if (auto* var = dynamic_cast<const node::VariableExprAST*>(expr)) {
-            check_variable(var);
+        work.clear();
+        work.push_back(expr);
+        while (!work.empty()) {
+            expr = work.back();
+            work.pop_back();
+            if (auto* binary = dynamic_cast<const node::BinaryExprAST*>(expr)) {
+                work.push_back(binary->getRHS());
+                work.push_back(binary->getLHS());
+            } else if (auto* var = dynamic_cast<const node::VariableExprAST*>(expr)) {
+                check_variable(var->getName());
+            }
         }
     }
 
-    void check_variable(const node::VariableExprAST* var) {
-        auto it = borrow_set.local_map.find(var->getName());
+    void check_variable(amyr::span::Symbol name) {
+        auto it = borrow_set.local_map.find(name);
         if (it != borrow_set.local_map.end()) {
             for (int borrow_index : it->second) {
                 const BorrowData& borrow = borrow_set.get_borrow(borrow_index);
@@ -136,6 +149,30 @@ public:
         return errors.empty();
     }
 
+    /*
+    Same walk as `check_expr`, through binary operators down to variables.
+    Parents come after their children, so a backward pass marks what the
+    walk reaches and a forward pass checks it in source order.
+    */
+    bool check(const node::FlatAst& ast, node::ExprId root) {
+        errors.clear();
+        const node::ExprId first = ast.first(root);
+        reached.assign(root - first + 1, 0);
+        reached[root - first] = 1;
+        for (node::ExprId id = root + 1; id-- > first;) {
+            if (reached[id - first] && ast.kind(id) == node::ExprKind::Binary) {
+                reached[ast.lhs(id) - first] = 1;
+                reached[ast.rhs(id) - first] = 1;
+            }
+        }
+        for (node::ExprId id = first; id <= root; ++id) {
+            if (reached[id - first] && ast.kind(id) == node::ExprKind::Variable) {
+                check_variable(ast.symbol(id));
+            }
+        }
+        return errors.empty();
+    }
+
     const std::vector<Violation>& get_errors() const {
         return errors;
     }
@@ -145,12 +182,12 @@ class OwnershipTracker {
 private:
     struct OwnershipData {
         bool is_mutable;
-        std::vector<std::string> borrowers;
+        std::vector<amyr::span::Symbol> borrowers;
         int scope_level;
         bool moved;
     };
 
-    std::unordered_map<std::string, OwnershipData> ownership_map;
+    std::unordered_map<amyr::span::Symbol, OwnershipData> ownership_map;
     int current_scope = 0;
 
 public:
@@ -167,7 +204,7 @@ public:
         --current_scope;
     }
 
-    bool register_variable(const std::string& name, bool is_mut) {
+    bool register_variable(amyr::span::Symbol name, bool is_mut) {
         if (ownership_map.find(name) != ownership_map.end()) {
             return false;
         }
@@ -181,7 +218,7 @@ public:
         return true;
     }
 
-    bool can_borrow(const std::string& name, BorrowKind kind) const {
+    bool can_borrow(amyr::span::Symbol name, BorrowKind kind) const {
         auto it = ownership_map.find(name);
         if (it == ownership_map.end() || it->second.moved) {
             return false;
@@ -200,7 +237,7 @@ public:
         }
     }
 
-    bool register_borrow(const std::string& var, const std::string& borrower, BorrowKind kind) {
+    bool register_borrow(amyr::span::Symbol var, amyr::span::Symbol borrower, BorrowKind kind) {
         auto it = ownership_map.find(var);
         if (it == ownership_map.end() || !can_borrow(var, kind)) {
             return false;
@@ -210,7 +247,7 @@ public:
         return true;
     }
 
-    bool mark_moved(const std::string& name) {
+    bool mark_moved(amyr::span::Symbol name) {
         auto it = ownership_map.find(name);
         if (it == ownership_map.end() || it->second.moved || !it->second.borrowers.empty()) {
             return false;
@@ -1,153 +1,219 @@
-#pragma once
-
-#include <vector>
-#include <memory>
-#include <cstdlib>
-#include <cassert>
-#include <type_traits>
-#include <new>
-#include <cstring>
-
-// ArenaChunk: Represents a single chunk of memory in the arena.
-template <typename T>
-class ArenaChunk {
-public:
-    explicit ArenaChunk(size_t capacity)
-        : capacity_(capacity), size_(0) {
-        data_ = static_cast<T*>(std::aligned_alloc(alignof(T), capacity_ * sizeof(T)));
-        if (!data_) {
-            throw std::bad_alloc();
-        }
-    }
-
-    ~ArenaChunk() {
-        clear();
-        std::free(data_);
-    }
-
-    T* allocate() {
-        assert(size_ < capacity_ && "Chunk capacity exceeded!");
-        return &data_[size_++];
-    }
-
-    bool has_space() const {
-        return size_ < capacity_;
-    }
-
-    void clear() {
-        if constexpr (!std::is_trivially_destructible_v<T>) {
-            for (size_t i = 0; i < size_; ++i) {
-                data_[i].~T();
-            }
-        }
-        size_ = 0;
-    }
-
-private:
-    T* data_;
-    size_t capacity_;
-    size_t size_;
-};
-
-// TypedArena: Allocator for objects of a single type.
-template <typename T>
-class TypedArena {
-public:
-    TypedArena() = default;
-
-    ~TypedArena() {
-        for (auto& chunk : chunks_) {
-            chunk->clear();
-        }
-    }
-
-    template <typename... Args>
-    T* allocate(Args&&... args) {
-        if (chunks_.empty() || !chunks_.back()->has_space()) {
-            grow();
-        }
-        T* obj = chunks_.back()->allocate();
-        new (obj) T(std::forward<Args>(args)...); // Placement new
-        return obj;
-    }
-
-    void clear() {
-        for (auto& chunk : chunks_) {
-            chunk->clear();
-        }
-    }
-
-private:
-    static constexpr size_t INITIAL_CAPACITY = 1024; // Initial chunk size
-    static constexpr size_t GROWTH_FACTOR = 2;       // Growth factor for chunk sizes
-
-    std::vector<std::unique_ptr<ArenaChunk<T>>> chunks_;
-
-    void grow() {
-        size_t capacity = chunks_.empty() ? INITIAL_CAPACITY : chunks_.back()->capacity() * GROWTH_FACTOR;
-        chunks_.emplace_back(std::make_unique<ArenaChunk<T>>(capacity));
-    }
-};
-
-// DroplessArena: Allocator for objects of multiple types (no destructors).
-class DroplessArena {
-public:
-    DroplessArena() = default;
-
-    ~DroplessArena() {
-        for (auto& chunk : chunks_) {
-            std::free(chunk.start);
-        }
-    }
-
-    void* allocate(size_t size, size_t alignment) {
-        if (chunks_.empty() || !has_space(size, alignment)) {
-            grow(size, alignment);
-        }
-        void* ptr = chunks_.back().current;
-        chunks_.back().current = static_cast<char*>(chunks_.back().current) + size;
-        return ptr;
-    }
-
-    void clear() {
-        for (auto& chunk : chunks_) {
-            chunk.current = chunk.start;
-        }
-    }
-
-private:
-    struct Chunk {
-        void* start;
-        void* current;
-        void* end;
-
-        Chunk(size_t size) {
-            start = std::aligned_alloc(alignof(max_align_t), size);
-            if (!start) {
-                throw std::bad_alloc();
-            }
-            current = start;
-            end = static_cast<char*>(start) + size;
-        }
-
-        ~Chunk() {
-            std::free(start);
-        }
-    };
-
-    std::vector<Chunk> chunks_;
-
-    bool has_space(size_t size, size_t alignment) const {
-        void* aligned = std::align(alignment, size, chunks_.back().current, remaining_space());
-        return aligned != nullptr;
-    }
-
-    size_t remaining_space() const {
-        return static_cast<char*>(chunks_.back().end) - static_cast<char*>(chunks_.back().current);
-    }
-
-    void grow(size_t size, size_t alignment) {
-        size_t chunk_size = std::max(size + alignment, static_cast<size_t>(4096)); // Default to 4KB chunks
-        chunks_.emplace_back(chunk_size);
-    }
-};
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <cassert>
+#include <type_traits>
+#include <new>
+#include <cstring>
+#include <algorithm>
+#include <cstddef>
+
+// ArenaChunk: Represents a single chunk of memory in the arena.
+template <typename T>
+class ArenaChunk {
+public:
+    explicit ArenaChunk(size_t capacity)
+        : capacity_(capacity), size_(0) {
+        data_ = static_cast<T*>(std::aligned_alloc(alignof(T), capacity_ * sizeof(T)));
+        if (!data_) {
+            throw std::bad_alloc();
+        }
+    }
+
+    ~ArenaChunk() {
+        clear();
+        std::free(data_);
+    }
+
+    // Reserves `n` consecutive slots; the caller constructs them.
+    T* allocate(size_t n = 1) {
+        assert(size_ + n <= capacity_ && "Chunk capacity exceeded!");
+        T* out = &data_[size_];
+        size_ += n;
+        return out;
+    }
+
+    bool has_space(size_t n = 1) const {
+        return size_ + n <= capacity_;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    void clear() {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t i = 0; i < size_; ++i) {
+                data_[i].~T();
+            }
+        }
+        size_ = 0;
+    }
+
+private:
+    T* data_;
+    size_t capacity_;
+    size_t size_;
+};
+
+// TypedArena: Allocator for objects of a single type.
+template <typename T>
+class TypedArena {
+public:
+    TypedArena() = default;
+
+    TypedArena(TypedArena&&) = default;
+    TypedArena& operator=(TypedArena&&) = default;
+
+    ~TypedArena() {
+        for (auto& chunk : chunks_) {
+            chunk->clear();
+        }
+    }
+
+    template <typename... Args>
+    T* allocate(Args&&... args) {
+        if (chunks_.empty() || !chunks_.back()->has_space()) {
+            grow();
+        }
+        T* obj = chunks_.back()->allocate();
+        new (obj) T(std::forward<Args>(args)...); // Placement new
+        return obj;
+    }
+
+    // Moves `items` into one contiguous run and returns its first element.
+    T* allocate_from(std::vector<T>&& items) {
+        const size_t n = items.size();
+        if (chunks_.empty() || !chunks_.back()->has_space(n)) {
+            grow(n);
+        }
+        T* out = chunks_.back()->allocate(n);
+        for (size_t i = 0; i < n; ++i) {
+            new (out + i) T(std::move(items[i]));
+        }
+        return out;
+    }
+
+    // Total size of the chunks taken from the system so far.
+    size_t allocated_bytes() const {
+        size_t total = 0;
+        for (const auto& chunk : chunks_) {
+            total += chunk->capacity() * sizeof(T);
+        }
+        return total;
+    }
+
+    void clear() {
+        for (auto& chunk : chunks_) {
+            chunk->clear();
+        }
+    }
+
+private:
+    // Chunks start at a page and double up to 2MB, so small arenas stay small.
+    static constexpr size_t INITIAL_CAPACITY = std::max<size_t>(4096 / sizeof(T), 1);
+    static constexpr size_t MAX_CAPACITY = std::max<size_t>((2 * 1024 * 1024) / sizeof(T), 1);
+    static constexpr size_t GROWTH_FACTOR = 2;       // Growth factor for chunk sizes
+
+    std::vector<std::unique_ptr<ArenaChunk<T>>> chunks_;
+
+    void grow(size_t min_capacity = 1) {
+        size_t capacity = chunks_.empty() ? INITIAL_CAPACITY : chunks_.back()->capacity() * GROWTH_FACTOR;
+        capacity = std::max(std::min(capacity, MAX_CAPACITY), min_capacity);
+        chunks_.emplace_back(std::make_unique<ArenaChunk<T>>(capacity));
+    }
+};
+
+// DroplessArena: Allocator for objects of multiple types (no destructors).
+class DroplessArena {
+public:
+    DroplessArena() = default;
+
+    // The arena owns raw chunks, so it can't be copied.
+    DroplessArena(const DroplessArena&) = delete;
+    DroplessArena& operator=(const DroplessArena&) = delete;
+
+    ~DroplessArena() {
+        for (auto& chunk : chunks_) {
+            std::free(chunk.start);
+        }
+    }
+
+    void* allocate(size_t size, size_t alignment) {
+        if (chunks_.empty() || !has_space(size, alignment)) {
+            grow(size, alignment);
+        }
+        Chunk& chunk = chunks_.back();
+        void* ptr = chunk.current;
+        size_t space = remaining_space();
+        ptr = std::align(alignment, size, ptr, space);
+        chunk.current = static_cast<char*>(ptr) + size;
+        return ptr;
+    }
+
+    // Copies `len` bytes from `src` into the arena and returns the copy.
+    char* copy_bytes(const char* src, size_t len) {
+        char* dst = static_cast<char*>(allocate(len, 1));
+        std::memcpy(dst, src, len);
+        return dst;
+    }
+
+    void clear() {
+        for (auto& chunk : chunks_) {
+            chunk.current = chunk.start;
+        }
+    }
+
+    // Total size of the chunks taken from the system so far.
+    size_t allocated_bytes() const {
+        size_t total = 0;
+        for (const auto& chunk : chunks_) {
+            total += static_cast<char*>(chunk.end) - static_cast<char*>(chunk.start);
+        }
+        return total;
+    }
+
+private:
+    // Chunks are plain views; the arena frees them, so vector growth can copy them freely.
+    struct Chunk {
+        void* start;
+        void* current;
+        void* end;
+
+        Chunk(size_t size) {
+            start = std::aligned_alloc(alignof(max_align_t), size);
+            if (!start) {
+                throw std::bad_alloc();
+            }
+            current = start;
+            end = static_cast<char*>(start) + size;
+        }
+    };
+
+    std::vector<Chunk> chunks_;
+
+    bool has_space(size_t size, size_t alignment) const {
+        void* current = chunks_.back().current;
+        size_t space = remaining_space();
+        return std::align(alignment, size, current, space) != nullptr;
+    }
+
+    size_t remaining_space() const {
+        return static_cast<char*>(chunks_.back().end) - static_cast<char*>(chunks_.back().current);
+    }
+
+    // Chunks start at 4KB and double up to 2MB, so big arenas don't pay a malloc per page.
+    void grow(size_t size, size_t alignment) {
+        size_t next = 4096;
+        if (!chunks_.empty()) {
+            const size_t last = static_cast<char*>(chunks_.back().end) - static_cast<char*>(chunks_.back().start);
+            next = std::min(last * 2, static_cast<size_t>(2 * 1024 * 1024));
+        }
+        size_t chunk_size = std::max(size + alignment, next);
+        // aligned_alloc wants a multiple of the alignment.
+        chunk_size = (chunk_size + alignof(max_align_t) - 1) & ~(alignof(max_align_t) - 1);
+        chunks_.emplace_back(chunk_size);
+    }
+};
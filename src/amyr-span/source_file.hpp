@@ -0,0 +1,138 @@
+/*
+A single loaded source file.
+
+Files opened from disk are memory-mapped read-only, so the lexers can work on
+the page cache directly through `src()` without ever copying the text.
+In-memory sources (tests, editor buffers) own their text instead.
+
+Either way the text is checked to be UTF-8 once, here, so the lexers can
+decode characters without validating them again.
+*/
+#pragma once
+
+#include<optional>
+#include<stdexcept>
+#include<string>
+#include<string_view>
+#include<system_error>
+#include<utility>
+
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<unistd.h>
+
+#include "amyr-tokenizer/utf8.hpp"
+
+namespace amyr {
+namespace span {
+
+class SourceFile {
+public:
+    /*
+    Maps `path` into memory. Throws std::system_error if it can't be opened or
+    mapped, and std::runtime_error if it isn't valid UTF-8.
+    */
+    static SourceFile open(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+        }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0) {
+            const int err = errno;
+            ::close(fd);
+            throw std::system_error(err, std::generic_category(), "cannot stat " + path);
+        }
+
+        SourceFile file(path);
+        const size_t len = static_cast<size_t>(st.st_size);
+        // mmap rejects zero-length mappings; an empty file is just an empty view.
+        if (len != 0) {
+            void* addr = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                const int err = errno;
+                ::close(fd);
+                throw std::system_error(err, std::generic_category(), "cannot map " + path);
+            }
+            // The lexers read front to back, let the kernel read ahead aggressively.
+            ::madvise(addr, len, MADV_SEQUENTIAL);
+            file.mapped_ = addr;
+            file.src_ = std::string_view(static_cast<const char*>(addr), len);
+        }
+        ::close(fd);
+        file.check_utf8();
+        return file;
+    }
+
+    // Wraps text that is already in memory. The file takes ownership of it.
+    // Throws std::runtime_error if it isn't valid UTF-8.
+    static SourceFile from_string(std::string name, std::string text) {
+        SourceFile file(std::move(name));
+        file.owned_ = std::move(text);
+        file.src_ = file.owned_;
+        file.check_utf8();
+        return file;
+    }
+
+    SourceFile(SourceFile&& other) noexcept
+        : name_(std::move(other.name_)), owned_(std::move(other.owned_)),
+          mapped_(std::exchange(other.mapped_, nullptr)) {
+        src_ = mapped_ ? std::exchange(other.src_, {}) : std::string_view(owned_);
+        other.src_ = {};
+    }
+
+    SourceFile& operator=(SourceFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            name_ = std::move(other.name_);
+            owned_ = std::move(other.owned_);
+            mapped_ = std::exchange(other.mapped_, nullptr);
+            src_ = mapped_ ? other.src_ : std::string_view(owned_);
+            other.src_ = {};
+        }
+        return *this;
+    }
+
+    // No copying: the whole point is to never duplicate the text.
+    SourceFile(const SourceFile&) = delete;
+    SourceFile& operator=(const SourceFile&) = delete;
+
+    ~SourceFile() {
+        unmap();
+    }
+
+    // The file contents. Valid for as long as this SourceFile is alive.
+    std::string_view src() const { return src_; }
+
+    const std::string& name() const { return name_; }
+
+    size_t size() const { return src_.size(); }
+
+    bool is_mapped() const { return mapped_ != nullptr; }
+
+private:
+    explicit SourceFile(std::string name) : name_(std::move(name)) {}
+
+    void check_utf8() const {
+        if (const std::optional<size_t> offset = unicode::find_invalid_utf8(src_)) {
+            throw std::runtime_error(name_ + ": invalid UTF-8 at byte " + std::to_string(*offset));
+        }
+    }
+
+    void unmap() {
+        if (mapped_) {
+            ::munmap(mapped_, src_.size());
+            mapped_ = nullptr;
+        }
+    }
+
+    std::string name_;
+    std::string owned_;
+    void* mapped_ = nullptr;
+    std::string_view src_;
+};
+
+} // namespace span
+} // namespace amyr
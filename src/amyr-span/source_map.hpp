@@ -0,0 +1,201 @@
+/*
+Byte positions and line lookup for every loaded file.
+
+Each file added to the SourceMap gets its own slice of one global u32 byte
+space, so a BytePos identifies a file and an offset in it at once. Tokens and
+AST nodes only ever store offsets; lines and columns are worked out when a
+diagnostic is printed. A file's line-start table is built with a vectorized
+newline scan the first time a position in it is looked up, and each lookup
+after that is a binary search.
+*/
+#pragma once
+
+#include<algorithm>
+#include<cstdint>
+#include<memory>
+#include<mutex>
+#include<optional>
+#include<stdexcept>
+#include<string>
+#include<string_view>
+#include<vector>
+
+#include "source_file.hpp"
+#include "amyr-tokenizer/simd_scan.hpp"
+
+namespace amyr {
+namespace span {
+
+// A position in the SourceMap's global byte space.
+struct BytePos {
+    uint32_t value = 0;
+
+    constexpr BytePos() = default;
+    explicit constexpr BytePos(uint32_t value) : value(value) {}
+
+    constexpr BytePos operator+(uint32_t offset) const { return BytePos(value + offset); }
+    constexpr uint32_t operator-(BytePos other) const { return value - other.value; }
+
+    constexpr bool operator==(BytePos other) const { return value == other.value; }
+    constexpr bool operator!=(BytePos other) const { return value != other.value; }
+    constexpr bool operator<(BytePos other) const { return value < other.value; }
+    constexpr bool operator<=(BytePos other) const { return value <= other.value; }
+    constexpr bool operator>(BytePos other) const { return value > other.value; }
+    constexpr bool operator>=(BytePos other) const { return value >= other.value; }
+};
+
+// 1-based line and column. Columns count characters, not bytes.
+struct LineCol {
+    uint32_t line;
+    uint32_t col;
+
+    bool operator==(const LineCol& other) const { return line == other.line && col == other.col; }
+};
+
+namespace source_map_detail {
+
+    // 1-based column of `offset` on the line starting at `line_start`.
+    inline uint32_t column(std::string_view text, uint32_t line_start, uint32_t offset) {
+        uint32_t col = 1;
+        for (uint32_t i = line_start; i < offset; ++i) {
+            // Continuation bytes don't start a new character.
+            col += (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80;
+        }
+        return col;
+    }
+
+} // namespace source_map_detail
+
+// Start offsets of all lines of a text.
+class LineIndex {
+public:
+    explicit LineIndex(std::string_view text) {
+        starts_.reserve(text.size() / 32 + 1);
+        starts_.push_back(0);
+        simd::collect_line_starts(text.data(), text.data() + text.size(), 0, starts_);
+    }
+
+    size_t line_count() const { return starts_.size(); }
+
+    // Offset of 0-based line `line`.
+    uint32_t line_start(size_t line) const { return starts_[line]; }
+
+    // Line and column of `offset` in `text`, which must be the text the index was built from.
+    LineCol lookup(std::string_view text, uint32_t offset) const {
+        const size_t line = static_cast<size_t>(std::upper_bound(starts_.begin(), starts_.end(), offset) - starts_.begin()) - 1;
+        return LineCol{static_cast<uint32_t>(line + 1), source_map_detail::column(text, starts_[line], offset)};
+    }
+
+private:
+    std::vector<uint32_t> starts_;
+};
+
+/*
+Line and column of `offset` without building an index, for one-off lookups
+on text that isn't in a SourceMap (error paths of the standalone lexers).
+*/
+inline LineCol line_col(std::string_view text, uint32_t offset) {
+    const std::string_view before = text.substr(0, offset);
+    const size_t last_newline = before.rfind('\n');
+    const uint32_t line_start = last_newline == std::string_view::npos ? 0 : static_cast<uint32_t>(last_newline + 1);
+    const uint32_t line = 1 + static_cast<uint32_t>(std::count(before.begin(), before.end(), '\n'));
+    return LineCol{line, source_map_detail::column(text, line_start, offset)};
+}
+
+class SourceMap {
+public:
+    // A file in the map and the slice of the global byte space it owns.
+    class File {
+    public:
+        File(SourceFile source, BytePos start_pos) : source_(std::move(source)), start_pos_(start_pos) {}
+
+        const SourceFile& source() const { return source_; }
+        std::string_view src() const { return source_.src(); }
+        const std::string& name() const { return source_.name(); }
+
+        BytePos start_pos() const { return start_pos_; }
+        // One past the last byte; still a valid position (EOF).
+        BytePos end_pos() const { return start_pos_ + static_cast<uint32_t>(source_.size()); }
+
+        BytePos pos(uint32_t offset) const { return start_pos_ + offset; }
+        uint32_t offset(BytePos pos) const { return pos - start_pos_; }
+
+        // The line-start table, built on first use. Safe to call from several threads.
+        const LineIndex& lines() const {
+            std::call_once(lines_once_, [this] { lines_.emplace(src()); });
+            return *lines_;
+        }
+
+        LineCol lookup(BytePos pos) const {
+            return lines().lookup(src(), offset(pos));
+        }
+
+    private:
+        SourceFile source_;
+        BytePos start_pos_;
+        mutable std::once_flag lines_once_;
+        mutable std::optional<LineIndex> lines_;
+    };
+
+    // A resolved position, for diagnostics.
+    struct Loc {
+        const File* file;
+        LineCol line_col;
+    };
+
+    SourceMap() = default;
+    SourceMap(const SourceMap&) = delete;
+    SourceMap& operator=(const SourceMap&) = delete;
+
+    /*
+    Adds a file and assigns it the next free slice of the byte space. Adding
+    is not thread-safe; lookups are. Throws std::length_error once the map
+    outgrows 32-bit positions.
+    */
+    const File& add(SourceFile source) {
+        // One byte of gap keeps a file's EOF position distinct from the next file's start.
+        const uint64_t end = uint64_t(next_start_) + source.size() + 1;
+        if (end > UINT32_MAX) {
+            throw std::length_error("source map is full, cannot add " + source.name());
+        }
+        files_.push_back(std::make_unique<File>(std::move(source), BytePos(next_start_)));
+        next_start_ = static_cast<uint32_t>(end);
+        return *files_.back();
+    }
+
+    // Maps the file at `path` and adds it. Throws like SourceFile::open.
+    const File& load(const std::string& path) {
+        return add(SourceFile::open(path));
+    }
+
+    size_t file_count() const { return files_.size(); }
+
+    // The file `pos` falls in. `pos` must come from this map.
+    const File& lookup_file(BytePos pos) const {
+        auto it = std::upper_bound(files_.begin(), files_.end(), pos,
+            [](BytePos p, const std::unique_ptr<File>& file) { return p < file->start_pos(); });
+        if (it == files_.begin()) {
+            throw std::out_of_range("position " + std::to_string(pos.value) + " is not in the source map");
+        }
+        return **(it - 1);
+    }
+
+    Loc lookup(BytePos pos) const {
+        const File& file = lookup_file(pos);
+        return Loc{&file, file.lookup(pos)};
+    }
+
+    // `name:line:col` of `pos`.
+    std::string describe(BytePos pos) const {
+        const Loc loc = lookup(pos);
+        return loc.file->name() + ":" + std::to_string(loc.line_col.line) + ":" + std::to_string(loc.line_col.col);
+    }
+
+private:
+    // unique_ptr keeps Files (and the views into them) put when the vector grows.
+    std::vector<std::unique_ptr<File>> files_;
+    uint32_t next_start_ = 0;
+};
+
+} // namespace span
+} // namespace amyr
@@ -0,0 +1,186 @@
+/*
+Interned identifiers.
+
+A Symbol is a u32 handle into the global interner, so later phases compare and
+hash identifiers as integers. Keywords are interned up front at fixed indices
+(see AMYR_KEYWORDS), which makes `kw::Let` etc. compile-time constants and
+`is_keyword()` a single compare. Interned text lives in a DroplessArena and is
+never freed, so `as_str()` views stay valid for the whole compilation.
+*/
+#pragma once
+
+#include<cstdint>
+#include<functional>
+#include<mutex>
+#include<string_view>
+#include<unordered_map>
+#include<vector>
+
+#include "amyr-parser/arena.hpp"
+
+namespace amyr {
+namespace span {
+
+// The one keyword list. Order defines the pre-interned Symbol indices.
+#define AMYR_KEYWORDS(X)        \
+    X(Empty,     "")            \
+    X(As,        "as")          \
+    X(Async,     "async")       \
+    X(Await,     "await")       \
+    X(Break,     "break")       \
+    X(Const,     "const")       \
+    X(Continue,  "continue")    \
+    X(Crate,     "crate")       \
+    X(Dyn,       "dyn")         \
+    X(Else,      "else")        \
+    X(Enum,      "enum")        \
+    X(Extern,    "extern")      \
+    X(False,     "false")       \
+    X(Fn,        "fn")          \
+    X(For,       "for")         \
+    X(Func,      "func")        \
+    X(If,        "if")          \
+    X(Impl,      "impl")        \
+    X(In,        "in")          \
+    X(Let,       "let")         \
+    X(Loop,      "loop")        \
+    X(Match,     "match")       \
+    X(Mod,       "mod")         \
+    X(Move,      "move")        \
+    X(Mut,       "mut")         \
+    X(Pub,       "pub")         \
+    X(Ref,       "ref")         \
+    X(Return,    "return")      \
+    X(SelfLower, "self")        \
+    X(SelfUpper, "Self")        \
+    X(Static,    "static")      \
+    X(Struct,    "struct")      \
+    X(Super,     "super")       \
+    X(Trait,     "trait")       \
+    X(True,      "true")        \
+    X(Type,      "type")        \
+    X(Unsafe,    "unsafe")      \
+    X(Use,       "use")         \
+    X(Where,     "where")       \
+    X(While,     "while")
+
+namespace detail {
+    enum KeywordIndex : uint32_t {
+        #define AMYR_KW_INDEX(name, text) name,
+        AMYR_KEYWORDS(AMYR_KW_INDEX)
+        #undef AMYR_KW_INDEX
+        KEYWORD_COUNT
+    };
+
+    inline constexpr std::string_view KEYWORD_STRINGS[KEYWORD_COUNT] = {
+        #define AMYR_KW_STRING(name, text) text,
+        AMYR_KEYWORDS(AMYR_KW_STRING)
+        #undef AMYR_KW_STRING
+    };
+}
+
+class Symbol {
+public:
+    constexpr explicit Symbol(uint32_t idx) : idx_(idx) {}
+
+    // Interns `text` in the global interner.
+    static Symbol intern(std::string_view text);
+
+    // The interned text. The view lives as long as the process.
+    std::string_view as_str() const;
+
+    constexpr uint32_t as_u32() const { return idx_; }
+
+    // `kw::Empty` is pre-interned too, but it is not a keyword.
+    constexpr bool is_keyword() const {
+        return idx_ != detail::Empty && idx_ < detail::KEYWORD_COUNT;
+    }
+
+    constexpr bool operator==(Symbol other) const { return idx_ == other.idx_; }
+    constexpr bool operator!=(Symbol other) const { return idx_ != other.idx_; }
+    constexpr bool operator<(Symbol other) const { return idx_ < other.idx_; }
+
+private:
+    uint32_t idx_;
+};
+
+// Pre-interned keyword symbols, e.g. `kw::Let`.
+namespace kw {
+    #define AMYR_KW_SYMBOL(name, text) inline constexpr Symbol name{detail::name};
+    AMYR_KEYWORDS(AMYR_KW_SYMBOL)
+    #undef AMYR_KW_SYMBOL
+}
+
+/*
+Maps strings to Symbols and back. Access is serialized with a mutex so
+parallel lexing and parsing can share the global instance.
+*/
+class Interner {
+public:
+    Interner() {
+        strings_.reserve(detail::KEYWORD_COUNT);
+        for (std::string_view keyword : detail::KEYWORD_STRINGS) {
+            // Keyword text is static, no need to copy it into the arena.
+            names_.emplace(keyword, Symbol(static_cast<uint32_t>(strings_.size())));
+            strings_.push_back(keyword);
+        }
+    }
+
+    Interner(const Interner&) = delete;
+    Interner& operator=(const Interner&) = delete;
+
+    Symbol intern(std::string_view text) {
+        std::lock_guard<std::mutex> guard(lock_);
+        auto it = names_.find(text);
+        if (it != names_.end()) {
+            return it->second;
+        }
+
+        std::string_view stored(arena_.copy_bytes(text.data(), text.size()), text.size());
+        Symbol sym(static_cast<uint32_t>(strings_.size()));
+        strings_.push_back(stored);
+        names_.emplace(stored, sym);
+        return sym;
+    }
+
+    std::string_view get(Symbol sym) const {
+        std::lock_guard<std::mutex> guard(lock_);
+        return strings_[sym.as_u32()];
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> guard(lock_);
+        return strings_.size();
+    }
+
+private:
+    mutable std::mutex lock_;
+    DroplessArena arena_;
+    std::unordered_map<std::string_view, Symbol> names_;
+    std::vector<std::string_view> strings_;
+};
+
+inline Interner& global_interner() {
+    static Interner interner;
+    return interner;
+}
+
+inline Symbol Symbol::intern(std::string_view text) {
+    return global_interner().intern(text);
+}
+
+inline std::string_view Symbol::as_str() const {
+    return global_interner().get(*this);
+}
+
+} // namespace span
+} // namespace amyr
+
+namespace std {
+    template<>
+    struct hash<amyr::span::Symbol> {
+        size_t operator()(amyr::span::Symbol sym) const {
+            return hash<uint32_t>{}(sym.as_u32());
+        }
+    };
+}
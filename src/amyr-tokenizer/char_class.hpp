@@ -0,0 +1,84 @@
+/*
+Character classes of single bytes, shared by both lexers.
+
+One constexpr 256-entry table answers every ASCII class test with a single
+load. Unlike <cctype> it doesn't consult the process locale and is defined
+for every byte, including negative `char`s. Bytes 0x80 and up are in no
+class; non-ASCII characters go through the Unicode tables instead.
+*/
+#pragma once
+
+#include<array>
+#include<cstdint>
+
+namespace amyr {
+namespace lexer {
+
+namespace char_class {
+
+    enum : uint8_t {
+        DIGIT = 1 << 0,
+        HEX_DIGIT = 1 << 1,
+        // Letters and `_`.
+        ID_START = 1 << 2,
+        // Letters, digits and `_`.
+        ID_CONTINUE = 1 << 3,
+        // `\t`, `\n`, `\v`, `\f`, `\r` and space: the ASCII part of Pattern_White_Space.
+        WHITESPACE = 1 << 4
+    };
+
+    constexpr std::array<uint8_t, 256> make_table() {
+        std::array<uint8_t, 256> table{};
+        for (char c = '0'; c <= '9'; ++c) {
+            table[c] = DIGIT | HEX_DIGIT | ID_CONTINUE;
+        }
+        for (char c = 'a'; c <= 'z'; ++c) {
+            table[c] = ID_START | ID_CONTINUE;
+            table[c - 'a' + 'A'] = ID_START | ID_CONTINUE;
+        }
+        for (char c = 'a'; c <= 'f'; ++c) {
+            table[c] |= HEX_DIGIT;
+            table[c - 'a' + 'A'] |= HEX_DIGIT;
+        }
+        table['_'] = ID_START | ID_CONTINUE;
+        for (char c : {'\t', '\n', '\v', '\f', '\r', ' '}) {
+            table[c] = WHITESPACE;
+        }
+        return table;
+    }
+
+    inline constexpr std::array<uint8_t, 256> TABLE = make_table();
+
+    /*
+    Classes of `c`. Takes a char32_t so decoded characters and bytes both
+    fit; a negative `char` converts to a value past the table and is in no
+    class, like any other non-ASCII byte.
+    */
+    constexpr uint8_t of(char32_t c) {
+        return c < TABLE.size() ? TABLE[c] : 0;
+    }
+
+} // namespace char_class
+
+constexpr bool is_ascii_digit(char32_t c) {
+    return char_class::of(c) & char_class::DIGIT;
+}
+
+constexpr bool is_ascii_hex_digit(char32_t c) {
+    return char_class::of(c) & char_class::HEX_DIGIT;
+}
+
+constexpr bool is_ascii_id_start(char32_t c) {
+    return char_class::of(c) & char_class::ID_START;
+}
+
+constexpr bool is_ascii_id_continue(char32_t c) {
+    return char_class::of(c) & char_class::ID_CONTINUE;
+}
+
+constexpr bool is_ascii_whitespace(char32_t c) {
+    return char_class::of(c) & char_class::WHITESPACE;
+}
+
+} // namespace lexer
+} // namespace amyr
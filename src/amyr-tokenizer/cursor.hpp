@@ -10,35 +10,33 @@ and position can be shifted forward by the bump method
 #include<string_view>
 #include<optional>
 
+#include "simd_scan.hpp"
+#include "utf8.hpp"
+
 static constexpr char EOF_CHAR = '\0';
 class Cursor {
 
 public:
 
 
-    Cursor(const std::string& input)
-            : input_(input), pos_(0), len_remaining_(input.length())
-        #ifdef _DEBUG
-            , prev_(EOF_CHAR)
-        #endif
-        {}
+    /*
+    The cursor only borrows `input`; the text (usually a SourceFile) must outlive it.
+    */
+    Cursor(std::string_view input)
+            : input_(input), pos_(0), len_remaining_(input.length()) {}
 
     
     std::string_view as_str() const {
-        return std::string_view(input_).substr(pos_);
+        return input_.substr(pos_);
     }
 
     
     /*
-    Returns the last eaten symbol while in Debug mode,
-    else returns the last eaten character
+    Returns the last eaten character, or EOF_CHAR before the first bump.
+    The input is borrowed whole, so this needs no extra state.
     */
     char prev() const {
-        #ifdef _DEBUG
-            return prev_;
-        #else
-            return EOF_CHAR;
-        #endif
+        return pos_ > 0 ? input_[pos_ - 1] : EOF_CHAR;
     }
 
 
@@ -60,6 +58,31 @@ public:
     }
 
     
+    /*
+    Decodes the character that starts `n` characters ahead, without consuming it.
+    Returns EOF_CHAR past the end of input. ASCII costs a single load.
+    */
+    char32_t peek_char(size_t n = 0) const {
+        size_t pos = pos_;
+        for (; n > 0 && pos < input_.length(); --n) {
+            pos += amyr::unicode::sequence_length(static_cast<unsigned char>(input_[pos]));
+        }
+        if (pos >= input_.length()) {
+            return EOF_CHAR;
+        }
+        const unsigned char byte = static_cast<unsigned char>(input_[pos]);
+        if (byte < 0x80) {
+            return byte;
+        }
+        size_t len;
+        return amyr::unicode::decode(input_.data() + pos, end_ptr(), len);
+    }
+
+    char32_t first_char() const {
+        return peek_char(0);
+    }
+
+    
     /* 
     Checks if there is nothing more to consume.
     */
@@ -72,10 +95,19 @@ public:
     Returns amount of already consumed symbols
     */
    unsigned int pos_within_token() const {
-        return static_cast<unsigned int> (input_.length() - len_remaining_);
+        return static_cast<unsigned int> (len_remaining_ - (input_.length() - pos_));
     }
 
     
+    /*
+    Returns the text consumed since the last reset, i.e. the current token so far
+    */
+    std::string_view token_text() const {
+        const unsigned int len = pos_within_token();
+        return input_.substr(pos_ - len, len);
+    }
+
+
     /*
     Resets the number of bytes consumed to 0
     */
@@ -89,17 +121,35 @@ public:
     */
     std::optional<char> bump() {
         if (pos_ < input_.length()) {
-            char c = input_[pos_++];
-            
-            #ifdef _DEBUG
-                prev_ = c;
-            #endif
-
-            --len_remaining_;
-            return c;
+            return input_[pos_++];
+        }
+
+        return std::nullopt;
+    }
+
+
+    /*
+    Moves past the next whole character and returns it.
+    */
+    std::optional<char32_t> bump_char() {
+        if (pos_ >= input_.length()) {
+            return std::nullopt;
         }
+        size_t len;
+        const char32_t c = amyr::unicode::decode(cursor_ptr(), end_ptr(), len);
+        pos_ += len;
+        return c;
+    }
 
-        return EOF_CHAR;
+    /*
+    Called right after `bump` returned the lead byte of a multi-byte character:
+    eats its continuation bytes and returns the whole character.
+    */
+    char32_t finish_char() {
+        size_t len;
+        const char32_t c = amyr::unicode::decode(cursor_ptr() - 1, end_ptr(), len);
+        pos_ += len - 1;
+        return c;
     }
 
 
@@ -113,25 +163,84 @@ public:
         }
     }
 
-    void eat_until(char target) {
-        const size_t found_pos = input_.find(target, pos_);
-        if (found_pos != std::string::npos) {
-            pos_ = found_pos;
-        } else {
-            pos_ = input_.length();
+    /*
+    Like `eat_while`, but hands the predicate whole characters instead of bytes.
+    ASCII bytes are tested directly; only non-ASCII input is decoded.
+    */
+    template <typename Predicate>
+    void eat_while_char(Predicate predicate) {
+        while (pos_ < input_.length()) {
+            const unsigned char byte = static_cast<unsigned char>(input_[pos_]);
+            if (byte < 0x80) {
+                if (!predicate(static_cast<char32_t>(byte))) {
+                    return;
+                }
+                pos_++;
+                continue;
+            }
+            size_t len;
+            if (!predicate(amyr::unicode::decode(cursor_ptr(), end_ptr(), len))) {
+                return;
+            }
+            pos_ += len;
         }
     }
 
+    /*
+    Eats symbols until `target` is the next one or the end of file is reached.
+    */
+    void eat_until(char target) {
+        advance_to(amyr::simd::find_byte(cursor_ptr(), end_ptr(), target));
+    }
+
+    /*
+    Eats symbols until either `a` or `b` is the next one or the end of file is reached.
+    */
+    void eat_until_either(char a, char b) {
+        advance_to(amyr::simd::find_either(cursor_ptr(), end_ptr(), a, b));
+    }
+
+    /*
+    Eats symbols until the next two are `a` then `b`, or to the end of file.
+    */
+    void eat_until_pair(char a, char b) {
+        advance_to(amyr::simd::find_pair(cursor_ptr(), end_ptr(), a, b));
+    }
+
+    /*
+    Eats symbols until the next two are `ab` or `ba`, or to the end of file.
+    */
+    void eat_until_either_pair(char a, char b) {
+        advance_to(amyr::simd::find_either_pair(cursor_ptr(), end_ptr(), a, b));
+    }
+
+    /*
+    Eats a run of ASCII whitespace in bulk. Non-ASCII whitespace is left to `eat_while`.
+    */
+    void eat_ascii_whitespace() {
+        advance_to(amyr::simd::skip_ascii_whitespace(cursor_ptr(), end_ptr()));
+    }
+
     inline size_t pos() const {
         return pos_;
     }
 
 
 private:
-    size_t len_remaining_;
+    const char* cursor_ptr() const {
+        return input_.data() + pos_;
+    }
+
+    const char* end_ptr() const {
+        return input_.data() + input_.length();
+    }
+
+    // Moves the cursor forward to `target`, which must lie within the input.
+    void advance_to(const char* target) {
+        pos_ = static_cast<size_t>(target - input_.data());
+    }
+
+    std::string_view input_;
     size_t pos_;
-    const std::string& input_;
-    #ifdef _DEBUG
-        char prev_;
-    #endif
+    size_t len_remaining_;
 };
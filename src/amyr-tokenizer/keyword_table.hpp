@@ -0,0 +1,123 @@
+/*
+Compile-time perfect hash over the AMYR_KEYWORDS list.
+
+The hash mixes the length with the first two and last two bytes and multiplies
+by a seed that is searched for at compile time so that no two keywords share a
+slot. A lookup is then one multiply, one table load and one compare, with no
+allocation and no dependence on the interner.
+*/
+#pragma once
+
+#include<array>
+#include<cstdint>
+#include<string_view>
+
+#include "amyr-span/symbol.hpp"
+
+namespace amyr {
+namespace lexer {
+
+namespace keyword_detail {
+
+    using amyr::span::detail::KEYWORD_COUNT;
+    using amyr::span::detail::KEYWORD_STRINGS;
+
+    inline constexpr unsigned TABLE_BITS = 8;
+    inline constexpr size_t TABLE_SIZE = size_t(1) << TABLE_BITS;
+    // Slot value for "no keyword here". Index 0 is kw::Empty, which is never a lookup result.
+    inline constexpr uint8_t EMPTY_SLOT = 0;
+
+    static_assert(KEYWORD_COUNT < 256, "keyword indices must fit in a byte");
+
+    constexpr size_t min_len() {
+        size_t len = SIZE_MAX;
+        for (size_t i = 1; i < KEYWORD_COUNT; ++i) {
+            len = KEYWORD_STRINGS[i].size() < len ? KEYWORD_STRINGS[i].size() : len;
+        }
+        return len;
+    }
+
+    constexpr size_t max_len() {
+        size_t len = 0;
+        for (size_t i = 1; i < KEYWORD_COUNT; ++i) {
+            len = KEYWORD_STRINGS[i].size() > len ? KEYWORD_STRINGS[i].size() : len;
+        }
+        return len;
+    }
+
+    inline constexpr size_t MIN_LEN = min_len();
+    inline constexpr size_t MAX_LEN = max_len();
+
+    static_assert(MIN_LEN >= 2, "slot() reads the first two and last two bytes");
+
+    // `text` must be at least MIN_LEN bytes long.
+    constexpr uint32_t slot(std::string_view text, uint32_t seed) {
+        const size_t len = text.size();
+        const uint32_t key = static_cast<uint32_t>(static_cast<uint8_t>(text[0]))
+                           | static_cast<uint32_t>(static_cast<uint8_t>(text[1])) << 8
+                           | static_cast<uint32_t>(static_cast<uint8_t>(text[len - 2])) << 16
+                           | static_cast<uint32_t>(static_cast<uint8_t>(text[len - 1])) << 24;
+        return ((key ^ static_cast<uint32_t>(len) * 0x9E37u) * seed) >> (32 - TABLE_BITS);
+    }
+
+    constexpr bool is_perfect(uint32_t seed) {
+        std::array<bool, TABLE_SIZE> used{};
+        for (size_t i = 1; i < KEYWORD_COUNT; ++i) {
+            const uint32_t s = slot(KEYWORD_STRINGS[i], seed);
+            if (used[s]) {
+                return false;
+            }
+            used[s] = true;
+        }
+        return true;
+    }
+
+    constexpr uint32_t find_seed() {
+        // Odd multipliers only; the search terminates within a few dozen tries for this list.
+        for (uint32_t seed = 0x9E3779B1u; ; seed += 2) {
+            if (is_perfect(seed)) {
+                return seed;
+            }
+        }
+    }
+
+    inline constexpr uint32_t SEED = find_seed();
+
+    constexpr std::array<uint8_t, TABLE_SIZE> build_table() {
+        std::array<uint8_t, TABLE_SIZE> table{};
+        for (size_t i = 0; i < TABLE_SIZE; ++i) {
+            table[i] = EMPTY_SLOT;
+        }
+        for (size_t i = 1; i < KEYWORD_COUNT; ++i) {
+            table[slot(KEYWORD_STRINGS[i], SEED)] = static_cast<uint8_t>(i);
+        }
+        return table;
+    }
+
+    inline constexpr std::array<uint8_t, TABLE_SIZE> TABLE = build_table();
+
+} // namespace keyword_detail
+
+/*
+Returns the pre-interned keyword Symbol for `text`, or `kw::Empty` if `text`
+is not a keyword.
+*/
+constexpr amyr::span::Symbol lookup_keyword(std::string_view text) {
+    using namespace keyword_detail;
+    if (text.size() < MIN_LEN || text.size() > MAX_LEN) {
+        return amyr::span::kw::Empty;
+    }
+    const uint8_t idx = TABLE[slot(text, SEED)];
+    if (idx != EMPTY_SLOT && KEYWORD_STRINGS[idx] == text) {
+        return amyr::span::Symbol(idx);
+    }
+    return amyr::span::kw::Empty;
+}
+
+static_assert(lookup_keyword("let") == amyr::span::kw::Let);
+static_assert(lookup_keyword("Self") == amyr::span::kw::SelfUpper);
+static_assert(lookup_keyword("lets") == amyr::span::kw::Empty);
+static_assert(lookup_keyword("x") == amyr::span::kw::Empty);
+
+} // namespace lexer
+} // namespace amyr
@@ -0,0 +1,289 @@
+/*
+Values of numeric literals.
+
+Works on the token text in place: `number()` has already split the literal
+into base prefix, digits and suffix, so evaluating it is a single pass over
+the digits with no allocation. Decimal digits are consumed eight at a time
+when there is no `_` in the way. Integers are evaluated to 128 bits; range
+checks against a narrower type are left to whoever knows the type.
+*/
+#pragma once
+
+#include<charconv>
+#include<cmath>
+#include<cstdint>
+#include<cstring>
+#include<limits>
+#include<optional>
+#include<string_view>
+
+#include "low_lexer.hpp"
+#include "amyr-utils/result.hpp"
+
+namespace amyr {
+namespace lexer {
+
+using u128 = unsigned __int128;
+
+enum class NumericSuffix : uint8_t {
+    None,
+    I8, I16, I32, I64, I128, Isize,
+    U8, U16, U32, U64, U128, Usize,
+    F32, F64
+};
+
+inline std::optional<NumericSuffix> parse_suffix(std::string_view suffix) {
+    static constexpr std::pair<std::string_view, NumericSuffix> SUFFIXES[] = {
+        {"", NumericSuffix::None},
+        {"i8", NumericSuffix::I8}, {"i16", NumericSuffix::I16}, {"i32", NumericSuffix::I32},
+        {"i64", NumericSuffix::I64}, {"i128", NumericSuffix::I128}, {"isize", NumericSuffix::Isize},
+        {"u8", NumericSuffix::U8}, {"u16", NumericSuffix::U16}, {"u32", NumericSuffix::U32},
+        {"u64", NumericSuffix::U64}, {"u128", NumericSuffix::U128}, {"usize", NumericSuffix::Usize},
+        {"f32", NumericSuffix::F32}, {"f64", NumericSuffix::F64},
+    };
+    for (const auto& [text, suffix_kind] : SUFFIXES) {
+        if (text == suffix) {
+            return suffix_kind;
+        }
+    }
+    return std::nullopt;
+}
+
+constexpr bool is_float_suffix(NumericSuffix suffix) {
+    return suffix == NumericSuffix::F32 || suffix == NumericSuffix::F64;
+}
+
+// Largest value of an integer suffix type; u128 max for unsuffixed literals.
+constexpr u128 max_value(NumericSuffix suffix) {
+    switch (suffix) {
+        case NumericSuffix::I8: return INT8_MAX;
+        case NumericSuffix::I16: return INT16_MAX;
+        case NumericSuffix::I32: return INT32_MAX;
+        case NumericSuffix::I64:
+        case NumericSuffix::Isize: return INT64_MAX;
+        case NumericSuffix::I128: return ~u128(0) >> 1;
+        case NumericSuffix::U8: return UINT8_MAX;
+        case NumericSuffix::U16: return UINT16_MAX;
+        case NumericSuffix::U32: return UINT32_MAX;
+        case NumericSuffix::U64:
+        case NumericSuffix::Usize: return UINT64_MAX;
+        default: return ~u128(0);
+    }
+}
+
+// Value of a numeric literal, stored once in the literal table.
+struct LiteralValue {
+    union {
+        // Integer literals, as written (no sign).
+        u128 integer = 0;
+        double floating;
+    };
+    NumericSuffix suffix = NumericSuffix::None;
+    bool is_float = false;
+
+    // The integer value as an `int`, if it fits.
+    std::optional<int> as_int() const {
+        if (is_float || integer > static_cast<u128>(std::numeric_limits<int>::max())) {
+            return std::nullopt;
+        }
+        return static_cast<int>(integer);
+    }
+};
+
+enum class LiteralError : uint8_t {
+    // `0x`, `0b_`
+    EmptyInt,
+    // `1e`, `1.5e+`
+    EmptyExponent,
+    // `0x1.5`, `0b1f32`
+    NonDecimalFloat,
+    // `1u7`, `1.5u8`
+    InvalidSuffix,
+    // `0b102`, `0o8`
+    InvalidDigit,
+    // Doesn't fit the suffix type, or 128 bits, or a double, or has more
+    // than MAX_FLOAT_DIGITS digits around `_` separators.
+    TooLarge
+};
+
+inline const char* describe(LiteralError error) {
+    switch (error) {
+        case LiteralError::EmptyInt: return "No valid digits found for number";
+        case LiteralError::EmptyExponent: return "Expected at least one digit in exponent";
+        case LiteralError::NonDecimalFloat: return "Float literals must be decimal";
+        case LiteralError::InvalidSuffix: return "Invalid suffix for number literal";
+        case LiteralError::InvalidDigit: return "Invalid digit for the base of number literal";
+        case LiteralError::TooLarge: return "Number literal is too large";
+    }
+    return "Invalid number literal";
+}
+
+namespace literal_detail {
+
+    // True if all eight bytes of `chunk` are ASCII digits.
+    inline bool all_digits(uint64_t chunk) {
+        // Digits are 0x30..0x39: the high nibble is 3, and adding 6 must not carry into it.
+        return (chunk & 0xF0F0F0F0F0F0F0F0ull) == 0x3030303030303030ull &&
+               ((chunk + 0x0606060606060606ull) & 0xF0F0F0F0F0F0F0F0ull) == 0x3030303030303030ull;
+    }
+
+    // Value of eight ASCII digits loaded little-endian, first digit in the low byte.
+    inline uint32_t eight_digits(uint64_t chunk) {
+        chunk -= 0x3030303030303030ull;
+        chunk = (chunk * 10) + (chunk >> 8);
+        chunk = (((chunk & 0x000000FF000000FFull) * (100 + (1000000ull << 32))) +
+                 (((chunk >> 16) & 0x000000FF000000FFull) * (1 + (10000ull << 32)))) >> 32;
+        return static_cast<uint32_t>(chunk);
+    }
+
+    inline bool parse_decimal(std::string_view digits, u128& value) {
+        const char* p = digits.data();
+        const char* end = p + digits.size();
+        while (p < end) {
+            uint64_t chunk;
+            if (end - p >= 8 && (std::memcpy(&chunk, p, 8), all_digits(chunk))) {
+                if (__builtin_mul_overflow(value, u128(100000000), &value) ||
+                    __builtin_add_overflow(value, u128(eight_digits(chunk)), &value)) {
+                    return false;
+                }
+                p += 8;
+                continue;
+            }
+            if (*p != '_') {
+                if (__builtin_mul_overflow(value, u128(10), &value) ||
+                    __builtin_add_overflow(value, u128(*p - '0'), &value)) {
+                    return false;
+                }
+            }
+            ++p;
+        }
+        return true;
+    }
+
+    inline int digit_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Binary, octal and hex: each digit is `bits` wide, so overflow is a shift check.
+    inline Result<u128, LiteralError> parse_power_of_two(std::string_view digits, unsigned base) {
+        const unsigned bits = base == 2 ? 1 : base == 8 ? 3 : 4;
+        u128 value = 0;
+        for (char c : digits) {
+            if (c == '_') {
+                continue;
+            }
+            const int digit = digit_value(c);
+            if (digit < 0 || static_cast<unsigned>(digit) >= base) {
+                return Result<u128, LiteralError>::Err(LiteralError::InvalidDigit);
+            }
+            if ((value >> (128 - bits)) != 0) {
+                return Result<u128, LiteralError>::Err(LiteralError::TooLarge);
+            }
+            value = (value << bits) | static_cast<unsigned>(digit);
+        }
+        return Result<u128, LiteralError>::Ok(value);
+    }
+
+    // Longest float literal, without its `_` separators, that parse_float accepts.
+    constexpr size_t MAX_FLOAT_DIGITS = 128;
+
+    inline Result<double, LiteralError> parse_float(std::string_view text) {
+        // `_` separators have to go before from_chars sees the text; they are
+        // stripped into a stack buffer, and longer literals with them are rejected.
+        char stripped[MAX_FLOAT_DIGITS];
+        if (text.find('_') != std::string_view::npos) {
+            size_t len = 0;
+            for (char c : text) {
+                if (c == '_') {
+                    continue;
+                }
+                if (len == MAX_FLOAT_DIGITS) {
+                    return Result<double, LiteralError>::Err(LiteralError::TooLarge);
+                }
+                stripped[len++] = c;
+            }
+            text = std::string_view(stripped, len);
+        }
+        double value = 0;
+        const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if (ec == std::errc::result_out_of_range || !std::isfinite(value)) {
+            return Result<double, LiteralError>::Err(LiteralError::TooLarge);
+        }
+        return Result<double, LiteralError>::Ok(value);
+    }
+
+} // namespace literal_detail
+
+/*
+Evaluates a numeric literal. `text` is the whole token and `token` the
+Literal token `number()` produced for it.
+*/
+inline Result<LiteralValue, LiteralError> literal_value(std::string_view text, const Token& token) {
+    using Res = Result<LiteralValue, LiteralError>;
+    assert(token.kind == TokenKind::Literal);
+
+    const std::string_view body = text.substr(0, token.suffix_start());
+    const std::optional<NumericSuffix> suffix = parse_suffix(text.substr(token.suffix_start()));
+    if (!suffix) {
+        return Res::Err(LiteralError::InvalidSuffix);
+    }
+
+    LiteralValue value;
+    value.suffix = *suffix;
+    value.is_float = token.literal_kind == LiteralKind::Float || is_float_suffix(*suffix);
+
+    if (token.literal_kind == LiteralKind::Int && token.empty_int()) {
+        return Res::Err(LiteralError::EmptyInt);
+    }
+
+    if (value.is_float) {
+        if (token.literal_kind == LiteralKind::Float && token.empty_exponent()) {
+            return Res::Err(LiteralError::EmptyExponent);
+        }
+        if (token.base() != Base::Decimal) {
+            return Res::Err(LiteralError::NonDecimalFloat);
+        }
+        if (*suffix != NumericSuffix::None && !is_float_suffix(*suffix)) {
+            return Res::Err(LiteralError::InvalidSuffix);
+        }
+        auto parsed = literal_detail::parse_float(body);
+        if (parsed.is_err()) {
+            return Res::Err(parsed.unwrap_err());
+        }
+        value.floating = parsed.unwrap();
+        if (*suffix == NumericSuffix::F32) {
+            const float narrowed = static_cast<float>(value.floating);
+            if (std::isinf(narrowed)) {
+                return Res::Err(LiteralError::TooLarge);
+            }
+            value.floating = narrowed;
+        }
+        return Res::Ok(value);
+    }
+
+    if (token.base() == Base::Decimal) {
+        u128 integer = 0;
+        if (!literal_detail::parse_decimal(body, integer)) {
+            return Res::Err(LiteralError::TooLarge);
+        }
+        value.integer = integer;
+    } else {
+        // Skip the `0x`/`0o`/`0b` prefix.
+        auto parsed = literal_detail::parse_power_of_two(body.substr(2), static_cast<unsigned>(token.base()));
+        if (parsed.is_err()) {
+            return Res::Err(parsed.unwrap_err());
+        }
+        value.integer = parsed.unwrap();
+    }
+
+    if (value.integer > max_value(*suffix)) {
+        return Res::Err(LiteralError::TooLarge);
+    }
+    return Res::Ok(value);
+}
+
+} // namespace lexer
+} // namespace amyr
@@ -28,31 +28,26 @@ The following is the official starting comming in compiler/rustc_lexer/src/lib.r
 */
 #pragma once
 
-#include<optional>
+#include<array>
 #include<cassert>
-#include<cctype>
-
+#include<cstdint>
+#include<optional>
+#include<string_view>
+#include<variant>
 
+#include "char_class.hpp"
 #include "cursor.hpp"
-#include "unicode_escape.hpp"
+#include "keyword_table.hpp"
 #include "amyr-utils/iterator.hpp"
-#include <unicode/uchar.h>
-#include <unicode/ustring.h>
-#include <unicode/stringpiece.h>
-
-/* Parsed token.
-It doesn't contain information about data that has been parsed,
-only the type of the token and its size.*/
-struct Token {
-    public:
-        TokenKind kind;
-        unsigned int len;
+#include "amyr-utils/result.hpp"
+#include "unicode_xid.hpp"
 
-        Token(TokenKind kind, unsigned int len)
-            : kind (kind), len (len) {}
-};
+// The low-level lexer lives in its own namespace so its `Token` can coexist
+// with the parser-facing one from tokenizer.hpp.
+namespace amyr {
+namespace lexer {
 
-enum class DocStyle {
+enum class DocStyle : uint8_t {
     Outer,
     Inner
 };
@@ -66,271 +61,226 @@ enum class Base: uint8_t {
 
     /// Literal doesn't contain a prefix.
     Decimal = 10,
-    
+
     /// Literal starts with "0x".
     Hexadecimal = 16
 
 };
 
-/// Enum representing the literal types supported by the lexer.
+/// The literal types supported by the lexer.
 ///
 /// Note that the suffix is *not* considered when deciding the `LiteralKind` in
 /// this type. This means that float literals like `1f32` are classified by this
-/// type as `Int`. 
-namespace namespace_Literal {
-    
+/// type as `Int`.
+enum class LiteralKind : uint8_t {
     // `12_u8`, `0o100`, `0b120i99`, `1f32`
-    struct Int {
-        Base base;
-        bool empty_int;
-
-        Int(Base base, bool empty_int)
-            : base(base), empty_int (empty_int) {}
-    };
-
-    
+    Int,
     // `12.34f32`, `1e3`, but not `1f32`.
-    struct Float {
-        Base base;
-        bool empty_exponent;
-
-        Float(Base base, bool empty_exponent)
-            : base(base), empty_exponent (empty_exponent) {}
-    };
-
-    
+    Float,
     // `'a'`, `'\\'`, `'''`, `';`
-    struct Char {
-        bool terminated;
-
-        Char (bool terminated)
-            : terminated (terminated) {}
-    };
-
+    Char,
     // `b'a'`, `b'\\'`, `b'''`, `b';`
-    struct Byte {
-        bool terminated;
+    Byte,
+    // `"abc"`, `"abc`
+    Str,
+    // `b"abc"`, `b"abc`
+    ByteStr,
+    // `c"abc"`, `c"abc`
+    CStr,
+    // `r"abc"`, `r#"abc"#`, `r####"ab"###"c"####`, `r#"a`.
+    RawStr,
+    // `br"abc"`, `br#"abc"#`, `br####"ab"###"c"####`, `br#"a`.
+    RawByteStr,
+    // `cr"abc"`, "cr#"abc"#", `cr#"a`.
+    RawCStr
+};
 
-        Byte (bool terminated)
-            : terminated (terminated) {}
-    };
+enum class TokenKind : uint8_t {
+    // A line comment, e.g. `// comment`.
+    LineComment,
 
-    // `"abc"`, `"abc`
-    struct Str {
-        bool terminated;
+    // A block comment, e.g. `/* block comment */`.
+    // Block comments can be recursive, so a sequence like `/* /* */`
+    // will not be considered terminated and will result in a parsing error.
+    BlockComment,
 
-        Str (bool terminated)
-            : terminated (terminated) {}
-    };
+    // Any whitespace character sequence.
+    Whitespace,
 
-    // `b"abc"`, `b"abc`
-    struct ByteStr {
-        bool terminated;
+    // An identifier or keyword, e.g. `ident` or `continue`.
+    Ident,
 
-        ByteStr (bool terminated)
-            : terminated (terminated) {}
-    };
+    // An identifier that contains emoji, e.g. `a😀`.
+    InvalidIdent,
 
-    // `c"abc"`, `c"abc`
-    struct CStr {
-        bool terminated;
+    // A raw identifier, e.g. "r#ident".
+    RawIdent,
 
-        CStr (bool terminated)
-            : terminated (terminated) {}
-    };
+    /*
+    An unknown literal prefix, like `foo#`, `foo'`, `foo"`. Excludes
+    literal prefixes that contain emoji, which are considered "invalid".
+
+    Note that only the
+    prefix (`foo`) is included in the token, not the separator (which is
+    lexed as its own distinct token). In Rust 2021 and later, reserved
+    prefixes are reported as errors; in earlier editions, they result in a
+    (allowed by default) lint, and are treated as regular identifier
+    tokens.
+    */
+    UnknownPrefix,
 
-    // `r"abc"`, `r#"abc"#`, `r####"ab"###"c"####`, `r#"a`. `None` indicates an invalid literal.
-    struct RawStr {
-        std::optional<unsigned short> n_hashes;
+    /*
+    An unknown prefix in a lifetime, like `'foo#`.
 
-        RawStr (std::optional<unsigned short> n_hashes) 
-            :n_hashes (n_hashes) {}
-    };
+    Like `UnknownPrefix`, only the `'` and prefix are included in the token
+    and not the separator.
+    */
+    UnknownPrefixLifetime,
 
-    // `br"abc"`, `br#"abc"#`, `br####"ab"###"c"####`, `br#"a`. `None` indicates an invalid literal.
-    struct RawByteStr {
-        std::optional<unsigned short> n_hashes;
+    /*
+    A raw lifetime, e.g. `'r#foo`. In edition < 2021 it will be split into
+    several tokens: `'r` and `#` and `foo`.
+    */
+    RawLifetime,
 
-        RawByteStr (std::optional<unsigned short> n_hashes) 
-            :n_hashes (n_hashes) {}
-    };
+    /*
+    Guarded string literal prefix: `#"` or `##`.
 
-    // `cr"abc"`, "cr#"abc"#", `cr#"a`. `None` indicates an invalid literal.
-    struct RawCStr {
-        std::optional<unsigned short> n_hashes;
+    Used for reserving "guarded strings" (RFC 3598) in edition 2024.
+    Split into the component tokens on older editions.
+    */
+    GuardedStrPrefix,
 
-        RawCStr (std::optional<unsigned short> n_hashes) 
-            :n_hashes (n_hashes) {}
-    };
-}
+    /*
+    Literals, e.g. `12u8`, `1.0e-40`, `b"123"`. Note that `_` is an invalid
+    suffix, but may be present here on string and float literals. Users of
+    this type will need to check for and reject that case.
 
-// Use a variant to hold one of the literal kinds.
-using LiteralKind = std::variant<
-    namespace_Literal::Int,
-    namespace_Literal::Float,
-    namespace_Literal::Char,
-    namespace_Literal::Byte,
-    namespace_Literal::Str,
-    namespace_Literal::ByteStr,
-    namespace_Literal::CStr,
-    namespace_Literal::RawStr,
-    namespace_Literal::RawByteStr,
-    namespace_Literal::RawCStr
->;
+    See [LiteralKind] for more details.
+    */
+    Literal,
 
-// Variants with associated data:
-// A line comment, e.g. `// comment`.
-struct LineComment {
-    std::optional<DocStyle> doc_style;
-};
+    // A lifetime, e.g. `'a`
+    Lifetime,
 
-//A block comment, e.g. `/* block comment */`.
-//Block comments can be recursive, so a sequence like `/* /* */`
-//will not be considered terminated and will result in a parsing error.*/
-struct BlockComment {
-    std::optional<DocStyle> doc_style;
-    bool terminated;
+    Semi,         // ;
+    Comma,        // ,
+    Dot,          // .
+    OpenParen,    // (
+    CloseParen,   // )
+    OpenBrace,    // {
+    CloseBrace,   // }
+    OpenBracket,  // [
+    CloseBracket, // ]
+    At,           // @
+    Pound,        // #
+    Tilde,        // ~
+    Question,     // ?
+    Colon,        // :
+    Dollar,       // $
+    Eq,           // =
+    Bang,         // !
+    Lt,           // <
+    Gt,           // >
+    Minus,        // -
+    And,          // &
+    Or,           // |
+    Plus,         // +
+    Star,         // *
+    Slash,        // /
+    Caret,        // ^
+    Percent,      // %
+    Unknown,      // unknown token (e.g. "№")
+    Eof           // end of input
 };
 
-/*A literal token carries a literal kind and the start position of its suffix.
-Literals, e.g. `12u8`, `1.0e-40`, `b"123"`. Note that `_` is an invalid
-suffix, but may be present here on string and float literals. Users of
-this type will need to check for and reject that case.
+/* Parsed token.
+It doesn't contain information about data that has been parsed,
+only the type of the token, its size and a small payload:
 
-See [LiteralKind] for more details.
+- Literal: `literal_kind`, the suffix start, and in `aux` the base of a number
+  or the hash count of a raw string.
+- LineComment/BlockComment: the doc style, and whether a block comment is terminated.
+- Ident: the pre-interned keyword Symbol, or `kw::Empty` for plain identifiers.
+- Lifetime: whether it starts with a number.
 */
-struct Literal {
-    LiteralKind kind;
-    uint32_t suffix_start;
-};
+struct Token {
+    public:
+        enum Flags : uint8_t {
+            // Strings, chars and block comments.
+            TERMINATED = 1 << 0,
+            // `empty_int` for Int literals, `empty_exponent` for Float literals.
+            EMPTY = 1 << 1,
+            // `aux` holds a DocStyle.
+            HAS_DOC_STYLE = 1 << 2,
+            // `aux` holds the hash count of a raw string. Cleared for invalid raw strings.
+            HAS_HASHES = 1 << 3,
+            STARTS_WITH_NUMBER = 1 << 4
+        };
 
-// A lifetime, e.g. `'a`
-struct Lifetime {
-    bool starts_with_number;
-};
+        TokenKind kind;
+        LiteralKind literal_kind = LiteralKind::Int;
+        uint8_t aux = 0;
+        uint8_t flags = 0;
+        // Suffix start for literals, keyword Symbol for identifiers.
+        uint32_t data = 0;
+        unsigned int len;
 
-// The following tokens carry no extra data; they are used as “tags.”
-// Any whitespace character sequence.
-struct Whitespace {};
+        Token(TokenKind kind, unsigned int len = 0)
+            : kind (kind), len (len) {}
 
-// An identifier or keyword, e.g. `ident` or `continue`.
-struct Ident {};
+        static Token literal(LiteralKind lit_kind, uint32_t suffix_start, uint8_t flags = 0, uint8_t aux = 0) {
+            Token token(TokenKind::Literal);
+            token.literal_kind = lit_kind;
+            token.data = suffix_start;
+            token.flags = flags;
+            token.aux = aux;
+            return token;
+        }
 
-// An identifier or keyword, e.g. `ident` or `continue`.
-struct InvalidIdent {};
+        static Token comment(TokenKind kind, std::optional<DocStyle> doc_style, bool terminated = true) {
+            Token token(kind);
+            if (doc_style) {
+                token.flags |= HAS_DOC_STYLE;
+                token.aux = static_cast<uint8_t>(*doc_style);
+            }
+            if (terminated) {
+                token.flags |= TERMINATED;
+            }
+            return token;
+        }
 
-// A raw identifier, e.g. "r#ident".
-struct RawIdent {};
+        std::optional<DocStyle> doc_style() const {
+            if (flags & HAS_DOC_STYLE) {
+                return static_cast<DocStyle>(aux);
+            }
+            return std::nullopt;
+        }
 
-/*
-An unknown literal prefix, like `foo#`, `foo'`, `foo"`. Excludes
-literal prefixes that contain emoji, which are considered "invalid".
-
-Note that only the
-prefix (`foo`) is included in the token, not the separator (which is
-lexed as its own distinct token). In Rust 2021 and later, reserved
-prefixes are reported as errors; in earlier editions, they result in a
-(allowed by default) lint, and are treated as regular identifier
-tokens.
-*/
-struct UnknownPrefix {};
+        bool terminated() const { return flags & TERMINATED; }
 
-/*
-An unknown prefix in a lifetime, like `'foo#`.
+        bool empty_int() const { return flags & EMPTY; }
 
-Like `UnknownPrefix`, only the `'` and prefix are included in the token
-and not the separator.
-*/
-struct UnknownPrefixLifetime {};
+        bool empty_exponent() const { return flags & EMPTY; }
 
-/*
-A raw lifetime, e.g. `'r#foo`. In edition < 2021 it will be split into
-several tokens: `'r` and `#` and `foo`.
-*/
-struct RawLifetime {};
+        Base base() const { return static_cast<Base>(aux); }
 
-/*
-Guarded string literal prefix: `#"` or `##`.
+        // `None` indicates an invalid raw string literal.
+        std::optional<uint8_t> n_hashes() const {
+            if (flags & HAS_HASHES) {
+                return aux;
+            }
+            return std::nullopt;
+        }
 
-Used for reserving "guarded strings" (RFC 3598) in edition 2024.
-Split into the component tokens on older editions.
-*/
-struct GuardedStrPrefix {};
-
-struct Semi {};         // ;
-struct Comma {};        // ,
-struct Dot {};          // .
-struct OpenParen {};    // (
-struct CloseParen {};   // )
-struct OpenBrace {};    // {
-struct CloseBrace {};   // }
-struct OpenBracket {};  // [
-struct CloseBracket {}; // ]
-struct At {};           // @
-struct Pound {};        // #
-struct Tilde {};        // ~
-struct Question {};     // ?
-struct Colon {};        // :
-struct Dollar {};       // $
-struct Eq {};           // =
-struct Bang {};         // !
-struct Lt {};           // <
-struct Gt {};           // >
-struct Minus {};        // -
-struct And {};          // &
-struct Or {};           // |
-struct Plus {};         // +
-struct Star {};         // *
-struct Slash {};        // /
-struct Caret {};        // ^
-struct Percent {};      // %
-struct Unknown {};      // unknown token (e.g. "№")
-struct Eof {};          // end of input
-
-// TokenKind is represented as a variant over all possible kinds.
-using TokenKind = std::variant<
-    LineComment,
-    BlockComment,
-    Whitespace,
-    Ident,
-    InvalidIdent,
-    RawIdent,
-    UnknownPrefix,
-    UnknownPrefixLifetime,
-    RawLifetime,
-    GuardedStrPrefix,
-    Literal,
-    Lifetime,
-    Semi,
-    Comma,
-    Dot,
-    OpenParen,
-    CloseParen,
-    OpenBrace,
-    CloseBrace,
-    OpenBracket,
-    CloseBracket,
-    At,
-    Pound,
-    Tilde,
-    Question,
-    Colon,
-    Dollar,
-    Eq,
-    Bang,
-    Lt,
-    Gt,
-    Minus,
-    And,
-    Or,
-    Plus,
-    Star,
-    Slash,
-    Caret,
-    Percent,
-    Unknown,
-    Eof
->;
+        uint32_t suffix_start() const { return data; }
+
+        amyr::span::Symbol keyword() const { return amyr::span::Symbol(data); }
+
+        bool starts_with_number() const { return flags & STARTS_WITH_NUMBER; }
+};
+
+static_assert(sizeof(Token) <= 12, "low-level tokens should stay small");
 
 /*`#"abc"#`, `##"a"` (fewer closing), or even `#"a` (unterminated).
 
@@ -371,17 +321,51 @@ using RawStrError = std::variant<
     TooManyDelimiters
 >;
 
+Token advance_token(Cursor &cursor);
+inline Result<uint8_t, RawStrError> raw_double_quoted_string(Cursor &cursor, uint32_t prefix_len);
+inline Result<uint32_t, RawStrError> raw_string_unvalidated(Cursor &cursor, uint32_t prefix_len);
+inline bool eat_decimal_digits(Cursor &cursor);
+inline bool eat_hexadecimal_digits(Cursor &cursor);
+inline bool eat_float_exponent(Cursor &cursor);
+inline void eat_literal_suffix(Cursor &cursor);
+inline void eat_identifier(Cursor &cursor);
+inline bool single_quoted_string(Cursor &cursor);
+inline bool double_quoted_string(Cursor &cursor);
+inline Token invalid_ident(Cursor &cursor);
+
+// Creates an iterator that produces tokens from the input string.
+class TokenIterator: public Iterator<TokenIterator, Token>{
+    Cursor cursor;
+
+public:
+    explicit TokenIterator(std::string_view input)
+        : cursor(input) {}
+
+    std::optional<Token> next() {
+        Token token = advance_token(cursor);
+
+        if (token.kind == TokenKind::Eof) {
+            return std::nullopt;
+        }
+        return token;
+    }
+};
+
+inline TokenIterator tokenize(std::string_view input) {
+    return TokenIterator(input);
+}
+
 /// `rustc` allows files to have a shebang, e.g. "#!/usr/bin/rustrun",
 /// but shebang isn't a part of rust syntax.
-std::optional<size_t> strip_shebang(const std::string &input) {
+inline std::optional<size_t> strip_shebang(std::string_view input) {
     // Shebang must start with "#!" literally, without any preceding whitespace.
     // For simplicity we consider any line starting with "#!" a shebang,
     // regardless of restrictions put on shebangs by specific platforms.
     if (input.size() < 2 || input[0] != '#' || input[1] != '!') {
         return std::nullopt;
     }
-    
-    std::string input_tail = input.substr(2);
+
+    std::string_view input_tail = input.substr(2);
     // Ok, this is a shebang but if the next non-whitespace token is '[',
     // then it may be valid Rust code, so consider it Rust code.
     auto iter = tokenize(input_tail);
@@ -389,17 +373,17 @@ std::optional<size_t> strip_shebang(const std::string &input) {
 
     // Find first non-whitespace/non-trivial-comment token
     while (auto token = iter.next()) {
-        const auto& kind = token->kind;
-        
         bool is_ignorable = false;
-        if (std::holds_alternative<Whitespace>(kind)) {
-            is_ignorable = true;
-        }
-        else if (const auto* lc = std::get_if<LineComment>(&kind)) {
-            is_ignorable = (lc->doc_style == std::nullopt);
-        }
-        else if (const auto* bc = std::get_if<BlockComment>(&kind)) {
-            is_ignorable = (bc->doc_style == std::nullopt);
+        switch (token->kind) {
+            case TokenKind::Whitespace:
+                is_ignorable = true;
+                break;
+            case TokenKind::LineComment:
+            case TokenKind::BlockComment:
+                is_ignorable = !token->doc_style().has_value();
+                break;
+            default:
+                break;
         }
 
         if (!is_ignorable) {
@@ -409,11 +393,10 @@ std::optional<size_t> strip_shebang(const std::string &input) {
     }
 
     // Check if first significant token is OpenBracket
-    if (first_significant && 
-        !std::holds_alternative<OpenBracket>(first_significant->kind)) {
+    if (first_significant && first_significant->kind != TokenKind::OpenBracket) {
         // Calculate shebang length including newline
         const size_t newline_pos = input_tail.find('\n');
-        const size_t line_length = (newline_pos != std::string::npos)
+        const size_t line_length = (newline_pos != std::string_view::npos)
                                   ? newline_pos
                                   : input_tail.length();
         return 2 + line_length; // Include the original "#!" prefix
@@ -427,7 +410,7 @@ std::optional<size_t> strip_shebang(const std::string &input) {
 Validates a raw string literal. Used for getting more information about a
 problem with a `RawStr`/`RawByteStr` with a `None` field.
 */
-inline Result<void, RawStrError> validate_raw_string(std::string &input, uint32_t prefix_len) {
+inline Result<std::monostate, RawStrError> validate_raw_string(std::string_view input, uint32_t prefix_len) {
     assert(!input.empty());
     Cursor cursor(input);
 
@@ -435,41 +418,18 @@ inline Result<void, RawStrError> validate_raw_string(std::string &input, uint32_
     for(uint32_t i = 0; i < prefix_len; ++i) {
         std::optional<char> bump = cursor.bump();
         if(!bump.has_value()) {
-            return Result<void, RawStrError>::Err(NoTerminator{});
+            return Result<std::monostate, RawStrError>::Err(NoTerminator{});
         }
     }
 
     // Call raw_double_quoted_string and map its result to void.
     Result<uint8_t, RawStrError> res = raw_double_quoted_string(cursor, prefix_len);
     if (res.is_err()) {
-        RawStrError res1 = res.unwrap_err();
-        return Result<void, RawStrError>::Err(res1); // Propagate the error.
-    } 
-    
-    return Result<void, RawStrError>::Ok(std::nullopt);
-    
-}
-
-// Creates an iterator that produces tokens from the input string.
-class TokenIterator: Iterator<TokenIterator, Token>{
-    Cursor cursor;
-
-public:
-    explicit TokenIterator(std::string &input) 
-        : cursor(input) {}
-
-    std::optional<Token> next() {
-        Token token = advance_token(cursor);
-        
-        if (std::holds_alternative<Eof>(token.kind)) {
-            return std::nullopt;
-        } 
-        return token;
+        return Result<std::monostate, RawStrError>::Err(res.unwrap_err()); // Propagate the error.
     }
-}; 
 
-TokenIterator tokenize(std::string &input) {
-    return TokenIterator(input);
+    return Result<std::monostate, RawStrError>::Ok(std::monostate{});
+
 }
 
 /*
@@ -477,19 +437,16 @@ True if `c` is considered a whitespace according to Rust language definition.
 See [Rust language reference](https://doc.rust-lang.org/reference/whitespace.html)
 for definitions of these classes.
 */
-bool is_whitespace(char c) {
+inline bool is_whitespace(char32_t c) {
     // This is Pattern_White_Space.
     //
     // Note that this set is stable (ie, it doesn't change with different
     // Unicode versions), so it's ok to just hard-code the values.
 
+    if (c < 0x80) {
+        return is_ascii_whitespace(c);
+    }
     switch (c) {
-        case U'\u0009':  // \t (Horizontal tab)
-        case U'\u000A':  // \n (Line feed)
-        case U'\u000B':  // \v (Vertical tab)
-        case U'\u000C':  // \f (Form feed)
-        case U'\u000D':  // \r (Carriage return)
-        case U'\u0020':  // Space
         case U'\u0085':  // Next line (NEL)
         case U'\u200E':  // Left-to-Right Mark
         case U'\u200F':  // Right-to-Left Mark
@@ -502,232 +459,66 @@ bool is_whitespace(char c) {
 }
 
 // True if `c` is valid as a first character of an identifier.
-bool is_id_start(char32_t c) {
-    // Check for underscore or Unicode XID_Start property
-    return c == U'_' || u_isIDStart(static_cast<UChar32>(c));
+inline bool is_id_start(char32_t c) {
+    if (c < 0x80) {
+        return is_ascii_id_start(c);
+    }
+    return amyr::unicode::is_xid_start(c);
 }
 
 // True if `c` is valid as a non-first character of an identifier.
-bool is_id_continue(char32_t c) {
-    // Check for Unicode XID_Continue property
-    return u_isIDPart(static_cast<UChar32>(c));
+inline bool is_id_continue(char32_t c) {
+    if (c < 0x80) {
+        return is_ascii_id_continue(c);
+    }
+    return amyr::unicode::is_xid_continue(c);
 }
 
-struct CharIterator: Iterator<CharIterator, char> {
-    std::string &input;
+// Iterates over the characters of UTF-8 text.
+struct CharIterator: Iterator<CharIterator, char32_t> {
+    std::string_view input;
     size_t len;
     size_t current;
 
 public:
-    explicit CharIterator(std::string &input) 
+    explicit CharIterator(std::string_view input)
         : input(input) {
             len = input.length();
             current=0;
         }
-    
-    std::optional<char> next() {
+
+    std::optional<char32_t> next() {
         if (current < len) {
-            return input[current++];
+            size_t char_len;
+            const char32_t c = amyr::unicode::decode(input.data() + current, input.data() + len, char_len);
+            current += char_len;
+            return c;
         } else {
             return std::nullopt;
         }
     }
 };
 
-bool is_ident(std::string &str) {
+inline bool is_ident(std::string_view str) {
     CharIterator chars = CharIterator(str);
 
     if (auto start = chars.next()) {
-        if (start.has_value()) {
-            return is_id_start(start.value()) && chars.all(is_id_continue);
-        } else {
-            return false;
-        }
-    }
-
-}
-
-// From here on out, we just extend the functionality of Cursor class
-// Eats the double-quoted string and returns `n_hashes` and an error if encountered.
-Result<uint8_t, RawStrError> raw_double_quoted_string(Cursor &cursor, uint32_t prefix_len) {
-    // Wrap the actual function to handle the error with too many hashes.
-    // This way, it eats the whole raw string.
-
-    Result<uint32_t, RawStrError> n_hashes = raw_string_unvalidated(cursor, prefix_len);
-    uint32_t n_hashes1 = n_hashes.unwrap();
-    //only upto 255 `#`s are allowed in a string
-    if(n_hashes1 > 255) {
-        Result<uint8_t, RawStrError>::Ok(uint8_t(n_hashes1));
-    } else {
-        Result<uint8_t, RawStrError>::Err(TooManyDelimiters{found: n_hashes1});
+        return is_id_start(start.value()) && chars.all(is_id_continue);
     }
+    return false;
 }
 
-Token advance_token(Cursor &cursor) {
-    size_t start_pos = cursor.pos();
-
-    auto bump = cursor.bump();
-    if (!bump.has_value()) {
-        return Token(TokenKind(Eof{}), 0);
-    }
-
-    char32_t first_char = bump.value();
-
-    TokenKind kind;
-
-    switch(first_char) {
-        //Slash, line comment or block comment
-        case '/': {
-            char next_char = cursor.first();
-            if (next_char == '/') {
-                kind = line_comment(cursor);
-            } else if (next_char == '*') {
-                kind = block_comment(cursor);
-            } else {
-                kind = TokenKind(Slash{});
-            }
-            break;
-        }
-
-        //Whitespace
-        case U'\u0009':  // \t (Horizontal tab)
-        case U'\u000A':  // \n (Line feed)
-        case U'\u000B':  // \v (Vertical tab)
-        case U'\u000C':  // \f (Form feed)
-        case U'\u000D':  // \r (Carriage return)
-        case U'\u0020':  // Space
-        case U'\u0085':  // Next line (NEL)
-        case U'\u200E':  // Left-to-Right Mark
-        case U'\u200F':  // Right-to-Left Mark
-        case U'\u2028':  // Line Separator
-        case U'\u2029': { // Paragraph Separator
-        
-            kind = whitespace(cursor);
-            break;
-        }
-
-        case 'r': {
-            char next1 = cursor.first();
-            char next2 = cursor.second();
-            
-            if (next1 == '#' && is_id_start(next2)) {
-                kind = raw_ident(cursor);
-            } else if (next1 == '#' || next1 == '"') {
-                auto res = raw_double_quoted_string(cursor, 1);
-                const uint32_t suffix_start = cursor.pos_within_token();
-
-                if(res.is_ok()) {
-                    eat_literal_suffix(cursor);
-                }
-                kind = Literal{namespace_Literal::RawStr {res.unwrap()}, suffix_start};
-            } else {
-                kind = ident_or_unknown_prefix(cursor);
-            }
-            break;
-        }
-
-        case 'b': {
-            kind = c_or_byte_string(
-                cursor,
-                /*byte_str_handler*/ [] (bool t) {return namespace_Literal::ByteStr{t};},
-                /*raw_byte_str_handler*/ [] (auto h) {return namespace_Literal::RawByteStr{h};},
-                /*byte_handler*/ [] (bool t) {return namespace_Literal::Byte{t};}
-            );
-            break;
-        }
-
-        case 'c': {
-            kind = c_or_byte_string(
-                cursor,
-                /*c_str_handler*/ [] (bool t) {return namespace_Literal::CStr{t};},
-                /*raw_c_str_handler*/ [] (auto h) {return namespace_Literal::RawCStr{h};},
-                /*no_char_handler*/ nullptr
-            );
-            break;
-        }
-
-        case '0'...'9': {
-            auto lit_kind = number(cursor, first_char);
-            const uint32_t suffix_start = cursor.pos_within_token();
-            eat_literal_suffix(cursor);
-            kind = Literal{lit_kind, suffix_start};
-            break;
-        }
-
-        case ';': kind = Semi{}; break;
-        case ',': kind = Comma{}; break;
-        case '.': kind = Dot{}; break;
-        case '(': kind = OpenParen{}; break;
-        case ')': kind = CloseParen{}; break;
-        case '{': kind = OpenBrace{}; break;
-        case '}': kind = CloseBrace{}; break;
-        case '[': kind = OpenBracket{}; break;
-        case ']': kind = CloseBracket{}; break;
-        case '@': kind = At{}; break;
-        case '#': kind = Pound{}; break;
-        case '~': kind = Tilde{}; break;
-        case '?': kind = Question{}; break;
-        case ':': kind = Colon{}; break;
-        case '$': kind = Dollar{}; break;
-        case '=': kind = Eq{}; break;
-        case '!': kind = Bang{}; break;
-        case '<': kind = Lt{}; break;
-        case '>': kind = Gt{}; break;
-        case '-': kind = Minus{}; break;
-        case '&': kind = And{}; break;
-        case '|': kind = Or{}; break;
-        case '+': kind = Plus{}; break;
-        case '*': kind = Star{}; break;
-        case '^': kind = Caret{}; break;
-        case '%': kind = Percent{}; break;
-
-        // Lifetime or character literal
-        case '\'': {
-            kind = lifetime_or_char(cursor);
-            break;
-        }
-
-        // String literal
-        case '"': {
-            const bool terminated = double_quoted_string(cursor);
-            const uint32_t suffix_start = cursor.pos_within_token();
-            if (terminated) {
-                eat_literal_suffix(cursor);
-            }
-            kind = Literal{namespace_Literal::Str{terminated}, suffix_start};
-            break;
-        }
-
-        default: {
-            if (is_id_start(first_char)) {
-                kind = ident_or_unknown_prefix(cursor);
-            } else if (!is_ascii(first_char) && isemoji(first_char)) {
-                kind = invalid_ident(cursor);
-            } else {
-                kind = Unknown{};
-            }
-            break;
-        }
-    }
-
-    Token res = Token(kind, cursor.pos_within_token());
-    cursor.reset_pos_within_token();
-    return res; 
-}
-
-bool is_ascii(char32_t c) {
-    return c >= 0 && c <= 127;
-}
-
-bool is_ascii_digit(char32_t c) {
-    return c >= '0' && c <= '9';
+inline bool is_ascii(char32_t c) {
+    return c <= 127;
 }
 
-bool isemoji(char32_t c) {
+inline bool isemoji(char32_t c) {
     return (c >= 0x1F600 && c <= 0x1F64F);
 }
 
-TokenKind line_comment(Cursor &cursor) {
+// From here on out, we just extend the functionality of Cursor class
+
+inline Token line_comment(Cursor &cursor) {
     // Consume the line comment
     assert(cursor.prev() == '/' && cursor.first() == '/');
     cursor.bump();
@@ -744,10 +535,10 @@ TokenKind line_comment(Cursor &cursor) {
 
     cursor.eat_until('\n');
 
-    return TokenKind(LineComment{doc_style});
+    return Token::comment(TokenKind::LineComment, doc_style);
 }
 
-TokenKind block_comment(Cursor &cursor) {
+inline Token block_comment(Cursor &cursor) {
     // Consume the block comment
     assert(cursor.prev() == '/' && cursor.first() == '*');
     cursor.bump(); //Consume the '*'
@@ -761,85 +552,104 @@ TokenKind block_comment(Cursor &cursor) {
         doc_style = DocStyle::Outer;
     }
 
-    //Handle nested block comments
+    //Handle nested block comments.
+    //Only `/*` and `*/` change the depth, so jump straight from one to the next.
+    //A lone `*` or `/` never stops the scan, and the first pair found is the one
+    //a byte-by-byte scan would have stopped at.
     size_t depth = 1;
-    while (auto c = cursor.bump()) {
-        if (c == '/' && cursor.first() == '*') {
-            cursor.bump();
+    while (true) {
+        cursor.eat_until_either_pair('/', '*');
+        auto c = cursor.bump();
+        if (!c.has_value()) {
+            break;
+        }
+        cursor.bump(); // Consume the second half of the pair
+        if (c == '/') {
             depth++;
-        } else if (c == '*' && cursor.first() == '/') {
-            cursor.bump(); // Consume the '/'
-            if (--depth == 0) {
-                return BlockComment{doc_style, true};
-            }
+        } else if (--depth == 0) {
+            return Token::comment(TokenKind::BlockComment, doc_style, true);
         }
     }
-    return BlockComment{doc_style, false};
+    return Token::comment(TokenKind::BlockComment, doc_style, false);
 }
 
-TokenKind whitespace(Cursor &cursor) {
+inline Token whitespace(Cursor &cursor) {
     // Consume the whitespace
-    assert(is_whitespace(cursor.prev()));
-    cursor.eat_while(is_whitespace);
+    // Skip the common ASCII run in bulk, then finish with the full predicate.
+    cursor.eat_ascii_whitespace();
+    cursor.eat_while_char(is_whitespace);
 
-    return TokenKind(Whitespace{});
+    return Token(TokenKind::Whitespace);
 }
 
-TokenKind raw_ident(Cursor &cursor) {
-    assert(cursor.prev() == 'r' && cursor.first() == '#' && is_id_start(cursor.second()));
+inline Token raw_ident(Cursor &cursor) {
+    assert(cursor.prev() == 'r' && cursor.first() == '#' && is_id_start(cursor.peek_char(1)));
     //Eat the `#` symbol
     cursor.bump();
     //Eat the identifier as part of RawIdent
     eat_identifier(cursor);
-    return TokenKind(RawIdent{});
+    return Token(TokenKind::RawIdent);
 }
 
-TokenKind ident_or_unknown_prefix(Cursor &cursor) {
-    assert(is_id_start(cursor.prev()));
+inline Token ident_or_unknown_prefix(Cursor &cursor) {
     //Start already eaten, eat the rest of the identifier
-    cursor.eat_while(is_id_continue);
+    cursor.eat_while_char(is_id_continue);
     // Known prefixes must have been handled earlier. So if
     // we see a prefix here, it is definitely an unknown prefix.
-    const char32_t c = cursor.first();
+    const char32_t c = cursor.first_char();
     if (c == '#' || c == '\'' || c == '"') {
-        return TokenKind(UnknownPrefix{});
+        return Token(TokenKind::UnknownPrefix);
     } else if (!is_ascii(c) && isemoji(c)) {
         return invalid_ident(cursor);
     }
-    return TokenKind(Ident{});
+    Token token(TokenKind::Ident);
+    token.data = lookup_keyword(cursor.token_text()).as_u32();
+    return token;
 }
 
-TokenKind invalid_ident(Cursor &cursor) {
+inline Token invalid_ident(Cursor &cursor) {
     // Start is already eaten, eat the rest of the identifier
-    cursor.eat_while([] (char32_t c) {
-        const char ZERO_WIDTH_JOINER = U'\u200D';
-        return is_id_continue(c) || c == ZERO_WIDTH_JOINER || !is_ascii(c) && isemoji(c);
+    cursor.eat_while_char([] (char32_t c) {
+        const char32_t ZERO_WIDTH_JOINER = U'\u200D';
+        return is_id_continue(c) || c == ZERO_WIDTH_JOINER || (!is_ascii(c) && isemoji(c));
     });
     // An invalid identifier followed by '#' or '"' or '\'' could be
     // interpreted as an invalid literal prefix. We don't bother doing that
     // because the treatment of invalid identifiers and invalid prefixes
     // would be the same.
-    return TokenKind(InvalidIdent{});
+    return Token(TokenKind::InvalidIdent);
+}
+
+// Flags and aux byte describing a lexed raw string: its hash count, or nothing if invalid.
+inline Token raw_literal(LiteralKind kind, uint32_t suffix_start, const Result<uint8_t, RawStrError>& res) {
+    if (res.is_ok()) {
+        return Token::literal(kind, suffix_start, Token::HAS_HASHES, res.unwrap());
+    }
+    return Token::literal(kind, suffix_start);
 }
 
-TokenKind c_or_byte_string(
+/*
+Lexes a `b` or `c` prefixed literal: `str_kind` for `b"..."`/`c"..."`,
+`raw_kind` for the raw forms and `char_kind`, if any, for `b'...'`.
+Anything else is an identifier starting with the prefix.
+*/
+inline Token c_or_byte_string(
     Cursor &cursor,
-    std::function<LiteralKind(bool)> mk_kind,
-    std::function<LiteralKind(std::optional<unsigned short>)> mk_kind_raw,
-    std::optional<std::function<LiteralKind(bool)>> single_quoted 
+    LiteralKind str_kind,
+    LiteralKind raw_kind,
+    std::optional<LiteralKind> char_kind
 ) {
     char32_t next1 = cursor.first();
     char32_t next2 = cursor.second();
 
-    if (next1 == '\'' && single_quoted.has_value()) {
+    if (next1 == '\'' && char_kind.has_value()) {
         cursor.bump();
         bool terminated = single_quoted_string(cursor);
         uint32_t suffix_start = cursor.pos_within_token();
         if (terminated) {
             eat_literal_suffix(cursor);
         }
-        LiteralKind kind = single_quoted.value()(terminated);
-        return TokenKind(Literal{kind, suffix_start});
+        return Token::literal(*char_kind, suffix_start, terminated ? Token::TERMINATED : 0);
     } else if (next1 == '"') {
         cursor.bump();
         bool terminated = double_quoted_string(cursor);
@@ -849,8 +659,7 @@ TokenKind c_or_byte_string(
             eat_literal_suffix(cursor);
         }
 
-        LiteralKind kind = mk_kind(terminated);
-        return TokenKind(Literal{kind, suffix_start});
+        return Token::literal(str_kind, suffix_start, terminated ? Token::TERMINATED : 0);
     } else if (next1=='r' && (next2=='"' || next2=='#')) {
         cursor.bump();
         Result<uint8_t, RawStrError> res = raw_double_quoted_string(cursor, 2);
@@ -858,18 +667,25 @@ TokenKind c_or_byte_string(
         if (res.is_ok()) {
             eat_literal_suffix(cursor);
         }
-        LiteralKind kind = mk_kind_raw(res.ok());
-        return TokenKind(Literal{kind, suffix_start});
+        return raw_literal(raw_kind, suffix_start, res);
     } else {
-        ident_or_unknown_prefix(cursor);
+        return ident_or_unknown_prefix(cursor);
     }
 }
 
-LiteralKind number(Cursor &cursor, char32_t first_char) {
+// Lexes a number; the caller fills in the suffix start.
+inline Token number(Cursor &cursor, char32_t first_char) {
     // Consume the number
     assert(first_char >= '0' && first_char <= '9');
-    
+
     Base base = Base::Decimal;
+    auto int_literal = [&base] (bool empty_int) {
+        return Token::literal(LiteralKind::Int, 0, empty_int ? Token::EMPTY : 0, static_cast<uint8_t>(base));
+    };
+    auto float_literal = [&base] (bool empty_exponent) {
+        return Token::literal(LiteralKind::Float, 0, empty_exponent ? Token::EMPTY : 0, static_cast<uint8_t>(base));
+    };
+
     if (first_char == '0') {
         char32_t next = cursor.first();
         // Attempt to parse encoding base.
@@ -878,16 +694,16 @@ LiteralKind number(Cursor &cursor, char32_t first_char) {
                 base = Base::Binary;
                 cursor.bump();
                 if (!eat_decimal_digits(cursor)) {
-                    return namespace_Literal::Int{base, true};
+                    return int_literal(true);
                 }
                 break;
             }
-            
+
             case 'o': {
                 base = Base::Octal;
                 cursor.bump();
                 if (!eat_decimal_digits(cursor)) {
-                    return namespace_Literal::Int{base, true};
+                    return int_literal(true);
                 }
                 break;
             }
@@ -895,14 +711,14 @@ LiteralKind number(Cursor &cursor, char32_t first_char) {
                 base = Base::Hexadecimal;
                 cursor.bump();
                 if (!eat_hexadecimal_digits(cursor)) {
-                    return namespace_Literal::Int{base, true};
+                    return int_literal(true);
                 }
                 break;
             }
 
             // Not a base prefix; consume additional digits.
-             
-            case '_': 
+
+            case '_':
             case '0'...'9':{
                 eat_decimal_digits(cursor);
                 break;
@@ -919,8 +735,7 @@ LiteralKind number(Cursor &cursor, char32_t first_char) {
 
             default:
                 //Just a 0
-                return namespace_Literal::Int{base, false};
-                break;
+                return int_literal(false);
         }
     } else {
          // No base prefix, parse number in the usual way.
@@ -931,7 +746,7 @@ LiteralKind number(Cursor &cursor, char32_t first_char) {
     // Don't be greedy if this is actually an
     // integer literal followed by field/method access or a range pattern
     // (`0..2` and `12.foo()`)
-    if(next == '.' && cursor.second() != '.' && !is_id_start(cursor.second())) {
+    if(next == '.' && cursor.second() != '.' && !is_id_start(cursor.peek_char(1))) {
         // might have stuff after the ., and if it does, it needs to start
         // with a number
         cursor.bump();
@@ -950,29 +765,29 @@ LiteralKind number(Cursor &cursor, char32_t first_char) {
                     break;
             }
         }
-        return namespace_Literal::Float{base, empty_exponent};
+        return float_literal(empty_exponent);
     } else if (next == 'e' || next == 'E') {
         cursor.bump();
         bool empty_exponent = !eat_float_exponent(cursor);
-        return namespace_Literal::Float{base, empty_exponent};
+        return float_literal(empty_exponent);
     } else {
         // No exponent, just an integer literal.
-        return namespace_Literal::Int{base, false};
+        return int_literal(false);
     }
 }
 
-TokenKind lifetime_or_char(Cursor &cursor) {
+inline Token lifetime_or_char(Cursor &cursor) {
     assert(cursor.prev() == '\'');
 
     bool can_be_lifetime;
-    if (cursor.second() == '\'') {
+    if (cursor.peek_char(1) == '\'') {
         // It's surely not a lifetime.
         can_be_lifetime = false;
     } else {
         // If the first symbol is valid for identifier, it can be a lifetime.
         // Also check if it's a number for a better error reporting (so '0 will
         // be reported as invalid lifetime and not as unterminated char literal).
-        can_be_lifetime = is_id_start(cursor.first()) || is_ascii_digit(cursor.first());
+        can_be_lifetime = is_id_start(cursor.first_char()) || is_ascii_digit(cursor.first());
     }
 
     if (!can_be_lifetime) {
@@ -981,17 +796,16 @@ TokenKind lifetime_or_char(Cursor &cursor) {
         if (terminated) {
             eat_literal_suffix(cursor);
         }
-        LiteralKind kind = namespace_Literal::Char{terminated};
-        return TokenKind(Literal{kind, suffix_start});
+        return Token::literal(LiteralKind::Char, suffix_start, terminated ? Token::TERMINATED : 0);
     }
 
-    if (cursor.first() == 'r' && cursor.second() == '#' && is_id_start(cursor.third())) {
+    if (cursor.first() == 'r' && cursor.second() == '#' && is_id_start(cursor.peek_char(2))) {
         // Eat "r" and `#`, and identifier start characters.
         cursor.bump();
         cursor.bump();
-        cursor.bump();
-        cursor.eat_while(is_id_continue);
-        return RawLifetime{};
+        cursor.bump_char();
+        cursor.eat_while_char(is_id_continue);
+        return Token(TokenKind::RawLifetime);
     }
 
     // Either a lifetime or a character literal with
@@ -1002,8 +816,8 @@ TokenKind lifetime_or_char(Cursor &cursor) {
     // First symbol can be a number (which isn't a valid identifier start),
     // so skip it without any checks.
 
-    cursor.bump();
-    cursor.eat_while(is_id_continue);
+    cursor.bump_char();
+    cursor.eat_while_char(is_id_continue);
 
     char32_t c = cursor.first();
     if (c == '\'') {
@@ -1011,21 +825,22 @@ TokenKind lifetime_or_char(Cursor &cursor) {
         // single quote (which means that user attempted to create a
         // string with single quotes).
         cursor.bump();
-        LiteralKind kind = namespace_Literal::Char{true};
-        return TokenKind(Literal{kind, cursor.pos_within_token()});           
+        return Token::literal(LiteralKind::Char, cursor.pos_within_token(), Token::TERMINATED);
     } else if (c == '#' && !starts_with_number) {
-        return UnknownPrefixLifetime{};
+        return Token(TokenKind::UnknownPrefixLifetime);
     } else {
-        return Lifetime {starts_with_number};
+        Token token(TokenKind::Lifetime);
+        token.flags = starts_with_number ? Token::STARTS_WITH_NUMBER : 0;
+        return token;
     }
 }
 
-bool single_quoted_string(Cursor &cursor) {
+inline bool single_quoted_string(Cursor &cursor) {
     assert(cursor.prev() == '\'');
 
     //Check if it's a one-symbol literal
-    if (cursor.second() == '\'' && cursor.first() != '\\') {
-        cursor.bump();
+    if (cursor.first() != '\\' && cursor.peek_char(1) == '\'') {
+        cursor.bump_char();
         cursor.bump();
         return true;
     }
@@ -1040,23 +855,23 @@ bool single_quoted_string(Cursor &cursor) {
             cursor.bump();
             return true;
         }
-        
+
         // Probably beginning of the comment, which we don't want to include
         // to the error report.
         else if (c == '/') { break; }
-        
+
         // Newline without following '\'' means unclosed quote, stop parsing.
         else if(c == '\n' && cursor.second() != '\'') { break; }
-        
+
         // End of file, stop parsing.
         else if (c == EOF_CHAR && cursor.is_eof()) { break; }
 
         // Escaped slash is considered one character, so bump twice.
         else if (c == '\\') {
             cursor.bump();
-            cursor.bump();
+            cursor.bump_char();
         }
-        
+
         // Skip the character.
         else {
             cursor.bump();
@@ -1068,7 +883,7 @@ bool single_quoted_string(Cursor &cursor) {
 
 // Eats double-quoted string and returns true
 // if string is terminated.
-bool double_quoted_string(Cursor &cursor) {
+inline bool double_quoted_string(Cursor &cursor) {
     assert(cursor.prev() == '"');
 
     while (true) {
@@ -1077,14 +892,14 @@ bool double_quoted_string(Cursor &cursor) {
             // Reached EOF before closing quote
             return false;
         }
-        
+
         const char c = c_opt.value();
-        
+
         if (c == '"') {
             // Found closing quote
             return true;
         }
-        
+
         if (c == '\\') {
             // Handle escape sequences
             const char next = cursor.first();
@@ -1104,9 +919,9 @@ bool double_quoted_string(Cursor &cursor) {
 // Note: this will not reset the `Cursor` when a
 // guarded string is not found. It is the caller's
 // responsibility to do so.
-std::optional<GuardedStr> guarded_qouted_double_string(Cursor &cursor) {
+inline std::optional<GuardedStr> guarded_qouted_double_string(Cursor &cursor) {
     assert(cursor.prev() != '#');
-    
+
     uint32_t n_start_hashes = 0;
     while (cursor.first() == '#') {
         cursor.bump();
@@ -1142,35 +957,38 @@ std::optional<GuardedStr> guarded_qouted_double_string(Cursor &cursor) {
 
     // Reserved syntax, always an error, so it doesn't matter if
     // `n_start_hashes != n_end_hashes`.
-    
+
     eat_literal_suffix(cursor);
 
     const uint32_t token_len = cursor.pos_within_token();
     cursor.reset_pos_within_token();
 
-    return GuardedStr{n_start_hashes, true, token_len};    
+    return GuardedStr{n_start_hashes, true, token_len};
 }
 
 // Eats the double-quoted string and returns `n_hashes` and an error if encountered.
-Result<uint8_t, RawStrError> raw_double_quoted_string(Cursor &cursor, uint32_t prefix_len) {
+inline Result<uint8_t, RawStrError> raw_double_quoted_string(Cursor &cursor, uint32_t prefix_len) {
     // Wrap the actual function to handle the error with too many hashes.
     // This way, it eats the whole raw string.
-    
+
     Result<uint32_t, RawStrError> n_hashes = raw_string_unvalidated(cursor, prefix_len);
+    if (n_hashes.is_err()) {
+        return Result<uint8_t, RawStrError>::Err(n_hashes.unwrap_err());
+    }
     //only upto 255 `#`s are allowed in a string
-    if(n_hashes.is_ok() && n_hashes.unwrap() <= 255) {
-        Result<uint8_t, RawStrError>::Ok(uint8_t(n_hashes.unwrap()));
+    if(n_hashes.unwrap() <= 255) {
+        return Result<uint8_t, RawStrError>::Ok(uint8_t(n_hashes.unwrap()));
     } else {
-        Result<uint8_t, RawStrError>::Err(TooManyDelimiters{found: n_hashes.unwrap()});
+        return Result<uint8_t, RawStrError>::Err(TooManyDelimiters{n_hashes.unwrap()});
     }
 }
 
-Result<uint32_t, RawStrError> raw_string_unvalidated(Cursor &cursor, uint32_t prefix_len) {
+inline Result<uint32_t, RawStrError> raw_string_unvalidated(Cursor &cursor, uint32_t prefix_len) {
     assert(cursor.prev() == 'r');
     const uint32_t start_pos = cursor.pos_within_token();
     std::optional<uint32_t> possible_terminator_offset;
     uint32_t max_hashes = 0;
-    
+
     // Count opening '#' symbols.
     uint32_t eaten = 0;
     while (cursor.first() == '#') {
@@ -1181,15 +999,20 @@ Result<uint32_t, RawStrError> raw_string_unvalidated(Cursor &cursor, uint32_t pr
 
     // Check that string is started.
     std::optional<char> quote = cursor.bump();
-    if (!quote.has_value() && quote.value() != '"') {
+    if (!quote.has_value() || quote.value() != '"') {
         const char bad_char = quote.has_value() ? quote.value() : EOF_CHAR;
         return Result<uint32_t, RawStrError>::Err(InvalidStarter{bad_char});
     }
 
-    // Skip the string contents and on each '#' character met, check if this is
-    // a raw string termination.
+    // Skip the string contents and on each '"' that can end the string, check
+    // if this is a raw string termination. With hashes, only a '"' followed by
+    // a '#' can; any other quote would close zero hashes, which changes nothing.
     while(true) {
-        cursor.eat_until('"');
+        if (n_start_hashes == 0) {
+            cursor.eat_until('"');
+        } else {
+            cursor.eat_until_pair('"', '#');
+        }
 
         if (cursor.is_eof()) {
             // Reached EOF before closing quote
@@ -1208,26 +1031,25 @@ Result<uint32_t, RawStrError> raw_string_unvalidated(Cursor &cursor, uint32_t pr
         while (cursor.first() == '#' && n_end_hashes < n_start_hashes) {
             n_end_hashes++;
             cursor.bump();
-        } 
+        }
 
         if (n_end_hashes == n_start_hashes) {
             // Found a valid raw string literal.
             return Result<uint32_t, RawStrError>::Ok(n_start_hashes);
-        } else if (n_end_hashes > n_start_hashes) {
-            // Found a closing quote with more hashes than opening ones.
+        } else if (n_end_hashes > max_hashes) {
             // Keep track of possible terminators to give a hint about
             // where there might be a missing terminator
             possible_terminator_offset = cursor.pos_within_token() - start_pos - n_end_hashes + prefix_len;
             max_hashes = n_end_hashes;
-        }    
+        }
     }
 }
 
-bool eat_decimal_digits(Cursor &cursor) {
+inline bool eat_decimal_digits(Cursor &cursor) {
     bool has_digits = false;
     while(true) {
-        char32_t c = cursor.first();
-        if (is_ascii_digit(c)) {
+        const char c = cursor.first();
+        if (is_ascii_digit(static_cast<unsigned char>(c))) {
             cursor.bump();
             has_digits = true;
         } else if (c == '_') {
@@ -1239,11 +1061,11 @@ bool eat_decimal_digits(Cursor &cursor) {
     return has_digits;
 }
 
-bool eat_hexadecimal_digits(Cursor &cursor) {
+inline bool eat_hexadecimal_digits(Cursor &cursor) {
     bool has_digits = false;
     while(true) {
-        char32_t c = cursor.first();
-        if (is_ascii_digit(c) || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F')) {
+        const char c = cursor.first();
+        if (is_ascii_hex_digit(static_cast<unsigned char>(c))) {
             cursor.bump();
             has_digits = true;
         } else if (c == '_') {
@@ -1257,9 +1079,8 @@ bool eat_hexadecimal_digits(Cursor &cursor) {
 
 // Eats the float exponent. Returns true if at least one digit was met,
 // and returns false otherwise.
-bool eat_float_exponent(Cursor &cursor) {
+inline bool eat_float_exponent(Cursor &cursor) {
     assert(cursor.prev() == 'e' || cursor.prev() == 'E');
-    bool has_digits = false;
     char32_t c = cursor.first();
     if (c == '+' || c == '-') {
         cursor.bump();
@@ -1268,16 +1089,194 @@ bool eat_float_exponent(Cursor &cursor) {
 }
 
 // Eats the suffix of the literal, e.g. "u8".
-bool eat_literal_suffix(Cursor &cursor) {
+inline void eat_literal_suffix(Cursor &cursor) {
     eat_identifier(cursor);
 }
 
 // Eats the identifier. Note: succeeds on `_`, which isn't a valid
 // identifier
-void eat_identifier(Cursor &cursor) {
-    if(!is_id_start(cursor.first())) {
+inline void eat_identifier(Cursor &cursor) {
+    if(!is_id_start(cursor.first_char())) {
         return;
     }
-    cursor.bump();
-    cursor.eat_while(is_id_continue);
-}
\ No newline at end of file
+    cursor.bump_char();
+    cursor.eat_while_char(is_id_continue);
+}
+
+/*
+Dispatch for `advance_token`. Every byte that can start a token maps to the
+handler that lexes the rest of it, so picking the handler is a single load
+instead of a walk through a switch. Handlers run after the first byte was
+bumped and get it passed in.
+*/
+namespace dispatch {
+
+    using Handler = Token (*)(Cursor&, char);
+
+    template<TokenKind Kind>
+    inline Token single(Cursor&, char) {
+        return Token(Kind);
+    }
+
+    // Slash, line comment or block comment
+    inline Token slash(Cursor &cursor, char) {
+        const char next_char = cursor.first();
+        if (next_char == '/') {
+            return line_comment(cursor);
+        }
+        if (next_char == '*') {
+            return block_comment(cursor);
+        }
+        return Token(TokenKind::Slash);
+    }
+
+    inline Token space(Cursor &cursor, char) {
+        return whitespace(cursor);
+    }
+
+    inline Token ident(Cursor &cursor, char) {
+        return ident_or_unknown_prefix(cursor);
+    }
+
+    // Raw identifier, raw string literal or identifier
+    inline Token prefix_r(Cursor &cursor, char) {
+        const char next1 = cursor.first();
+
+        if (next1 == '#' && is_id_start(cursor.peek_char(1))) {
+            return raw_ident(cursor);
+        }
+        if (next1 == '#' || next1 == '"') {
+            auto res = raw_double_quoted_string(cursor, 1);
+            const uint32_t suffix_start = cursor.pos_within_token();
+            if (res.is_ok()) {
+                eat_literal_suffix(cursor);
+            }
+            return raw_literal(LiteralKind::RawStr, suffix_start, res);
+        }
+        return ident_or_unknown_prefix(cursor);
+    }
+
+    // Byte, byte string or identifier
+    inline Token prefix_b(Cursor &cursor, char) {
+        return c_or_byte_string(cursor, LiteralKind::ByteStr, LiteralKind::RawByteStr, LiteralKind::Byte);
+    }
+
+    // C string or identifier
+    inline Token prefix_c(Cursor &cursor, char) {
+        return c_or_byte_string(cursor, LiteralKind::CStr, LiteralKind::RawCStr, std::nullopt);
+    }
+
+    inline Token numeric(Cursor &cursor, char first_char) {
+        Token token = number(cursor, static_cast<char32_t>(first_char));
+        token.data = cursor.pos_within_token();
+        eat_literal_suffix(cursor);
+        return token;
+    }
+
+    // Lifetime or character literal
+    inline Token quote(Cursor &cursor, char) {
+        return lifetime_or_char(cursor);
+    }
+
+    // String literal
+    inline Token string(Cursor &cursor, char) {
+        const bool terminated = double_quoted_string(cursor);
+        const uint32_t suffix_start = cursor.pos_within_token();
+        if (terminated) {
+            eat_literal_suffix(cursor);
+        }
+        return Token::literal(LiteralKind::Str, suffix_start, terminated ? Token::TERMINATED : 0);
+    }
+
+    inline Token unknown(Cursor&, char) {
+        return Token(TokenKind::Unknown);
+    }
+
+    // Lead bytes outside ASCII: decode the whole character first.
+    inline Token other(Cursor &cursor, char) {
+        const char32_t first_char = cursor.finish_char();
+        if (is_whitespace(first_char)) {
+            return whitespace(cursor);
+        }
+        if (is_id_start(first_char)) {
+            return ident_or_unknown_prefix(cursor);
+        }
+        if (isemoji(first_char)) {
+            return invalid_ident(cursor);
+        }
+        return Token(TokenKind::Unknown);
+    }
+
+    constexpr std::array<Handler, 256> make_table() {
+        std::array<Handler, 256> table{};
+        for (size_t c = 0; c < 128; ++c) {
+            table[c] = unknown;
+        }
+        for (size_t c = 128; c < 256; ++c) {
+            table[c] = other;
+        }
+        for (size_t c = 0; c < 128; ++c) {
+            const uint8_t classes = char_class::TABLE[c];
+            if (classes & char_class::ID_START) {
+                table[c] = ident;
+            } else if (classes & char_class::DIGIT) {
+                table[c] = numeric;
+            } else if (classes & char_class::WHITESPACE) {
+                table[c] = space;
+            }
+        }
+        table['r'] = prefix_r;
+        table['b'] = prefix_b;
+        table['c'] = prefix_c;
+        table['/'] = slash;
+        table['\''] = quote;
+        table['"'] = string;
+
+        table[';'] = single<TokenKind::Semi>;
+        table[','] = single<TokenKind::Comma>;
+        table['.'] = single<TokenKind::Dot>;
+        table['('] = single<TokenKind::OpenParen>;
+        table[')'] = single<TokenKind::CloseParen>;
+        table['{'] = single<TokenKind::OpenBrace>;
+        table['}'] = single<TokenKind::CloseBrace>;
+        table['['] = single<TokenKind::OpenBracket>;
+        table[']'] = single<TokenKind::CloseBracket>;
+        table['@'] = single<TokenKind::At>;
+        table['#'] = single<TokenKind::Pound>;
+        table['~'] = single<TokenKind::Tilde>;
+        table['?'] = single<TokenKind::Question>;
+        table[':'] = single<TokenKind::Colon>;
+        table['$'] = single<TokenKind::Dollar>;
+        table['='] = single<TokenKind::Eq>;
+        table['!'] = single<TokenKind::Bang>;
+        table['<'] = single<TokenKind::Lt>;
+        table['>'] = single<TokenKind::Gt>;
+        table['-'] = single<TokenKind::Minus>;
+        table['&'] = single<TokenKind::And>;
+        table['|'] = single<TokenKind::Or>;
+        table['+'] = single<TokenKind::Plus>;
+        table['*'] = single<TokenKind::Star>;
+        table['^'] = single<TokenKind::Caret>;
+        table['%'] = single<TokenKind::Percent>;
+        return table;
+    }
+
+    inline constexpr std::array<Handler, 256> TABLE = make_table();
+
+} // namespace dispatch
+
+inline Token advance_token(Cursor &cursor) {
+    auto bump = cursor.bump();
+    if (!bump.has_value()) {
+        return Token(TokenKind::Eof, 0);
+    }
+
+    const char first_char = bump.value();
+    Token res = dispatch::TABLE[static_cast<unsigned char>(first_char)](cursor, first_char);
+    res.len = cursor.pos_within_token();
+    cursor.reset_pos_within_token();
+    return res;
+}
+
+} // namespace lexer
+} // namespace amyr
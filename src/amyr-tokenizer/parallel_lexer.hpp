@@ -0,0 +1,148 @@
+/*
+Parallel lexing of large inputs.
+
+The input is cut into chunks at newlines, and every chunk is lexed on a worker
+as if a token started there. That guess is only wrong when the newline sits
+inside a multi-line token (a string, a block comment, a raw string), so the
+chunks are validated while stitching:
+
+- If sequential lexing reaches a chunk exactly at one of the chunk's own token
+  starts, the rest of that chunk is taken as is. `advance_token` depends only on
+  the input from the cursor onwards, so those tokens are what sequential lexing
+  would have produced.
+- Otherwise tokens are lexed one by one from where the previous chunk really
+  ended until the two agree again, or until the chunk is passed entirely.
+
+The output is therefore always identical to `tokenize(input)`.
+*/
+#pragma once
+
+#include<algorithm>
+#include<cstdint>
+#include<future>
+#include<string_view>
+#include<vector>
+
+#include "low_lexer.hpp"
+#include "amyr-utils/thread_pool.hpp"
+
+namespace amyr {
+namespace lexer {
+
+// Tokens lexed speculatively from a chunk boundary.
+struct LexedChunk {
+    std::vector<Token> tokens;
+    // Absolute start offset of each token.
+    std::vector<uint32_t> starts;
+    // Absolute offset just past the last token.
+    uint32_t end = 0;
+};
+
+// Lexes from `begin` until a token ends at or past `stop`. Tokens may run past `stop`.
+inline LexedChunk lex_chunk(std::string_view input, uint32_t begin, uint32_t stop) {
+    LexedChunk chunk;
+    Cursor cursor(input.substr(begin));
+    uint32_t pos = begin;
+    while (pos < stop) {
+        Token token = advance_token(cursor);
+        if (token.kind == TokenKind::Eof) {
+            break;
+        }
+        chunk.tokens.push_back(token);
+        chunk.starts.push_back(pos);
+        pos += token.len;
+    }
+    chunk.end = pos;
+    return chunk;
+}
+
+// Lexes the single token starting at `pos`.
+inline Token lex_one(std::string_view input, uint32_t pos) {
+    Cursor cursor(input.substr(pos));
+    return advance_token(cursor);
+}
+
+/*
+Picks chunk boundaries: the start of the first line at or after every multiple
+of `chunk_size`. Returns the boundaries including 0 and input.size().
+*/
+inline std::vector<uint32_t> split_at_lines(std::string_view input, size_t chunk_size) {
+    std::vector<uint32_t> bounds{0};
+    size_t next = chunk_size;
+    while (next < input.size()) {
+        const size_t newline = input.find('\n', next);
+        if (newline == std::string_view::npos || newline + 1 >= input.size()) {
+            break;
+        }
+        bounds.push_back(static_cast<uint32_t>(newline + 1));
+        next = newline + 1 + chunk_size;
+    }
+    bounds.push_back(static_cast<uint32_t>(input.size()));
+    return bounds;
+}
+
+/*
+Lexes `input` on `pool`, producing exactly the tokens of `tokenize(input)`.
+Inputs smaller than two chunks are lexed on the calling thread.
+*/
+inline std::vector<Token> tokenize_parallel(std::string_view input, ThreadPool& pool,
+                                            size_t chunk_size = size_t(1) << 20) {
+    std::vector<Token> out;
+    const std::vector<uint32_t> bounds = split_at_lines(input, std::max<size_t>(chunk_size, 1));
+    const size_t n_chunks = bounds.size() - 1;
+
+    if (n_chunks <= 1) {
+        TokenIterator iter(input);
+        while (auto token = iter.next()) {
+            out.push_back(*token);
+        }
+        return out;
+    }
+
+    std::vector<std::future<LexedChunk>> pending;
+    pending.reserve(n_chunks);
+    for (size_t i = 0; i < n_chunks; ++i) {
+        const uint32_t begin = bounds[i];
+        const uint32_t stop = bounds[i + 1];
+        pending.push_back(pool.submit([input, begin, stop] { return lex_chunk(input, begin, stop); }));
+    }
+
+    // The first chunk starts at offset 0, so it is always valid.
+    LexedChunk first = pending[0].get();
+    out = std::move(first.tokens);
+    uint32_t pos = first.end;
+
+    for (size_t i = 1; i < n_chunks; ++i) {
+        LexedChunk chunk = pending[i].get();
+
+        // Catch up with the chunk's speculative token starts.
+        while (pos < chunk.end) {
+            auto it = std::lower_bound(chunk.starts.begin(), chunk.starts.end(), pos);
+            if (it != chunk.starts.end() && *it == pos) {
+                const size_t from = static_cast<size_t>(it - chunk.starts.begin());
+                out.insert(out.end(), chunk.tokens.begin() + from, chunk.tokens.end());
+                pos = chunk.end;
+                break;
+            }
+            Token token = lex_one(input, pos);
+            out.push_back(token);
+            pos += token.len;
+        }
+    }
+
+    // The last chunk always lexes up to EOF, but its tail may have been passed
+    // over by a token from an earlier chunk; finish sequentially in that case.
+    while (pos < input.size()) {
+        Token token = lex_one(input, pos);
+        if (token.kind == TokenKind::Eof) {
+            break;
+        }
+        out.push_back(token);
+        pos += token.len;
+    }
+
+    return out;
+}
+
+} // namespace lexer
+} // namespace amyr
@@ -0,0 +1,118 @@
+/*
+Incremental relexing for edited buffers.
+
+Tokens never span a line break except through trivia, and lexing from a token
+start only depends on the text from there onwards. So after an edit only the
+tokens from just before the damage need to be lexed again: as soon as a fresh
+token starts where an old token (moved by the edit) started, every token
+after it is unchanged and can be reused.
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+#include "tokenizer.hpp"
+
+// Replaces bytes [start, end) of the old text with `replacement`.
+struct TextEdit {
+    uint32_t start;
+    uint32_t end;
+    std::string_view replacement;
+};
+
+/*
+Old tokens [first, old_end) were replaced by the tokens [first, new_end) of
+`tokens`. Everything outside that range was reused.
+*/
+struct RelexResult {
+    TokenStream tokens;
+    size_t first;
+    size_t old_end;
+    size_t new_end;
+};
+
+namespace relex_detail {
+    /*
+    Bytes past the end of a token the lexer may have looked at to decide where
+    it ends: `1.` checks the byte after the dot before taking it as a float.
+    */
+    constexpr uint32_t MAX_LOOKAHEAD = 2;
+
+    // First token ending at or after `pos`.
+    inline size_t lower_bound_end(const TokenStream& tokens, uint32_t pos) {
+        size_t lo = 0;
+        size_t hi = tokens.size();
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (tokens.start(mid) + tokens[mid].len < pos) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    // First token in [lo, size) starting at or after `pos`.
+    inline size_t lower_bound_start(const TokenStream& tokens, size_t lo, uint32_t pos) {
+        size_t hi = tokens.size();
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (tokens.start(mid) < pos) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+}
+
+/*
+Updates `old`, the stream of the text before `edit`, to match `source`, the
+text after it. `source` has to outlive the returned stream, like any source
+passed to the Tokenizer. Work is proportional to the damaged tokens, plus a
+memmove of the stream's tail when the edit changes the token count.
+*/
+inline RelexResult relex(TokenStream old, std::string_view source, const TextEdit& edit) {
+    const int64_t delta = static_cast<int64_t>(edit.replacement.size()) - (static_cast<int64_t>(edit.end) - edit.start);
+    if (edit.start > edit.end || old.empty() ||
+        static_cast<int64_t>(old.source().size()) + delta != static_cast<int64_t>(source.size())) {
+        throw std::invalid_argument("Edit does not match the token stream");
+    }
+
+    /*
+    Relex from the first token whose lexing could have seen the edited bytes.
+    The edit can also fall in the trivia before that token, so scanning
+    restarts where the token before it ended.
+    */
+    const size_t first = edit.start > relex_detail::MAX_LOOKAHEAD
+        ? relex_detail::lower_bound_end(old, edit.start - relex_detail::MAX_LOOKAHEAD)
+        : 0;
+    const uint32_t restart = first == 0 ? 0 : old.start(first - 1) + old[first - 1].len;
+
+    // Fresh tokens starting here or later line up with old ones moved by `delta`.
+    const uint32_t synced_from = edit.start + static_cast<uint32_t>(edit.replacement.size());
+
+    Tokenizer lexer(source, restart);
+    size_t fresh = 0;
+    size_t old_end = old.size() - 1;  // EOF always lines up.
+    while (lexer.scanToken()) {
+        const uint32_t pos = lexer.stream().start(fresh);
+        if (pos >= synced_from) {
+            const uint32_t old_pos = static_cast<uint32_t>(pos - delta);
+            const size_t k = relex_detail::lower_bound_start(old, first, old_pos);
+            if (k < old.size() && old.start(k) == old_pos) {
+                old_end = k;
+                break;
+            }
+        }
+        ++fresh;
+    }
+
+    old.splice(first, old_end, lexer.stream(), fresh, source, delta);
+    return RelexResult{std::move(old), first, old_end, first + fresh};
+}
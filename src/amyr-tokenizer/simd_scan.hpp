@@ -0,0 +1,439 @@
+/*
+Bulk byte scanners used by the Cursor fast paths.
+
+Every scanner takes a half-open range [begin, end) and returns a pointer to the
+first byte that stops the scan, or `end` if there is none. On x86-64 the
+SSE2/AVX2 kernels are picked once at runtime; everything else falls back to
+the scalar loops, which are also what the vector kernels use for the tail.
+
+`find_pair` and `find_either_pair` look for two-byte sequences. The vector
+kernels compare each block against itself shifted by one byte, so text dense
+in one of the two bytes (`****` rules in a comment, JSON in a raw string)
+doesn't stop the scan at every byte.
+
+`collect_line_starts` is the one scanner that doesn't stop: it records the
+position after every newline in the range.
+*/
+#pragma once
+
+#include<cstddef>
+#include<cstdint>
+#include<cstring>
+#include<vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #define AMYR_SIMD_X86 1
+    #include<immintrin.h>
+#endif
+
+namespace amyr {
+namespace simd {
+
+enum class Level {
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+// True for the ASCII subset of Pattern_White_Space: `\t`, `\n`, `\v`, `\f`, `\r` and space.
+constexpr bool is_ascii_whitespace(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+namespace scalar {
+
+    inline const char* skip_ascii_whitespace(const char* p, const char* end) {
+        while (p < end && is_ascii_whitespace(static_cast<unsigned char>(*p))) {
+            ++p;
+        }
+        return p;
+    }
+
+    inline const char* find_either(const char* p, const char* end, char a, char b) {
+        while (p < end && *p != a && *p != b) {
+            ++p;
+        }
+        return p;
+    }
+
+    inline const char* find_pair(const char* p, const char* end, char a, char b) {
+        while (end - p >= 2) {
+            const void* found = std::memchr(p, a, static_cast<size_t>(end - p - 1));
+            if (!found) {
+                break;
+            }
+            p = static_cast<const char*>(found);
+            if (p[1] == b) {
+                return p;
+            }
+            ++p;
+        }
+        return end;
+    }
+
+    inline const char* find_either_pair(const char* p, const char* end, char a, char b) {
+        while (end - p >= 2) {
+            p = find_either(p, end - 1, a, b);
+            if (p == end - 1) {
+                break;
+            }
+            if (p[1] == (*p == a ? b : a)) {
+                return p;
+            }
+            ++p;
+        }
+        return end;
+    }
+
+    inline const char* find_non_ascii(const char* p, const char* end) {
+        // A word at a time: only the high bit of each byte matters.
+        while (end - p >= 8) {
+            uint64_t word;
+            std::memcpy(&word, p, 8);
+            const uint64_t high = word & 0x8080808080808080ull;
+            if (high != 0) {
+                return p + __builtin_ctzll(high) / 8;
+            }
+            p += 8;
+        }
+        while (p < end && static_cast<unsigned char>(*p) < 0x80) {
+            ++p;
+        }
+        return p;
+    }
+
+    inline void collect_line_starts(const char* p, const char* end, uint32_t base, std::vector<uint32_t>& out) {
+        const char* const begin = p;
+        while ((p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)))) != nullptr) {
+            ++p;
+            out.push_back(base + static_cast<uint32_t>(p - begin));
+        }
+    }
+
+} // namespace scalar
+
+#ifdef AMYR_SIMD_X86
+
+namespace sse2 {
+
+    // Bit i is set when byte i of `block` is ASCII whitespace.
+    inline unsigned whitespace_mask(__m128i block) {
+        // `\t`..`\r` are contiguous, so (c - '\t') <= 4 (unsigned) covers them.
+        const __m128i shifted = _mm_sub_epi8(block, _mm_set1_epi8('\t'));
+        const __m128i in_range = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+        const __m128i space = _mm_cmpeq_epi8(block, _mm_set1_epi8(' '));
+        return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(in_range, space)));
+    }
+
+    inline const char* skip_ascii_whitespace(const char* p, const char* end) {
+        while (end - p >= 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const unsigned stop = ~whitespace_mask(block) & 0xFFFFu;
+            if (stop != 0) {
+                return p + __builtin_ctz(stop);
+            }
+            p += 16;
+        }
+        return scalar::skip_ascii_whitespace(p, end);
+    }
+
+    inline const char* find_either(const char* p, const char* end, char a, char b) {
+        const __m128i va = _mm_set1_epi8(a);
+        const __m128i vb = _mm_set1_epi8(b);
+        while (end - p >= 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(block, va), _mm_cmpeq_epi8(block, vb));
+            const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit));
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 16;
+        }
+        return scalar::find_either(p, end, a, b);
+    }
+
+    // Bit i is set when bytes i and i + 1 of `p` are `a` and `b`.
+    inline unsigned pair_mask(const char* p, __m128i va, __m128i vb) {
+        const __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        const __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 1));
+        const __m128i hit = _mm_and_si128(_mm_cmpeq_epi8(first, va), _mm_cmpeq_epi8(second, vb));
+        return static_cast<unsigned>(_mm_movemask_epi8(hit));
+    }
+
+    inline const char* find_pair(const char* p, const char* end, char a, char b) {
+        const __m128i va = _mm_set1_epi8(a);
+        const __m128i vb = _mm_set1_epi8(b);
+        // The second load reads one byte past the block.
+        while (end - p >= 17) {
+            const unsigned mask = pair_mask(p, va, vb);
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 16;
+        }
+        return scalar::find_pair(p, end, a, b);
+    }
+
+    inline const char* find_either_pair(const char* p, const char* end, char a, char b) {
+        const __m128i va = _mm_set1_epi8(a);
+        const __m128i vb = _mm_set1_epi8(b);
+        while (end - p >= 17) {
+            const unsigned mask = pair_mask(p, va, vb) | pair_mask(p, vb, va);
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 16;
+        }
+        return scalar::find_either_pair(p, end, a, b);
+    }
+
+    inline const char* find_non_ascii(const char* p, const char* end) {
+        while (end - p >= 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(block));
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 16;
+        }
+        return scalar::find_non_ascii(p, end);
+    }
+
+    inline void collect_line_starts(const char* p, const char* end, uint32_t base, std::vector<uint32_t>& out) {
+        const char* const begin = p;
+        const __m128i newline = _mm_set1_epi8('\n');
+        while (end - p >= 16) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, newline)));
+            const uint32_t offset = base + static_cast<uint32_t>(p - begin) + 1;
+            while (mask != 0) {
+                out.push_back(offset + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+            p += 16;
+        }
+        scalar::collect_line_starts(p, end, base + static_cast<uint32_t>(p - begin), out);
+    }
+
+} // namespace sse2
+
+namespace avx2 {
+
+    __attribute__((target("avx2")))
+    inline const char* skip_ascii_whitespace(const char* p, const char* end) {
+        const __m256i tab = _mm256_set1_epi8('\t');
+        const __m256i four = _mm256_set1_epi8(4);
+        const __m256i space = _mm256_set1_epi8(' ');
+        while (end - p >= 32) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i shifted = _mm256_sub_epi8(block, tab);
+            const __m256i in_range = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, four), shifted);
+            const __m256i ws = _mm256_or_si256(in_range, _mm256_cmpeq_epi8(block, space));
+            const uint32_t stop = ~static_cast<uint32_t>(_mm256_movemask_epi8(ws));
+            if (stop != 0) {
+                return p + __builtin_ctz(stop);
+            }
+            p += 32;
+        }
+        return sse2::skip_ascii_whitespace(p, end);
+    }
+
+    __attribute__((target("avx2")))
+    inline const char* find_either(const char* p, const char* end, char a, char b) {
+        const __m256i va = _mm256_set1_epi8(a);
+        const __m256i vb = _mm256_set1_epi8(b);
+        while (end - p >= 32) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(block, va), _mm256_cmpeq_epi8(block, vb));
+            const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 32;
+        }
+        return sse2::find_either(p, end, a, b);
+    }
+
+    __attribute__((target("avx2")))
+    inline uint32_t pair_mask(const char* p, __m256i va, __m256i vb) {
+        const __m256i first = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        const __m256i second = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 1));
+        const __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi8(first, va), _mm256_cmpeq_epi8(second, vb));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+    }
+
+    __attribute__((target("avx2")))
+    inline const char* find_pair(const char* p, const char* end, char a, char b) {
+        const __m256i va = _mm256_set1_epi8(a);
+        const __m256i vb = _mm256_set1_epi8(b);
+        while (end - p >= 33) {
+            const uint32_t mask = pair_mask(p, va, vb);
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 32;
+        }
+        return sse2::find_pair(p, end, a, b);
+    }
+
+    __attribute__((target("avx2")))
+    inline const char* find_either_pair(const char* p, const char* end, char a, char b) {
+        const __m256i va = _mm256_set1_epi8(a);
+        const __m256i vb = _mm256_set1_epi8(b);
+        while (end - p >= 33) {
+            const uint32_t mask = pair_mask(p, va, vb) | pair_mask(p, vb, va);
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 32;
+        }
+        return sse2::find_either_pair(p, end, a, b);
+    }
+
+    __attribute__((target("avx2")))
+    inline const char* find_non_ascii(const char* p, const char* end) {
+        while (end - p >= 32) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(block));
+            if (mask != 0) {
+                return p + __builtin_ctz(mask);
+            }
+            p += 32;
+        }
+        return sse2::find_non_ascii(p, end);
+    }
+
+    __attribute__((target("avx2")))
+    inline void collect_line_starts(const char* p, const char* end, uint32_t base, std::vector<uint32_t>& out) {
+        const char* const begin = p;
+        const __m256i newline = _mm256_set1_epi8('\n');
+        while (end - p >= 32) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, newline)));
+            const uint32_t offset = base + static_cast<uint32_t>(p - begin) + 1;
+            while (mask != 0) {
+                out.push_back(offset + __builtin_ctz(mask));
+                mask &= mask - 1;
+            }
+            p += 32;
+        }
+        sse2::collect_line_starts(p, end, base + static_cast<uint32_t>(p - begin), out);
+    }
+
+} // namespace avx2
+
+#endif // AMYR_SIMD_X86
+
+// Best level supported by the running CPU.
+inline Level detect_level() {
+    #ifdef AMYR_SIMD_X86
+        if (__builtin_cpu_supports("avx2")) {
+            return Level::AVX2;
+        }
+        // SSE2 is part of the x86-64 baseline.
+        return Level::SSE2;
+    #else
+        return Level::Scalar;
+    #endif
+}
+
+namespace detail {
+    inline Level& active_level() {
+        static Level level = detect_level();
+        return level;
+    }
+}
+
+inline Level level() {
+    return detail::active_level();
+}
+
+/*
+Overrides the dispatched level, clamped to what the CPU supports.
+Only meant for benchmarks and tests that compare against the scalar path.
+*/
+inline void set_level(Level requested) {
+    const Level supported = detect_level();
+    detail::active_level() = static_cast<int>(requested) <= static_cast<int>(supported) ? requested : supported;
+}
+
+// Returns the first byte in [p, end) that is not ASCII whitespace.
+inline const char* skip_ascii_whitespace(const char* p, const char* end) {
+    switch (level()) {
+        #ifdef AMYR_SIMD_X86
+        case Level::AVX2: return avx2::skip_ascii_whitespace(p, end);
+        case Level::SSE2: return sse2::skip_ascii_whitespace(p, end);
+        #endif
+        default: return scalar::skip_ascii_whitespace(p, end);
+    }
+}
+
+// Returns the first byte in [p, end) equal to `a` or `b`.
+inline const char* find_either(const char* p, const char* end, char a, char b) {
+    switch (level()) {
+        #ifdef AMYR_SIMD_X86
+        case Level::AVX2: return avx2::find_either(p, end, a, b);
+        case Level::SSE2: return sse2::find_either(p, end, a, b);
+        #endif
+        default: return scalar::find_either(p, end, a, b);
+    }
+}
+
+// Returns the first `a` in [p, end) that is followed by `b`, or `end` if there is none.
+inline const char* find_pair(const char* p, const char* end, char a, char b) {
+    switch (level()) {
+        #ifdef AMYR_SIMD_X86
+        case Level::AVX2: return avx2::find_pair(p, end, a, b);
+        case Level::SSE2: return sse2::find_pair(p, end, a, b);
+        #endif
+        default: return scalar::find_pair(p, end, a, b);
+    }
+}
+
+// Returns the first `ab` or `ba` in [p, end), or `end` if there is none. `a` and `b` must differ.
+inline const char* find_either_pair(const char* p, const char* end, char a, char b) {
+    switch (level()) {
+        #ifdef AMYR_SIMD_X86
+        case Level::AVX2: return avx2::find_either_pair(p, end, a, b);
+        case Level::SSE2: return sse2::find_either_pair(p, end, a, b);
+        #endif
+        default: return scalar::find_either_pair(p, end, a, b);
+    }
+}
+
+// Returns the first byte in [p, end) that is not ASCII.
+inline const char* find_non_ascii(const char* p, const char* end) {
+    switch (level()) {
+        #ifdef AMYR_SIMD_X86
+        case Level::AVX2: return avx2::find_non_ascii(p, end);
+        case Level::SSE2: return sse2::find_non_ascii(p, end);
+        #endif
+        default: return scalar::find_non_ascii(p, end);
+    }
+}
+
+/*
+Appends `base + i + 1` to `out` for every newline at offset `i` of [p, end),
+i.e. the offset of every line start after the first.
+*/
+inline void collect_line_starts(const char* p, const char* end, uint32_t base, std::vector<uint32_t>& out) {
+    switch (level()) {
+        #ifdef AMYR_SIMD_X86
+        case Level::AVX2: return avx2::collect_line_starts(p, end, base, out);
+        case Level::SSE2: return sse2::collect_line_starts(p, end, base, out);
+        #endif
+        default: return scalar::collect_line_starts(p, end, base, out);
+    }
+}
+
+/*
+Returns the first byte in [p, end) equal to `c`.
+libc's memchr is already vectorized and dispatched per CPU, so it is used directly.
+*/
+inline const char* find_byte(const char* p, const char* end, char c) {
+    const void* found = std::memchr(p, c, static_cast<size_t>(end - p));
+    return found ? static_cast<const char*>(found) : end;
+}
+
+} // namespace simd
+} // namespace amyr
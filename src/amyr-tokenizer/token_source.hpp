@@ -0,0 +1,333 @@
+/*
+Pull-based token sources for the parser.
+
+The parser only ever looks one token ahead and one token back, so it reads
+through a TokenBuffer: a small ring that pulls tokens from a TokenSource on
+demand. With a LexingTokenSource the tokenizer runs interleaved with the
+parser and the token buffer stays the same size however big the input is.
+LowLexerTokenSource does the same on top of the low-level lexer.
+*/
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "low_lexer.hpp"
+#include "tokenizer.hpp"
+
+// A token together with its literal value, so it can outlive the lexer state.
+struct BufferedToken {
+    Token token;
+    LiteralValue literal;
+};
+
+class TokenSource {
+public:
+    virtual ~TokenSource() = default;
+
+    // Produces the next token. Keeps returning the EOF token at the end.
+    virtual BufferedToken next() = 0;
+
+    // Text the token spans point into.
+    virtual std::string_view source() const = 0;
+
+    /*
+    A new source for the tokens in bytes [start, end) of the same text,
+    followed by an EOF token at `end`. Both must be token boundaries. Spans
+    keep their offsets into the whole text, so lines still come out right.
+    This is how a skipped function body is parsed later on its own.
+    */
+    virtual std::unique_ptr<TokenSource> range(uint32_t start, uint32_t end) const = 0;
+};
+
+// Lexes tokens as they are pulled.
+class LexingTokenSource : public TokenSource {
+public:
+    explicit LexingTokenSource(std::string_view source) : text(source), tokenizer(source) {}
+
+    // Lexes from `offset` on, see Tokenizer(source, offset).
+    LexingTokenSource(std::string_view source, uint32_t offset) : text(source), tokenizer(source, offset) {}
+
+    BufferedToken next() override {
+        BufferedToken out{};
+        out.token = tokenizer.next(out.literal);
+        return out;
+    }
+
+    std::string_view source() const override { return text; }
+
+    std::unique_ptr<TokenSource> range(uint32_t start, uint32_t end) const override {
+        return std::make_unique<LexingTokenSource>(text.substr(0, end), start);
+    }
+
+    const std::vector<LexError>& diagnostics() const { return tokenizer.diagnostics(); }
+
+private:
+    std::string_view text;
+    Tokenizer tokenizer;
+};
+
+/*
+Fused mode: runs the low-level lexer (amyr::lexer::TokenIterator) and turns
+its tokens into parser tokens as they are pulled. Whitespace and comments are
+dropped here instead of in a separate pass, so a token goes from the cursor to
+the parser's ring while it is still in L1. Doc comments are skipped like any
+other comment; the parser has no use for them yet.
+*/
+class LowLexerTokenSource : public TokenSource {
+public:
+    explicit LowLexerTokenSource(std::string_view source) : text(source), tokens(source) {
+        if (source.size() > UINT32_MAX) {
+            throw std::runtime_error("Source file exceeds 4 GiB");
+        }
+    }
+
+    // Lexes bytes [start, end) of `source`, with offsets into the whole of it.
+    LowLexerTokenSource(std::string_view source, uint32_t start, uint32_t end)
+        : text(source.substr(0, end)), tokens(source.substr(start, end - start)), pos(start) {}
+
+    BufferedToken next() override {
+        while (std::optional<amyr::lexer::Token> token = tokens.next()) {
+            const uint32_t start = pos;
+            pos += token->len;
+            BufferedToken out{};
+            if (convert(*token, start, out)) {
+                return out;
+            }
+        }
+        return BufferedToken{Token{TokenType::EOF_TOKEN, pos, 0, Token::NO_INDEX}, LiteralValue{}};
+    }
+
+    std::string_view source() const override { return text; }
+
+    std::unique_ptr<TokenSource> range(uint32_t start, uint32_t end) const override {
+        return std::make_unique<LowLexerTokenSource>(text, start, end);
+    }
+
+    // Errors found so far, like Tokenizer::diagnostics().
+    const std::vector<LexError>& diagnostics() const { return errors; }
+
+private:
+    std::string_view text;
+    amyr::lexer::TokenIterator tokens;
+    std::vector<LexError> errors;
+    // Offset of the next token; the low-level lexer only reports lengths.
+    uint32_t pos = 0;
+
+    /*
+    The low-level lexer gives every punctuation character its own token, like
+    rustc's. If the next byte is `second`, its token is taken too and `out`
+    grows to cover both.
+    */
+    bool glue(char second, BufferedToken& out) {
+        if (pos >= text.size() || text[pos] != second) {
+            return false;
+        }
+        tokens.next();
+        pos++;
+        out.token.len++;
+        return true;
+    }
+
+    // Fills `out` from a low-level token. Returns false for trivia.
+    bool convert(const amyr::lexer::Token& token, uint32_t start, BufferedToken& out) {
+        using Kind = amyr::lexer::TokenKind;
+        const std::string_view lexeme = text.substr(start, token.len);
+        out.token = Token{TokenType::EOF_TOKEN, start, token.len, Token::NO_INDEX};
+        switch (token.kind) {
+            case Kind::Whitespace:
+            case Kind::LineComment:
+                return false;
+            case Kind::BlockComment:
+                if (!token.terminated()) {
+                    // The rest of the input becomes one Unknown token, so the parser can't accept it.
+                    out.token.type = TokenType::Unknown;
+                    errors.push_back(LexError{start, 2, "Unterminated block comment"});
+                    return true;
+                }
+                return false;
+
+            case Kind::Ident: {
+                const amyr::span::Symbol keyword = token.keyword();
+                out.token.type = Tokenizer::keyword_type(keyword);
+                if (out.token.type == TokenType::Identifier) {
+                    const amyr::span::Symbol sym = keyword.is_keyword() ? keyword : amyr::span::Symbol::intern(lexeme);
+                    out.token.index = sym.as_u32();
+                }
+                return true;
+            }
+
+            case Kind::Literal:
+                if (token.literal_kind == amyr::lexer::LiteralKind::Int ||
+                    token.literal_kind == amyr::lexer::LiteralKind::Float) {
+                    auto value = amyr::lexer::literal_value(lexeme, token);
+                    if (value.is_err()) {
+                        out.token.type = TokenType::Unknown;
+                        errors.push_back(LexError{start, token.len, amyr::lexer::describe(value.unwrap_err())});
+                        return true;
+                    }
+                    out.literal = value.unwrap();
+                    out.token.type = out.literal.is_float ? TokenType::Float : TokenType::Integer;
+                    return true;
+                }
+                break;
+
+            case Kind::OpenParen: out.token.type = TokenType::LeftParen; return true;
+            case Kind::CloseParen: out.token.type = TokenType::RightParen; return true;
+            case Kind::OpenBrace: out.token.type = TokenType::LeftBrace; return true;
+            case Kind::CloseBrace: out.token.type = TokenType::RightBrace; return true;
+            case Kind::Plus: out.token.type = TokenType::Plus; return true;
+            case Kind::Minus: out.token.type = TokenType::Minus; return true;
+            case Kind::Star: out.token.type = TokenType::Star; return true;
+            case Kind::Slash: out.token.type = TokenType::Slash; return true;
+            case Kind::Percent: out.token.type = TokenType::Percent; return true;
+            case Kind::Caret: out.token.type = TokenType::Caret; return true;
+            case Kind::And: out.token.type = glue('&', out) ? TokenType::AndAnd : TokenType::And; return true;
+            case Kind::Or: out.token.type = glue('|', out) ? TokenType::OrOr : TokenType::Or; return true;
+            case Kind::Lt:
+                out.token.type = glue('<', out) ? TokenType::Shl : glue('=', out) ? TokenType::Le : TokenType::Lt;
+                return true;
+            case Kind::Gt:
+                out.token.type = glue('>', out) ? TokenType::Shr : glue('=', out) ? TokenType::Ge : TokenType::Gt;
+                return true;
+            case Kind::Eq: out.token.type = glue('=', out) ? TokenType::EqEq : TokenType::Equals; return true;
+            case Kind::Bang:
+                if (glue('=', out)) {
+                    out.token.type = TokenType::Ne;
+                    return true;
+                }
+                break;
+            case Kind::Comma: out.token.type = TokenType::Comma; return true;
+            case Kind::Semi: out.token.type = TokenType::Semicolon; return true;
+
+            default:
+                break;
+        }
+        /*
+        Tokens the parser has no use for are as unexpected as stray bytes. A
+        single byte, like a lone `!` or `[`, is reported as the Tokenizer
+        reports it; longer tokens, like strings, only exist here.
+        */
+        out.token.type = TokenType::Unknown;
+        errors.push_back(LexError{start, token.len,
+                                  token.kind == Kind::Unknown || token.len == 1 ? "Unexpected character" : "Unexpected token"});
+        return true;
+    }
+};
+
+// Replays an already lexed TokenStream. Ranges of it share the stream.
+class StoredTokenSource : public TokenSource {
+public:
+    explicit StoredTokenSource(TokenStream stream)
+        : tokens(std::make_shared<const TokenStream>(std::move(stream))) {
+        // Everything before the trailing EOF token.
+        last = tokens->empty() ? 0 : tokens->size() - 1;
+        eof_at = tokens->empty() ? 0 : tokens->start(last);
+    }
+
+    BufferedToken next() override {
+        // Stay on the EOF token.
+        if (pos == last) {
+            return BufferedToken{Token{TokenType::EOF_TOKEN, eof_at, 0, Token::NO_INDEX}, LiteralValue{}};
+        }
+        BufferedToken out{};
+        out.token = (*tokens)[pos];
+        if (out.token.type == TokenType::Integer || out.token.type == TokenType::Float) {
+            out.literal = tokens->literal(pos);
+        }
+        pos++;
+        return out;
+    }
+
+    std::string_view source() const override { return tokens->source(); }
+
+    std::unique_ptr<TokenSource> range(uint32_t start, uint32_t end) const override {
+        return std::unique_ptr<TokenSource>(new StoredTokenSource(tokens, first_at(start), first_at(end), end));
+    }
+
+private:
+    std::shared_ptr<const TokenStream> tokens;
+    size_t pos = 0;
+    size_t last = 0;
+    uint32_t eof_at = 0;
+
+    StoredTokenSource(std::shared_ptr<const TokenStream> tokens, size_t first, size_t last, uint32_t eof_at)
+        : tokens(std::move(tokens)), pos(first), last(last), eof_at(eof_at) {}
+
+    // Index of the first token that starts at or after `offset`.
+    size_t first_at(uint32_t offset) const {
+        size_t lo = 0;
+        size_t hi = last;
+        while (lo < hi) {
+            const size_t mid = lo + (hi - lo) / 2;
+            if (tokens->start(mid) < offset) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+};
+
+/*
+Fixed-size ring over a TokenSource. Token `current` is the lookahead. Tokens
+up to LOOKAHEAD past it can be peeked, and HISTORY tokens before it stay
+readable.
+*/
+class TokenBuffer {
+public:
+    static constexpr size_t CAPACITY = 8;
+    static constexpr size_t LOOKAHEAD = 3;
+    static constexpr size_t HISTORY = CAPACITY - LOOKAHEAD - 1;
+
+    explicit TokenBuffer(std::unique_ptr<TokenSource> source) : source(std::move(source)) {
+        fill(0);
+    }
+
+    const BufferedToken& peek() const { return ring[current % CAPACITY]; }
+
+    // Token `n` places past the lookahead, 0 < n <= LOOKAHEAD.
+    const BufferedToken& peek_nth(size_t n) {
+        fill(n);
+        return ring[(current + n) % CAPACITY];
+    }
+
+    const BufferedToken& previous() const { return ring[(current - 1) % CAPACITY]; }
+
+    void bump() {
+        current++;
+        fill(0);
+    }
+
+    std::string_view text() const { return source->source(); }
+
+    // See TokenSource::range.
+    std::unique_ptr<TokenSource> range(uint32_t start, uint32_t end) const { return source->range(start, end); }
+
+    // 1-based line of the lookahead token. Only meant for diagnostics.
+    int line() const {
+        return static_cast<int>(amyr::span::line_col(text(), peek().token.start).line);
+    }
+
+private:
+    std::unique_ptr<TokenSource> source;
+    std::array<BufferedToken, CAPACITY> ring{};
+    size_t current = 0;
+    // Tokens pulled from the source so far.
+    size_t pulled = 0;
+
+    void fill(size_t ahead) {
+        while (pulled <= current + ahead) {
+            ring[pulled % CAPACITY] = source->next();
+            pulled++;
+        }
+    }
+
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "ring capacity must be a power of two");
+};
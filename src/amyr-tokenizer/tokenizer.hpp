@@ -1,200 +1,546 @@
-//
-// Created by vivek on 10-10-2024.
-//
-//
-// Created by vivek on 10-10-2024.
-//
-#pragma once
-#include <string>
-#include <vector>
-#include <cctype>
-#include <stdexcept>
-#include <unordered_map>  //Automatically identifies language keywords
-
-enum class TokenType {
-    // Keywords
-    Let,
-    Mut,
-    Func,
-    Return,
-    If,
-    Else,
-    
-    // Literals
-    Identifier,
-    Integer,
-    Float,
-    
-    // Operators and delimiters
-    Equals,
-    RightBrace,
-    LeftBrace,
-    LeftParen,
-    RightParen,
-    Plus,
-    Minus,
-    Star,
-    Slash,
-    Semicolon,
-    EOF_TOKEN
-};
-
-struct Token {
-    TokenType type;
-    std::string lexeme;
-    int line;
-    
-    // Optional value for numeric tokens
-    union {
-        int intValue;
-        double floatValue;  //Can now tokenize decimal numbers
-    } value;
-
-    Token(TokenType type, std::string lexeme, int line) 
-        : type(type), lexeme(std::move(lexeme)), line(line) {}
-};
-
-class Tokenizer {
-private:
-    std::string source;
-    std::vector<Token> tokens;
-    int start = 0;
-    int current = 0;
-    int line = 1;
-
-    // Keyword map for quick lookup
-    static const std::unordered_map<std::string, TokenType> keywords;
-
-    bool isAtEnd() const {
-        return current >= source.length();
-    }
-
-    char advance() {
-        return source[current++];
-    }
-
-    void addToken(TokenType type) {
-        std::string text = source.substr(start, current - start);
-        tokens.emplace_back(type, text, line);
-    }
-
-    void addNumericToken(TokenType type) {
-        std::string text = source.substr(start, current - start);
-        Token token(type, text, line);
-        
-        if (type == TokenType::Integer) {
-            token.value.intValue = std::stoi(text);
-        } else if (type == TokenType::Float) {
-            token.value.floatValue = std::stod(text);
-        }
-        
-        tokens.push_back(std::move(token));
-    }
-
-    char peek() const {
-        if (isAtEnd()) return '\0';
-        return source[current];
-    }
-
-    char peekNext() const {
-        if (current + 1 >= source.length()) return '\0';
-        return source[current + 1];
-    }
-
-    void number() {
-        // Handle integer part
-        while (std::isdigit(peek())) advance();
-
-        // Handle floating point
-        if (peek() == '.' && std::isdigit(peekNext())) {
-            // Consume the dot
-            advance();
-
-            // Consume fractional part
-            while (std::isdigit(peek())) advance();
-            
-            addNumericToken(TokenType::Float);
-        } else {
-            addNumericToken(TokenType::Integer);
-        }
-    }
-
-    void identifier() {
-        while (std::isalnum(peek()) || peek() == '_') advance();
-        
-        std::string text = source.substr(start, current - start);
-        
-        // Check if it's a keyword
-        auto it = keywords.find(text);
-        TokenType type = (it != keywords.end()) ? it->second : TokenType::Identifier;
-        
-        addToken(type);
-    }
-
-    void skipComment() {
-        // Single-line comment
-        while (peek() != '\n' && !isAtEnd()) advance();
-    }
-
-public:
-    explicit Tokenizer(std::string source) : source(std::move(source)) {}
-
-    std::vector<Token> tokenize() {
-        while (!isAtEnd()) {
-            start = current;
-            char c = advance();
-            switch (c) {
-                // Delimiters and operators
-                case '(': addToken(TokenType::LeftParen); break;
-                case ')': addToken(TokenType::RightParen); break;
-                case '+': addToken(TokenType::Plus); break;
-                case '-': addToken(TokenType::Minus); break;
-                case '*': addToken(TokenType::Star); break;
-                case '/': 
-                    if (peek() == '/') {
-                        skipComment();
-                    } else {
-                        addToken(TokenType::Slash); 
-                    }
-                    break;
-                case '=': addToken(TokenType::Equals); break;
-                case ';': addToken(TokenType::Semicolon); break;
-
-                // Whitespace handling
-                case ' ':
-                case '\r':
-                case '\t':
-                    break;
-                case '\n':
-                    line++;
-                    break;
-
-                // Numeric and identifier handling
-                default:
-                    if (std::isdigit(c)) {
-                        number();
-                    } else if (std::isalpha(c) || c == '_') {
-                        identifier();
-                    } else {
-                        throw std::runtime_error(
-                            "Unexpected character '" + std::string(1, c) + 
-                            "' at line " + std::to_string(line)
-                        );
-                    }
-                    break;
-            }
-        }
-        tokens.emplace_back(TokenType::EOF_TOKEN, "", line);
-        return tokens;
-    }
-};
-
-// Static keyword initialization
-const std::unordered_map<std::string, TokenType> Tokenizer::keywords = {
-    {"let", TokenType::Let},
-    {"mut", TokenType::Mut},
-    {"func", TokenType::Func},
-    {"return", TokenType::Return},
-    {"if", TokenType::If},
-    {"else", TokenType::Else}
-};
+//
+// Created by vivek on 10-10-2024.
+//
+//
+// Created by vivek on 10-10-2024.
+//
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+
+#include "amyr-span/source_file.hpp"
+#include "amyr-span/source_map.hpp"
+#include "amyr-span/symbol.hpp"
+#include "char_class.hpp"
+#include "keyword_table.hpp"
+#include "literal_value.hpp"
+#include "unicode_xid.hpp"
+
+enum class TokenType : uint8_t {
+    // Keywords
+    Let,
+    Mut,
+    Func,
+    Return,
+    If,
+    Else,
+    
+    // Literals
+    Identifier,
+    Integer,
+    Float,
+    
+    // Operators and delimiters
+    Equals,
+    RightBrace,
+    LeftBrace,
+    LeftParen,
+    RightParen,
+    Plus,
+    Minus,
+    Star,
+    Slash,
+    Percent,
+    Caret,
+    And,
+    Or,
+    AndAnd,
+    OrOr,
+    Shl,
+    Shr,
+    EqEq,
+    Ne,
+    Lt,
+    Le,
+    Gt,
+    Ge,
+    Comma,
+    Semicolon,
+
+    // Text that doesn't form a token. Each one has a LexError in the
+    // Tokenizer's diagnostics.
+    Unknown,
+    EOF_TOKEN
+};
+
+/*
+A recoverable lexing error. The bytes it covers stay in the token stream as
+an Unknown token, so lexing carries on past them. Only the offset is kept;
+the line is worked out when the error is printed.
+*/
+struct LexError {
+    uint32_t start;
+    uint32_t len;
+    // Static text: "Unexpected character", or a literal error description.
+    const char* what;
+
+    // `what 'text' at line N`. `lines` must have been built from `source`.
+    std::string describe(std::string_view source, const amyr::span::LineIndex& lines) const {
+        return std::string(what) + " '" + std::string(source.substr(start, len)) +
+               "' at line " + std::to_string(lines.lookup(source, start).line);
+    }
+};
+
+/*
+A token is only a tag and a span into the source text.
+The lexeme is resolved against the source on demand, so building or copying
+a token never allocates.
+*/
+struct Token {
+    TokenType type;
+    uint32_t start;
+    uint32_t len;
+    // Literal-table index for numeric tokens, interned Symbol for identifiers,
+    // NO_INDEX otherwise.
+    uint32_t index;
+
+    static constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+    std::string_view lexeme(std::string_view source) const {
+        return source.substr(start, len);
+    }
+};
+
+static_assert(sizeof(Token) <= 16, "Token must stay within 16 bytes");
+
+using LiteralValue = amyr::lexer::LiteralValue;
+
+/*
+Token stream stored struct-of-arrays: the parser mostly looks at types only,
+so those stay densely packed. Offsets are u32, which caps a file at 4 GiB.
+*/
+class TokenStream {
+public:
+    TokenStream() = default;
+    explicit TokenStream(std::string_view source) : source_(source) {}
+
+    size_t size() const { return types_.size(); }
+    bool empty() const { return types_.empty(); }
+
+    Token operator[](size_t i) const {
+        return Token{types_[i], start(i), lens_[i], indices_[i]};
+    }
+
+    TokenType type(size_t i) const { return types_[i]; }
+
+    uint32_t start(size_t i) const {
+        return starts_[i] + (i >= shift_from_ ? shift_ : 0);
+    }
+
+    std::string_view lexeme(size_t i) const {
+        return source_.substr(start(i), lens_[i]);
+    }
+
+    // Interned name of identifier token `i`.
+    amyr::span::Symbol symbol(size_t i) const {
+        return amyr::span::Symbol(indices_[i]);
+    }
+
+    // Literal value of numeric token `i`.
+    const LiteralValue& literal(size_t i) const {
+        return literals_[indices_[i]];
+    }
+
+    // Entries in the literal table, including ones splice() hasn't dropped yet.
+    size_t literal_count() const { return literals_.size(); }
+
+    /*
+    1-based line of token `i`. Resolved from the source on each call, which is
+    fine for diagnostics; anything that needs many lookups should go through a
+    SourceMap.
+    */
+    int line(size_t i) const {
+        return static_cast<int>(amyr::span::line_col(source_, start(i)).line);
+    }
+
+    std::string_view source() const { return source_; }
+
+    void push(TokenType type, uint32_t start, uint32_t len, uint32_t index = Token::NO_INDEX) {
+        const uint32_t pending = size() >= shift_from_ ? shift_ : 0;
+        types_.push_back(type);
+        starts_.push_back(start - pending);
+        lens_.push_back(len);
+        indices_.push_back(index);
+    }
+
+    // Drops all tokens and literals but keeps the allocations.
+    void clear() {
+        types_.clear();
+        starts_.clear();
+        lens_.clear();
+        indices_.clear();
+        literals_.clear();
+        dead_literals_ = 0;
+        shift_from_ = NO_SHIFT;
+        shift_ = 0;
+    }
+
+    uint32_t add_literal(LiteralValue value) {
+        literals_.push_back(value);
+        return static_cast<uint32_t>(literals_.size() - 1);
+    }
+
+    /*
+    Replaces tokens [first, last) with the first `count` tokens of `fresh`,
+    which were lexed from `source`, the edited text. Starts past the replaced
+    range move by `delta` bytes. Tokens outside the range keep their symbols and
+    literal indices, so only the fresh literals are copied over. The literals
+    of the replaced tokens are dropped once they make up half the table.
+    */
+    void splice(size_t first, size_t last, const TokenStream& fresh, size_t count,
+                std::string_view source, int64_t delta) {
+        const size_t removed = last - first;
+        for (size_t i = first; i < last; ++i) {
+            dead_literals_ += is_literal(types_[i]);
+        }
+        if (shift_from_ >= last) {
+            shift_from_ = shift_from_ == NO_SHIFT ? NO_SHIFT : shift_from_ - removed + count;
+        } else if (shift_from_ > first) {
+            // The shifted head of the range is gone; the tail keeps its shift.
+            shift_from_ = first + count;
+        }
+
+        // Only the difference in length moves the tail; the overlap is overwritten.
+        resize_range(types_, first, removed, count);
+        resize_range(starts_, first, removed, count);
+        resize_range(lens_, first, removed, count);
+        resize_range(indices_, first, removed, count);
+
+        for (size_t i = 0; i < count; ++i) {
+            types_[first + i] = fresh.types_[i];
+            // Stored relative to the pending shift so that start() reads them back as is.
+            starts_[first + i] = fresh.start(i) - (first + i >= shift_from_ ? shift_ : 0);
+            lens_[first + i] = fresh.lens_[i];
+            indices_[first + i] = is_literal(fresh.types_[i])
+                ? add_literal(fresh.literals_[fresh.indices_[i]])
+                : fresh.indices_[i];
+        }
+
+        source_ = source;
+        shift_tail(first + count, delta);
+        if (dead_literals_ * 2 > literals_.size()) {
+            compact_literals();
+        }
+    }
+
+private:
+    static constexpr size_t NO_SHIFT = SIZE_MAX;
+
+    template<typename T>
+    static void resize_range(std::vector<T>& column, size_t first, size_t removed, size_t count) {
+        if (count > removed) {
+            column.insert(column.begin() + first + removed, count - removed, T{});
+        } else if (count < removed) {
+            column.erase(column.begin() + first + count, column.begin() + first + removed);
+        }
+    }
+
+    static constexpr bool is_literal(TokenType type) {
+        return type == TokenType::Integer || type == TokenType::Float;
+    }
+
+    // Rewrites the literal table to hold only the literals tokens still refer to.
+    void compact_literals() {
+        std::vector<LiteralValue> live;
+        live.reserve(literals_.size() - dead_literals_);
+        for (size_t i = 0; i < size(); ++i) {
+            if (is_literal(types_[i])) {
+                live.push_back(literals_[indices_[i]]);
+                indices_[i] = static_cast<uint32_t>(live.size() - 1);
+            }
+        }
+        literals_ = std::move(live);
+        dead_literals_ = 0;
+    }
+
+    /*
+    Moves every start from token `from` onwards by `delta`. The shift is kept
+    pending and only written back between the old and the new split point, so
+    consecutive edits close to each other stay cheap no matter how long the
+    tail is. Offsets wrap modulo 2^32, which makes negative deltas work too.
+    */
+    void shift_tail(size_t from, int64_t delta) {
+        const uint32_t d = static_cast<uint32_t>(delta);
+        if (d == 0 || from >= size()) {
+            return;
+        }
+        if (shift_from_ == NO_SHIFT) {
+            shift_from_ = from;
+            shift_ = d;
+        } else if (from >= shift_from_) {
+            for (size_t i = shift_from_; i < from; ++i) {
+                starts_[i] += shift_;
+            }
+            shift_from_ = from;
+            shift_ += d;
+        } else {
+            for (size_t i = from; i < shift_from_; ++i) {
+                starts_[i] += d;
+            }
+            shift_ += d;
+        }
+    }
+
+    std::string_view source_;
+    std::vector<TokenType> types_;
+    std::vector<uint32_t> starts_;
+    std::vector<uint32_t> lens_;
+    std::vector<uint32_t> indices_;
+    std::vector<LiteralValue> literals_;
+    // Entries of `literals_` no token refers to any more, left behind by splice().
+    size_t dead_literals_ = 0;
+    // Pending offset shift applied to every start from `shift_from_` onwards.
+    size_t shift_from_ = NO_SHIFT;
+    uint32_t shift_ = 0;
+};
+
+class Tokenizer {
+private:
+    // Borrowed, never copied: the caller keeps the text (usually a SourceFile) alive.
+    std::string_view source;
+    TokenStream tokens;
+    std::vector<LexError> errors;
+    uint32_t start = 0;
+    uint32_t current = 0;
+
+    bool isAtEnd() const {
+        return current >= source.length();
+    }
+
+    char advance() {
+        return source[current++];
+    }
+
+    void addToken(TokenType type) {
+        tokens.push(type, start, current - start);
+    }
+
+    // Emits [start, current) as an Unknown token and records why.
+    void addError(const char* what) {
+        addToken(TokenType::Unknown);
+        errors.push_back(LexError{start, current - start, what});
+    }
+
+
+    char peek() const {
+        if (isAtEnd()) return '\0';
+        return source[current];
+    }
+
+    // Eats the next character if it is `expected`, for two-character operators.
+    bool matchChar(char expected) {
+        if (peek() != expected) return false;
+        current++;
+        return true;
+    }
+
+    void number() {
+        // Same grammar as the low-level lexer: bases, `_` separators, exponents and suffixes.
+        Cursor cursor(source.substr(start));
+        cursor.bump();
+        const amyr::lexer::Token token = amyr::lexer::dispatch::numeric(cursor, source[start]);
+        current = start + cursor.pos_within_token();
+
+        auto value = amyr::lexer::literal_value(source.substr(start, current - start), token);
+        if (value.is_err()) {
+            addError(amyr::lexer::describe(value.unwrap_err()));
+            return;
+        }
+        const LiteralValue literal = value.unwrap();
+        const TokenType type = literal.is_float ? TokenType::Float : TokenType::Integer;
+        tokens.push(type, start, current - start, tokens.add_literal(literal));
+    }
+
+    // Decodes the character at `pos`; the source was validated when it was loaded.
+    char32_t decodeAt(uint32_t pos, size_t& len) const {
+        return amyr::unicode::decode(source.data() + pos, source.data() + source.size(), len);
+    }
+
+    void identifier() {
+        while (!isAtEnd()) {
+            const unsigned char c = static_cast<unsigned char>(peek());
+            if (c < 0x80) {
+                if (!amyr::lexer::is_ascii_id_continue(c)) break;
+                advance();
+                continue;
+            }
+            size_t len;
+            if (!amyr::unicode::is_xid_continue(decodeAt(current, len))) break;
+            current += len;
+        }
+        
+        std::string_view text = source.substr(start, current - start);
+        
+        // Check if it's a keyword
+        amyr::span::Symbol keyword = amyr::lexer::lookup_keyword(text);
+        TokenType type = keyword_type(keyword);
+        if (type != TokenType::Identifier) {
+            addToken(type);
+            return;
+        }
+
+        // Identifiers carry their interned Symbol so later phases never look at the text.
+        // Keywords this language doesn't reserve (yet) are already pre-interned.
+        amyr::span::Symbol sym = keyword.is_keyword() ? keyword : amyr::span::Symbol::intern(text);
+        tokens.push(TokenType::Identifier, start, current - start, sym.as_u32());
+    }
+
+    void skipComment() {
+        // Single-line comment
+        while (peek() != '\n' && !isAtEnd()) advance();
+    }
+
+public:
+    // Token type of a keyword Symbol; Identifier for anything we don't reserve.
+    static constexpr TokenType keyword_type(amyr::span::Symbol keyword) {
+        namespace kw = amyr::span::kw;
+        switch (keyword.as_u32()) {
+            case kw::Let.as_u32(): return TokenType::Let;
+            case kw::Mut.as_u32(): return TokenType::Mut;
+            case kw::Func.as_u32(): return TokenType::Func;
+            case kw::Return.as_u32(): return TokenType::Return;
+            case kw::If.as_u32(): return TokenType::If;
+            case kw::Else.as_u32(): return TokenType::Else;
+            default: return TokenType::Identifier;
+        }
+    }
+
+    // Only a source too big for u32 offsets is fatal; everything else ends up in diagnostics().
+    explicit Tokenizer(std::string_view source) : source(source), tokens(source) {
+        if (source.size() > UINT32_MAX) {
+            throw std::runtime_error("Source file exceeds 4 GiB");
+        }
+    }
+
+    explicit Tokenizer(const amyr::span::SourceFile& file) : Tokenizer(file.src()) {}
+
+    // Starts lexing at `offset`, which must be the start of a token or of trivia.
+    Tokenizer(std::string_view source, uint32_t offset) : Tokenizer(source) {
+        start = current = offset;
+    }
+
+    TokenStream tokenize() {
+        while (scanToken()) {}
+        tokens.push(TokenType::EOF_TOKEN, current, 0);
+        return std::move(tokens);
+    }
+
+    /*
+    Skips trivia and lexes one token onto the stream. Returns false once only
+    trivia was left; the EOF token is not pushed.
+    */
+    bool scanToken() {
+        const size_t before = tokens.size();
+        while (!isAtEnd() && tokens.size() == before) {
+            start = current;
+            char c = advance();
+            switch (c) {
+                // Delimiters and operators
+                case '(': addToken(TokenType::LeftParen); break;
+                case ')': addToken(TokenType::RightParen); break;
+                case '{': addToken(TokenType::LeftBrace); break;
+                case '}': addToken(TokenType::RightBrace); break;
+                case '+': addToken(TokenType::Plus); break;
+                case '-': addToken(TokenType::Minus); break;
+                case '*': addToken(TokenType::Star); break;
+                case '/': 
+                    if (peek() == '/') {
+                        skipComment();
+                    } else {
+                        addToken(TokenType::Slash); 
+                    }
+                    break;
+                case '%': addToken(TokenType::Percent); break;
+                case '^': addToken(TokenType::Caret); break;
+                case '&': addToken(matchChar('&') ? TokenType::AndAnd : TokenType::And); break;
+                case '|': addToken(matchChar('|') ? TokenType::OrOr : TokenType::Or); break;
+                case '<':
+                    addToken(matchChar('<') ? TokenType::Shl : matchChar('=') ? TokenType::Le : TokenType::Lt);
+                    break;
+                case '>':
+                    addToken(matchChar('>') ? TokenType::Shr : matchChar('=') ? TokenType::Ge : TokenType::Gt);
+                    break;
+                case '=': addToken(matchChar('=') ? TokenType::EqEq : TokenType::Equals); break;
+                case '!':
+                    if (matchChar('=')) {
+                        addToken(TokenType::Ne);
+                    } else {
+                        addError("Unexpected character");
+                    }
+                    break;
+                case ',': addToken(TokenType::Comma); break;
+                case ';': addToken(TokenType::Semicolon); break;
+
+                // Whitespace handling
+                case ' ':
+                case '\r':
+                case '\t':
+                    break;
+                case '\n':
+                    break;
+
+                // Numeric and identifier handling
+                default: {
+                    const unsigned char byte = static_cast<unsigned char>(c);
+                    size_t len = 1;
+                    if (amyr::lexer::is_ascii_digit(byte)) {
+                        number();
+                    } else if (amyr::lexer::is_ascii_id_start(byte)) {
+                        identifier();
+                    } else if (byte >= 0x80 && amyr::unicode::is_xid_start(decodeAt(start, len))) {
+                        current = start + static_cast<uint32_t>(len);
+                        identifier();
+                    } else {
+                        current = start + static_cast<uint32_t>(len);
+                        addError("Unexpected character");
+                    }
+                    break;
+                }
+            }
+        }
+        return tokens.size() != before;
+    }
+
+    /*
+    Streaming mode: lexes the next token without keeping it, so memory stays
+    constant however long the input is. Numeric values are written to `literal`.
+    Keeps returning the EOF token once the input is exhausted.
+    */
+    Token next(LiteralValue& literal) {
+        tokens.clear();
+        if (!scanToken()) {
+            return Token{TokenType::EOF_TOKEN, current, 0, Token::NO_INDEX};
+        }
+        Token token = tokens[0];
+        if (token.type == TokenType::Integer || token.type == TokenType::Float) {
+            literal = tokens.literal(0);
+        }
+        return token;
+    }
+
+    // Tokens scanned so far.
+    const TokenStream& stream() const { return tokens; }
+
+    // Errors found so far, in source order. Kept across next() calls.
+    const std::vector<LexError>& diagnostics() const { return errors; }
+
+    // Every error as `... at line N`, resolving lines in one pass over the source.
+    std::vector<std::string> diagnostic_messages() const {
+        std::vector<std::string> messages;
+        if (errors.empty()) {
+            return messages;
+        }
+        const amyr::span::LineIndex lines(source);
+        messages.reserve(errors.size());
+        for (const LexError& error : errors) {
+            messages.push_back(error.describe(source, lines));
+        }
+        return messages;
+    }
+
+    uint32_t position() const { return current; }
+};
@@ -1,632 +1,772 @@
-// Utilities for validating string and char literals and turning them into values they represent.
-
-#pragma once
-
-#include<string>
-#include<string_view>
-#include<optional>
-#include<variant>
-#include<cctype>
-#include<cassert>
-#include<iostream>
-#include<functional>
-#include<stdexcept>
-#include<ranges>
-
-#include "amyr-debug-utils/unreachable.hpp"
-#include "amyr-utils/result.hpp"
-
-
-enum EscapeError {
-    
-    /*
-    Errors and warnings that can occur during string unescaping. 
-    They mostly relate to malformed escape sequences, but 
-    there are a few that are about other problems
-    */
-    
-    // Expected 1 char, but 0 were found.
-    ZeroChars,
-    // Expected 1 char, but more than 1 were found.
-    MoreThanOneChar,
-
-    // Escaped '\' character without continuation.
-    LoneSlash,
-    // Invalid escape character (e.g. '\z').
-    InvalidEscape,
-    // Raw '\r' encountered.
-    BareCarriageReturn,
-    // Raw '\r' encountered in raw string.
-    BareCarriageReturnInRawString,
-    // Unescaped character that was expected to be escaped (e.g. raw '\t').
-    EscapeOnlyChar,
-
-    // Numeric character escape is too short (e.g. '\x1').
-    TooShortHexEscape,
-    // Invalid character in numeric escape (e.g. '\xz')
-    InvalidCharInHexEscape,
-    // Character code in numeric escape is non-ascii (e.g. '\xFF').
-    OutOfRangeHexEscape,
-
-    // '\u' not followed by '{'.
-    NoBraceInUnicodeEscape,
-    // Non-hexadecimal value in '\u{..}'.
-    InvalidCharInUnicodeEscape,
-    // '\u{}'
-    EmptyUnicodeEscape,
-    // No closing brace in '\u{..}', e.g. '\u{12'.
-    UnclosedUnicodeEscape,
-    // '\u{_12}'
-    LeadingUnderscoreUnicodeEscape,
-    // More than 6 characters in '\u{..}', e.g. '\u{10FFFF_FF}'
-    OverlongUnicodeEscape,
-    // Invalid in-bound unicode character code, e.g. '\u{DFFF}'.
-    LoneSurrogateUnicodeEscape,
-    // Out of bounds unicode character code, e.g. '\u{FFFFFF}'.
-    OutOfRangeUnicodeEscape,
-
-    // Unicode escape code in byte literal.
-    UnicodeEscapeInByte,
-    // Non-ascii character in byte literal, byte string literal, or raw byte string literal.
-    NonAsciiCharInByte,
-
-    // `\0` in a C string literal.
-    NulInCStr,
-
-    // After a line ending with '\', the next line contains whitespace characters that are not skipped.
-    UnskippedWhitespaceWarning,
-
-    // After a line ending with '\', multiple lines are skipped.
-    MultipleSkippedLinesWarning
-};
-
-
-bool is_fatal(EscapeError error) {
-    /*
-    Determines if an error is fatal
-    */
-
-    return error != EscapeError::UnskippedWhitespaceWarning ||
-           error != EscapeError::MultipleSkippedLinesWarning;
-}
-
-
-/*
-What kind of literal do we parse
-*/
-enum Mode {
-    Char,
-    
-    Byte,
-    
-    Str,
-    RawStr,
-
-    ByteStr,
-    RawByteStr,
-
-    CStr,
-    RawCStr
-};
-
-/*
-Utils for Mode enum
-*/
-bool in_double_quotes(Mode mode) {
-    switch (mode)
-    {
-        case Mode::Char:
-        case Mode::Byte:
-            return false;
-        
-    
-    
-        //Since this is a enum and the `state` to speak is only a few possible things, 
-        //if it isn't Mode::Char or Mode::Byte, the others are true.
-        //An unusual optimization, but an optimization none the less
-    
-        default:
-            return true;
-        }
-}
-
-
-/*
-Are `\x80`, `\xff` allowed?
-*/
-bool allow_high_bytes(Mode mode) {
-
-    switch (mode)
-    {
-        case Mode::Char:
-        case Mode::Str:
-            return false;
-        
-        case Mode::Byte:
-        case Mode::ByteStr:
-        case Mode::CStr:
-            return true;
-
-        case Mode::RawStr:
-        case Mode::RawByteStr:
-        case Mode::RawCStr:
-            UNREACHABLE();
-    }
-}
-
-// Are unicode (non-ASCII) chars allowed?
-inline bool allow_unicode_chars(Mode mode) {
-    switch (mode)
-    {
-    case Mode::Byte:
-    case Mode::ByteStr:
-    case Mode::RawByteStr:
-        return false;
-    
-    
-    // similar optimization as in_double_quotes()
-    
-    default:
-        return true;
-    }
-}
-
-
-// Are unicode escapes (`\u`) allowed?
-bool allow_unicode_escapes(Mode mode) {
-    switch (mode) {
-        case Mode::Byte:
-        case Mode::ByteStr:
-            return false;
-
-        case Mode::Char:
-        case Mode::Str:
-        case Mode::CStr:
-            return true;
-
-        default:
-            UNREACHABLE(); 
-    }
-}
-
-
-const std::string prefix_noraw(Mode mode) {
-    switch (mode) {
-        case Mode::Char:
-        case Mode::Str:
-        case Mode::RawStr:
-            return "";
-
-        case Mode::Byte:
-        case Mode::ByteStr:
-        case Mode::RawByteStr:
-            return "b";
-
-        case CStr:
-        case RawCStr:
-            return "c";
-    }
-}
-
-
-ResultEsc<MixedUnit> scan_escape(std::string::iterator& it, std::string::iterator end, Mode mode) {
-    // Previous character was '\\', unescape what follows.
-    char res;
-    char c;
-    if (it == end) {
-        return ResultEsc<MixedUnit>::Err(LoneSlash);
-    } else {
-        c = *it++;
-    }
-
-    switch (c) {
-        case '"' : res = '"'; break;
-        case 'n' : res = '\n'; break;
-        case 'r' : res = '\r'; break;
-        case 't' : res = '\t'; break;
-        case '\\' : res = '\\'; break;
-        case '\'' : res = '\''; break;
-        case '0' : res = '\0'; break;
-        case 'x' : {
-            //Parse Hexadeecimal character code
-            if (std::distance(it, end) < 2) {
-                return ResultEsc<MixedUnit>::Err(TooShortHexEscape);
-            }
-
-            char hi = *it++;
-            char lo = *it++;
-            if (!std::isxdigit(hi) || !std::isxdigit(lo)) {
-                return ResultEsc<MixedUnit>::Err(InvalidCharInHexEscape);
-            }
-
-            int value = (std::stoi(std::string(1, hi), nullptr, 16) << 4) + std::stoi(std::string(1, lo), nullptr, 16);
-
-            if (value > 127 && mode != Mode::Byte) {
-                return ResultEsc<MixedUnit>::Err(OutOfRangeHexEscape);
-            }
-
-            return ResultEsc<MixedUnit>::Ok(MixedUnit(static_cast<char>(value)));
-        }
-
-        case 'u' : {
-            ResultEsc<char> res1 = scan_unicode(it, end, allow_unicode_escapes(mode));
-            if(res1.is_ok()) {
-                return ResultEsc<MixedUnit>::Ok(MixedUnit(res1.unwrap()));
-            } else {
-                return ResultEsc<MixedUnit>::Err(res1.unwrap_err());
-            }
-        }
-        default: return ResultEsc<MixedUnit>::Err(InvalidEscape);
-
-    }
-
-    return ResultEsc<MixedUnit>::Ok(MixedUnit(res));
-    
-}
-
-ResultEsc<char> scan_unicode(std::string::iterator &it, std::string::iterator &end, bool allow_unicode_escape_) {
-    // We've parsed '\u', now we have to parse '{..}'.
-    if (*it++ == '{') {
-        return ResultEsc<char>::Err(NoBraceInUnicodeEscape);
-    }
-
-    char first_char = *it++;
-
-    if (first_char == '_') {
-        return ResultEsc<char>::Err(LeadingUnderscoreUnicodeEscape);
-    } else if (first_char == '}') {
-        return ResultEsc<char>::Err(EmptyUnicodeEscape);
-    } 
-    
-    u_int32_t value = 0;
-    int n_digits = 0;
-
-    auto parse_digit = [&] (char c) -> ResultEsc<void> {
-        if (c == '_') {
-            return ResultEsc<void>(); //ignores underscores
-        }
-
-        if (c == '}') {
-            if (n_digits > 6) {
-                return ResultEsc<void>::Err(OverlongUnicodeEscape);
-            }
-
-            if(!allow_unicode_escape_) {
-                return ResultEsc<void>::Err(UnicodeEscapeInByte);
-            }
-
-            return ResultEsc<void>();
-        }
-
-        uint32_t digit = std::isdigit(c) ? (c - 48) : (std::tolower(c) - 97 + 10); //48 is '0' and 97 is 'a'
-
-        if(digit > 15) {
-            return ResultEsc<void>::Err(InvalidCharInUnicodeEscape);
-        }
-
-        value = value * 16 + digit;
-        n_digits++;
-
-        if (value > 0x10FFFF) {
-            return ResultEsc<void>::Err(OutOfRangeUnicodeEscape);
-        }
-
-        return ResultEsc<void>();
-    };
-
-    while (it != end) {
-        char c = *it++;
-        ResultEsc<void> result = parse_digit(c);
-        if(result.is_err()) {
-            return ResultEsc<char>::Err(result.unwrap_err());
-        } else if (c == '}') {
-            break;
-        }
-    }
-
-    if (it == end) {
-        return ResultEsc<char>::Err(UnclosedUnicodeEscape);
-    }
-
-    if (value >= 0xD800 && value <= 0xDFFF) {
-        return ResultEsc<char>::Err(LoneSurrogateUnicodeEscape);
-    }
-
-    return ResultEsc<char>::Ok(static_cast<char>(value));
-}
-
-
-
-class MixedUnit {
-/*
-Used for mixed utf8 string literals, i.e. those that allow both unicode chars and high bytes.
-*/
-public:
-
-    /*
-    Used for ASCII chars (written directly or via `\x00`..`\x7f` escapes)
-    and Unicode chars (written directly or via `\u` escapes).
-    
-    For example, if '¥' appears in a string it is represented here as
-    `MixedUnit::Char('¥')`, and it will be appended to the relevant byte
-    string as the two-byte UTF-8 sequence `[0xc2, 0xa5]`
-    */
-    explicit MixedUnit(char c) : value(c) {}
-    
-    
-    /*
-    Used for high bytes (`\x80`..`\xff`).
-    
-    For example, if `\xa5` appears in a string it is represented here as
-    `MixedUnit::HighByte(0xa5)`, and it will be appended to the relevant
-    byte string as the single byte `0xa5`.
-    */
-    explicit MixedUnit(uint8_t b) : value(b) {}
-
-    bool is_char() const { return std::holds_alternative<char>(value); }
-    bool is_high_byte() const { return std::holds_alternative<uint8_t>(value); }
-
-    char as_char() const { return std::get<char>(value); }
-    uint8_t as_high_byte() const { return std::get<uint8_t>(value); }
-
-private:
-    std::variant<char, uint8_t> value;
-};
-
-template <typename T>
-using ResultEsc = Result<T, EscapeError>;
-
-MixedUnit to_mixed_unit(char c) { return MixedUnit(c); }
-MixedUnit to_mixed_unit(uint8_t b) { return MixedUnit(b); }
-
-
-inline ResultEsc<char> ascii_check(char c, bool allow_unicode_characters) {
-    if (allow_unicode_characters || static_cast<unsigned char>(c) < 128) {
-        return ResultEsc<char>::Ok(c);
-    } else {
-        return ResultEsc<char>::Err(NonAsciiCharInByte);
-    }
-}
-
-void unescape_unicode(std::string& src, Mode mode, std::function<void(std::pair<size_t, size_t>, Result<MixedUnit, EscapeError>)> &callback) {
-    switch (mode)
-    {
-        case Mode::Char:
-        case Mode::Byte:
-            std::string::iterator it = src.begin();
-            ResultEsc<MixedUnit> res = ResultEsc<MixedUnit>::Ok(MixedUnit(unescape_char_or_byte(it, src.end(), mode).unwrap()));
-            callback({0, static_cast<size_t>(std::distance(src.begin(), it))}, res);
-            break;
-
-        case Mode::Str:
-        case Mode::ByteStr:
-            unescape_non_raw_common(src, mode, callback);
-            break;
-
-        case Mode::RawStr:
-        case Mode::RawByteStr:
-            check_raw_common(src, mode, callback);
-            break;
-
-        case Mode::RawCStr:
-            break;
-
-        case Mode::CStr: UNREACHABLE();
-    }
-}
-
-Result<char, EscapeError> unescape_char_or_byte(std::string::iterator& it, 
-            const std::string::iterator& end, 
-            Mode mode) {
-    if (it == end) {
-        return Result<char, EscapeError>::Err(EscapeError::ZeroChars);
-    }
-
-    char c = *it++;
-    Result<char, EscapeError> res;
-
-    switch (c) {
-        case '\\': {
-            // Handle escape sequences
-            if (it == end) {
-                return Result<char, EscapeError>::Err(EscapeError::LoneSlash);
-            }
-
-            ResultEsc<MixedUnit> esc_result = scan_escape(it, end, mode);
-            if (esc_result.is_err()) {
-                return Result<char, EscapeError>::Err(esc_result.unwrap_err());
-            }
-
-            MixedUnit unit = esc_result.unwrap();
-            if (unit.is_char()) {
-                res = Result<char, EscapeError>::Ok(unit.as_char());
-            } else {
-                // For byte mode, convert high byte to char
-                if (mode == Mode::Byte || mode == Mode::ByteStr) {
-                    res = Result<char, EscapeError>::Ok(
-                    static_cast<char>(unit.as_high_byte())
-                    );
-                } else {
-                    return Result<char, EscapeError>::Err(
-                    EscapeError::NonAsciiCharInByte
-                    );
-                }
-            }
-            break;
-        }
-
-        case '\n':
-        case '\t':
-        case '\'': {
-            res = Result<char, EscapeError>::Err(EscapeError::EscapeOnlyChar);
-            break;
-        }
-
-        case '\r': {
-            res = Result<char, EscapeError>::Err(EscapeError::BareCarriageReturn);
-            break;
-        }
-
-        default: {
-        // Check ASCII validity for byte modes
-            ResultEsc<char> checked = ascii_check(c, allow_unicode_chars(mode));
-                if (checked.is_ok()) {
-                res = Result<char, EscapeError>::Ok(checked.unwrap());
-            } else {
-                res = Result<char, EscapeError>::Err(checked.unwrap_err());
-            }
-            break;
-        }
-    }
-
-    // Check for trailing characters
-    if (it != end) {
-        return Result<char, EscapeError>::Err(EscapeError::MoreThanOneChar);
-    }
-
-    return res;
-}
-
-/* 
-Takes a contents of a string literal (without quotes) and produces a sequence of escaped characters or errors
-*/
-void unescape_non_raw_common(std::string& src, Mode mode, 
-        std::function<void(std::pair<size_t, size_t>, Result<MixedUnit, EscapeError>)> &callback) {
-    auto it = src.begin();
-    auto end = src.end();
-    bool allow_unicode = allow_unicode_chars(mode);
-
-    while (it != end) {
-        size_t start = std::distance(src.begin(), it);
-        Result<MixedUnit, EscapeError> res;
-        char c = *it++;
-
-        if (c == '\\') {
-        // Handle escaped newline and whitespace skipping
-        if (it != end && *it == '\n') {
-            ++it; // Skip newline
-            skip_ascii_whitespace(src, it, end, start, callback);
-            continue;
-        }
-
-        // Process escape sequence
-        auto escape_start = it-1;
-        auto scan_res = scan_escape(it, end, mode);
-        size_t escape_end = std::distance(src.begin(), it);
-
-        if (scan_res.is_ok()) {
-            res = scan_res;
-        } else {
-            res = Result<MixedUnit, EscapeError>::Err(scan_res.unwrap_err());
-        }
-            callback({start, escape_end}, res);
-            continue;
-        }
-
-        // Handle normal characters
-        if (c == '"') {
-            res = Result<MixedUnit, EscapeError>::Err(EscapeError::EscapeOnlyChar);
-        } else if (c == '\r') {
-            res = Result<MixedUnit, EscapeError>::Err(EscapeError::BareCarriageReturn);
-        } else {
-            auto check_res = ascii_check(c, allow_unicode);
-            if (check_res.is_ok()) {
-                res = Result<MixedUnit, EscapeError>::Ok(MixedUnit(check_res.unwrap()));
-            } else {
-                res = Result<MixedUnit, EscapeError>::Err(check_res.unwrap_err());
-            }
-        }
-
-        callback({start, start + 1}, res);
-    }
-}
-
-/* 
-Takes a contents of a string literal (without quotes) and produces a sequence of characters or errors. 
-NOTE: Raw strings do not perform any explicit character escaping, here we only produce errors on bare CR.
-*/
-void check_raw_common(std::string &src, Mode mode, std::function<void(std::pair<size_t, size_t>, ResultEsc<MixedUnit>)> &callback) {
-    std::string::iterator it = src.begin();
-    std::string::iterator end = src.end();
-    bool allow_unicode_chars_ = allow_unicode_chars(mode);
-}
-
-
-void skip_ascii_whitespace(std::string& src, 
-        std::string::iterator& it, 
-        std::string::iterator end, 
-        size_t start,
-        std::function<void(std::pair<size_t, size_t>, Result<MixedUnit, EscapeError>)> &callback) {
-    
-    size_t first_non_space = 0;
-    std::string_view tail(it, end);
-
-    // Find first non-whitespace
-    while (first_non_space < tail.size() && 
-    (tail[first_non_space] == ' ' || 
-    tail[first_non_space] == '\t' || 
-    tail[first_non_space] == '\r')) {
-        first_non_space++;
-    }
-
-    // Check for multiple newlines
-    if (tail.substr(0, first_non_space).find('\n') != std::string_view::npos) {
-        callback({start, start + first_non_space + 1}, 
-        Result<MixedUnit, EscapeError>::Err(EscapeError::MultipleSkippedLinesWarning));
-    }
-
-    // Check for remaining whitespace
-    if (first_non_space < tail.size() && 
-    (tail[first_non_space] == ' ' || tail[first_non_space] == '\t')) {
-        callback({start, start + first_non_space + 1},
-        Result<MixedUnit, EscapeError>::Err(EscapeError::UnskippedWhitespaceWarning));
-    }
-
-    // Advance iterator
-    std::advance(it, first_non_space);
-}
-
-void check_raw_common(std::string &src, Mode mode, 
-        std::function<void(std::pair<size_t, size_t>, ResultEsc<MixedUnit>)> &callback) {
-    auto it = src.begin();
-    auto end = src.end();
-    bool allow_unicode = allow_unicode_chars(mode);
-
-    while (it != end) {
-        size_t start = std::distance(src.begin(), it);
-        char c = *it++;
-        ResultEsc<MixedUnit> res;
-
-        if (c == '\r') {
-            res = ResultEsc<MixedUnit>::Err(EscapeError::BareCarriageReturnInRawString);
-        } else {
-            auto check_res = ascii_check(c, allow_unicode);
-            if (check_res.is_ok()) {
-                res = ResultEsc<MixedUnit>::Ok(MixedUnit(check_res.unwrap()));
-            } else {
-                res = ResultEsc<MixedUnit>::Err(check_res.unwrap_err());
-            }
-        }
-
-        callback({start, start + 1}, res);
-    }
-}
-
-void unescape_mixed(std::string& src, Mode mode,
-        std::function<void(std::pair<size_t, size_t>, Result<MixedUnit, EscapeError>)> &callback) {
-    
-    if (mode != Mode::CStr) UNREACHABLE();
-
-    // Create a named intermediate callback
-    std::function<void(std::pair<size_t, size_t>, Result<MixedUnit, EscapeError>)> wrapper = 
-            [&](std::pair<size_t, size_t> range, Result<MixedUnit, EscapeError> result) {
-        
-        if (result.is_ok() && result.unwrap().is_char() && result.unwrap().as_char() == '\0') {
-            callback(range, Result<MixedUnit, EscapeError>::Err(EscapeError::NulInCStr));
-        } else {
-            callback(range, result);
-        }
-    };
-
-    unescape_non_raw_common(src, mode, wrapper);
-}
+// Utilities for validating string and char literals and turning them into values they represent.
+
+/*
+The callback-based functions report every character of a literal together
+with its byte range, which is what diagnostics need. They are templates, so
+the callback is inlined into the scanning loop instead of going through a
+std::function per character.
+
+Building values doesn't need per-character results: `unescaped_borrowed`
+returns literals without escapes as they are, and `unescape_into_arena`
+unescapes the rest in bulk, copying the runs between escapes with memcpy.
+*/
+#pragma once
+
+#include<cstdint>
+#include<cstring>
+#include<optional>
+#include<string_view>
+#include<utility>
+
+#include "low_lexer.hpp"
+#include "simd_scan.hpp"
+#include "utf8.hpp"
+#include "amyr-debug-utils/unreachable.hpp"
+#include "amyr-parser/arena.hpp"
+#include "amyr-utils/result.hpp"
+
+namespace amyr {
+namespace lexer {
+
+enum class EscapeError : uint8_t {
+
+    /*
+    Errors and warnings that can occur during string unescaping.
+    They mostly relate to malformed escape sequences, but
+    there are a few that are about other problems
+    */
+
+    // Expected 1 char, but 0 were found.
+    ZeroChars,
+    // Expected 1 char, but more than 1 were found.
+    MoreThanOneChar,
+
+    // Escaped '\' character without continuation.
+    LoneSlash,
+    // Invalid escape character (e.g. '\z').
+    InvalidEscape,
+    // Raw '\r' encountered.
+    BareCarriageReturn,
+    // Raw '\r' encountered in raw string.
+    BareCarriageReturnInRawString,
+    // Unescaped character that was expected to be escaped (e.g. raw '\t').
+    EscapeOnlyChar,
+
+    // Numeric character escape is too short (e.g. '\x1').
+    TooShortHexEscape,
+    // Invalid character in numeric escape (e.g. '\xz')
+    InvalidCharInHexEscape,
+    // Character code in numeric escape is non-ascii (e.g. '\xFF').
+    OutOfRangeHexEscape,
+
+    // '\u' not followed by '{'.
+    NoBraceInUnicodeEscape,
+    // Non-hexadecimal value in '\u{..}'.
+    InvalidCharInUnicodeEscape,
+    // '\u{}'
+    EmptyUnicodeEscape,
+    // No closing brace in '\u{..}', e.g. '\u{12'.
+    UnclosedUnicodeEscape,
+    // '\u{_12}'
+    LeadingUnderscoreUnicodeEscape,
+    // More than 6 characters in '\u{..}', e.g. '\u{10FFFF_FF}'
+    OverlongUnicodeEscape,
+    // Invalid in-bound unicode character code, e.g. '\u{DFFF}'.
+    LoneSurrogateUnicodeEscape,
+    // Out of bounds unicode character code, e.g. '\u{FFFFFF}'.
+    OutOfRangeUnicodeEscape,
+
+    // Unicode escape code in byte literal.
+    UnicodeEscapeInByte,
+    // Non-ascii character in byte literal, byte string literal, or raw byte string literal.
+    NonAsciiCharInByte,
+
+    // `\0` in a C string literal.
+    NulInCStr,
+
+    // After a line ending with '\', the next line contains whitespace characters that are not skipped.
+    UnskippedWhitespaceWarning,
+
+    // After a line ending with '\', multiple lines are skipped.
+    MultipleSkippedLinesWarning
+};
+
+
+inline bool is_fatal(EscapeError error) {
+    /*
+    Determines if an error is fatal
+    */
+
+    return error != EscapeError::UnskippedWhitespaceWarning &&
+           error != EscapeError::MultipleSkippedLinesWarning;
+}
+
+
+/*
+What kind of literal do we parse
+*/
+enum class Mode : uint8_t {
+    Char,
+
+    Byte,
+
+    Str,
+    RawStr,
+
+    ByteStr,
+    RawByteStr,
+
+    CStr,
+    RawCStr
+};
+
+/*
+Utils for Mode enum
+*/
+inline bool in_double_quotes(Mode mode) {
+    switch (mode)
+    {
+        case Mode::Char:
+        case Mode::Byte:
+            return false;
+
+
+
+        //Since this is a enum and the `state` to speak is only a few possible things,
+        //if it isn't Mode::Char or Mode::Byte, the others are true.
+        //An unusual optimization, but an optimization none the less
+
+        default:
+            return true;
+        }
+}
+
+
+inline bool is_raw(Mode mode) {
+    return mode == Mode::RawStr || mode == Mode::RawByteStr || mode == Mode::RawCStr;
+}
+
+
+/*
+Are `\x80`, `\xff` allowed?
+*/
+inline bool allow_high_bytes(Mode mode) {
+
+    switch (mode)
+    {
+        case Mode::Char:
+        case Mode::Str:
+            return false;
+
+        case Mode::Byte:
+        case Mode::ByteStr:
+        case Mode::CStr:
+            return true;
+
+        default:
+            UNREACHABLE();
+    }
+}
+
+// Are unicode (non-ASCII) chars allowed?
+inline bool allow_unicode_chars(Mode mode) {
+    switch (mode)
+    {
+    case Mode::Byte:
+    case Mode::ByteStr:
+    case Mode::RawByteStr:
+        return false;
+
+
+    // similar optimization as in_double_quotes()
+
+    default:
+        return true;
+    }
+}
+
+
+// Are unicode escapes (`\u`) allowed?
+inline bool allow_unicode_escapes(Mode mode) {
+    switch (mode) {
+        case Mode::Byte:
+        case Mode::ByteStr:
+            return false;
+
+        case Mode::Char:
+        case Mode::Str:
+        case Mode::CStr:
+            return true;
+
+        default:
+            UNREACHABLE();
+    }
+}
+
+
+inline std::string_view prefix_noraw(Mode mode) {
+    switch (mode) {
+        case Mode::Char:
+        case Mode::Str:
+        case Mode::RawStr:
+            return "";
+
+        case Mode::Byte:
+        case Mode::ByteStr:
+        case Mode::RawByteStr:
+            return "b";
+
+        default:
+            return "c";
+    }
+}
+
+
+class MixedUnit {
+/*
+Used for mixed utf8 string literals, i.e. those that allow both unicode chars and high bytes.
+*/
+public:
+
+    /*
+    Used for ASCII chars (written directly or via `\x00`..`\x7f` escapes)
+    and Unicode chars (written directly or via `\u` escapes).
+
+    For example, if '¥' appears in a string it is represented here as
+    `MixedUnit::from_char('¥')`, and it will be appended to the relevant byte
+    string as the two-byte UTF-8 sequence `[0xc2, 0xa5]`
+    */
+    static MixedUnit from_char(char32_t c) { return MixedUnit(c, false); }
+
+
+    /*
+    Used for high bytes (`\x80`..`\xff`).
+
+    For example, if `\xa5` appears in a string it is represented here as
+    `MixedUnit::high_byte(0xa5)`, and it will be appended to the relevant
+    byte string as the single byte `0xa5`.
+    */
+    static MixedUnit high_byte(uint8_t b) { return MixedUnit(b, true); }
+
+    bool is_char() const { return !high_; }
+    bool is_high_byte() const { return high_; }
+
+    char32_t as_char() const { return value_; }
+    uint8_t as_high_byte() const { return static_cast<uint8_t>(value_); }
+
+    // Appends the unit's bytes to `out` and returns how many were written.
+    size_t encode(char* out) const {
+        if (high_) {
+            out[0] = static_cast<char>(value_);
+            return 1;
+        }
+        return amyr::unicode::encode(value_, out);
+    }
+
+    bool operator==(const MixedUnit& other) const {
+        return value_ == other.value_ && high_ == other.high_;
+    }
+
+private:
+    MixedUnit(char32_t value, bool high) : value_(value), high_(high) {}
+
+    char32_t value_;
+    bool high_;
+};
+
+template <typename T>
+using ResultEsc = Result<T, EscapeError>;
+
+// Byte range of a character or escape within the literal contents.
+using EscapeRange = std::pair<size_t, size_t>;
+
+
+namespace escape_detail {
+
+    // Decodes the next character of the literal contents.
+    inline char32_t next_char(const char*& it, const char* end) {
+        const unsigned char byte = static_cast<unsigned char>(*it);
+        if (byte < 0x80) {
+            ++it;
+            return byte;
+        }
+        size_t len;
+        const char32_t c = amyr::unicode::decode(it, end, len);
+        it += len;
+        return c;
+    }
+
+    inline int hex_digit(char32_t c) {
+        if (c >= '0' && c <= '9') return static_cast<int>(c - '0');
+        if (c >= 'a' && c <= 'f') return static_cast<int>(c - 'a' + 10);
+        if (c >= 'A' && c <= 'F') return static_cast<int>(c - 'A' + 10);
+        return -1;
+    }
+
+} // namespace escape_detail
+
+
+inline ResultEsc<char32_t> ascii_check(char32_t c, bool allow_unicode_characters) {
+    if (allow_unicode_characters || c < 128) {
+        return ResultEsc<char32_t>::Ok(c);
+    } else {
+        return ResultEsc<char32_t>::Err(EscapeError::NonAsciiCharInByte);
+    }
+}
+
+
+inline ResultEsc<char32_t> scan_unicode(const char*& it, const char* end, bool allow_unicode_escape_) {
+    // We've parsed '\u', now we have to parse '{..}'.
+    if (it == end || *it != '{') {
+        return ResultEsc<char32_t>::Err(EscapeError::NoBraceInUnicodeEscape);
+    }
+    ++it;
+
+    if (it == end) {
+        return ResultEsc<char32_t>::Err(EscapeError::UnclosedUnicodeEscape);
+    }
+    const char32_t first_char = escape_detail::next_char(it, end);
+    if (first_char == '_') {
+        return ResultEsc<char32_t>::Err(EscapeError::LeadingUnderscoreUnicodeEscape);
+    } else if (first_char == '}') {
+        return ResultEsc<char32_t>::Err(EscapeError::EmptyUnicodeEscape);
+    }
+
+    const int first_digit = escape_detail::hex_digit(first_char);
+    if (first_digit < 0) {
+        return ResultEsc<char32_t>::Err(EscapeError::InvalidCharInUnicodeEscape);
+    }
+    uint32_t value = static_cast<uint32_t>(first_digit);
+    int n_digits = 1;
+
+    while (it != end) {
+        const char32_t c = escape_detail::next_char(it, end);
+        if (c == '_') {
+            continue; //ignores underscores
+        }
+
+        if (c == '}') {
+            if (n_digits > 6) {
+                return ResultEsc<char32_t>::Err(EscapeError::OverlongUnicodeEscape);
+            }
+            if (!allow_unicode_escape_) {
+                return ResultEsc<char32_t>::Err(EscapeError::UnicodeEscapeInByte);
+            }
+            if (value > 0x10FFFF) {
+                return ResultEsc<char32_t>::Err(EscapeError::OutOfRangeUnicodeEscape);
+            }
+            if (value >= 0xD800 && value <= 0xDFFF) {
+                return ResultEsc<char32_t>::Err(EscapeError::LoneSurrogateUnicodeEscape);
+            }
+            return ResultEsc<char32_t>::Ok(static_cast<char32_t>(value));
+        }
+
+        const int digit = escape_detail::hex_digit(c);
+        if (digit < 0) {
+            return ResultEsc<char32_t>::Err(EscapeError::InvalidCharInUnicodeEscape);
+        }
+        // Keep counting, so the error is Overlong rather than OutOfRange.
+        if (++n_digits > 6) {
+            continue;
+        }
+        value = value * 16 + static_cast<uint32_t>(digit);
+    }
+
+    return ResultEsc<char32_t>::Err(EscapeError::UnclosedUnicodeEscape);
+}
+
+
+inline ResultEsc<MixedUnit> scan_escape(const char*& it, const char* end, Mode mode) {
+    // Previous character was '\\', unescape what follows.
+    if (it == end) {
+        return ResultEsc<MixedUnit>::Err(EscapeError::LoneSlash);
+    }
+
+    char32_t res;
+    switch (escape_detail::next_char(it, end)) {
+        case '"' : res = '"'; break;
+        case 'n' : res = '\n'; break;
+        case 'r' : res = '\r'; break;
+        case 't' : res = '\t'; break;
+        case '\\' : res = '\\'; break;
+        case '\'' : res = '\''; break;
+        case '0' : res = '\0'; break;
+        case 'x' : {
+            //Parse Hexadecimal character code
+            if (it == end) {
+                return ResultEsc<MixedUnit>::Err(EscapeError::TooShortHexEscape);
+            }
+            const int hi = escape_detail::hex_digit(escape_detail::next_char(it, end));
+            if (hi < 0) {
+                return ResultEsc<MixedUnit>::Err(EscapeError::InvalidCharInHexEscape);
+            }
+            if (it == end) {
+                return ResultEsc<MixedUnit>::Err(EscapeError::TooShortHexEscape);
+            }
+            const int lo = escape_detail::hex_digit(escape_detail::next_char(it, end));
+            if (lo < 0) {
+                return ResultEsc<MixedUnit>::Err(EscapeError::InvalidCharInHexEscape);
+            }
+
+            const int value = (hi << 4) | lo;
+            if (value > 127) {
+                if (!allow_high_bytes(mode)) {
+                    return ResultEsc<MixedUnit>::Err(EscapeError::OutOfRangeHexEscape);
+                }
+                return ResultEsc<MixedUnit>::Ok(MixedUnit::high_byte(static_cast<uint8_t>(value)));
+            }
+            res = static_cast<char32_t>(value);
+            break;
+        }
+
+        case 'u' : {
+            ResultEsc<char32_t> res1 = scan_unicode(it, end, allow_unicode_escapes(mode));
+            if (res1.is_err()) {
+                return ResultEsc<MixedUnit>::Err(res1.unwrap_err());
+            }
+            res = res1.unwrap();
+            break;
+        }
+        default: return ResultEsc<MixedUnit>::Err(EscapeError::InvalidEscape);
+    }
+
+    return ResultEsc<MixedUnit>::Ok(MixedUnit::from_char(res));
+}
+
+
+/*
+Unescapes the contents of a char or byte literal (without quotes). Byte
+literals with a `\x80`..`\xff` escape yield the byte value.
+*/
+inline ResultEsc<char32_t> unescape_char_or_byte(std::string_view src, Mode mode) {
+    assert(mode == Mode::Char || mode == Mode::Byte);
+    const char* it = src.data();
+    const char* end = it + src.size();
+    if (it == end) {
+        return ResultEsc<char32_t>::Err(EscapeError::ZeroChars);
+    }
+
+    const char32_t c = escape_detail::next_char(it, end);
+    char32_t res;
+
+    switch (c) {
+        case '\\': {
+            ResultEsc<MixedUnit> esc_result = scan_escape(it, end, mode);
+            if (esc_result.is_err()) {
+                return ResultEsc<char32_t>::Err(esc_result.unwrap_err());
+            }
+            const MixedUnit unit = esc_result.unwrap();
+            res = unit.is_char() ? unit.as_char() : unit.as_high_byte();
+            break;
+        }
+
+        case '\n':
+        case '\t':
+        case '\'':
+            return ResultEsc<char32_t>::Err(EscapeError::EscapeOnlyChar);
+
+        case '\r':
+            return ResultEsc<char32_t>::Err(EscapeError::BareCarriageReturn);
+
+        default:
+            // Check ASCII validity for byte modes
+            if (!allow_unicode_chars(mode) && c >= 128) {
+                return ResultEsc<char32_t>::Err(EscapeError::NonAsciiCharInByte);
+            }
+            res = c;
+            break;
+    }
+
+    // Check for trailing characters
+    if (it != end) {
+        return ResultEsc<char32_t>::Err(EscapeError::MoreThanOneChar);
+    }
+
+    return ResultEsc<char32_t>::Ok(res);
+}
+
+
+/*
+Skips the whitespace after a `\` at the end of a line. `it` points at the
+newline; `start` is the offset of the `\`.
+*/
+template <typename Callback>
+void skip_ascii_whitespace(std::string_view src, const char*& it, size_t start, Callback&& callback) {
+    const char* const end = src.data() + src.size();
+    const char* first_non_space = it;
+    while (first_non_space != end &&
+           (*first_non_space == ' ' || *first_non_space == '\t' ||
+            *first_non_space == '\n' || *first_non_space == '\r')) {
+        ++first_non_space;
+    }
+    const size_t skipped = static_cast<size_t>(first_non_space - it);
+
+    // Check for multiple newlines
+    if (std::string_view(it + 1, skipped - 1).find('\n') != std::string_view::npos) {
+        // The +1 accounts for the escaping slash.
+        callback(EscapeRange{start, start + skipped + 1},
+                 ResultEsc<MixedUnit>::Err(EscapeError::MultipleSkippedLinesWarning));
+    }
+
+    // Check for remaining (non-ASCII) whitespace
+    it = first_non_space;
+    if (it != end) {
+        const char* after = it;
+        if (is_whitespace(escape_detail::next_char(after, end))) {
+            // The span includes the character that was not skipped.
+            callback(EscapeRange{start, start + skipped + static_cast<size_t>(after - it) + 1},
+                     ResultEsc<MixedUnit>::Err(EscapeError::UnskippedWhitespaceWarning));
+        }
+    }
+}
+
+
+/*
+Takes a contents of a string literal (without quotes) and produces a sequence of escaped characters or errors
+*/
+template <typename Callback>
+void unescape_non_raw_common(std::string_view src, Mode mode, Callback&& callback) {
+    const char* const begin = src.data();
+    const char* const end = begin + src.size();
+    const char* it = begin;
+    const bool allow_unicode = allow_unicode_chars(mode);
+
+    while (it != end) {
+        const size_t start = static_cast<size_t>(it - begin);
+        const char32_t c = escape_detail::next_char(it, end);
+
+        if (c == '\\') {
+            // Handle escaped newline and whitespace skipping
+            if (it != end && *it == '\n') {
+                skip_ascii_whitespace(src, it, start, callback);
+                continue;
+            }
+
+            // Process escape sequence
+            ResultEsc<MixedUnit> res = scan_escape(it, end, mode);
+            callback(EscapeRange{start, static_cast<size_t>(it - begin)}, res);
+            continue;
+        }
+
+        const EscapeRange range{start, static_cast<size_t>(it - begin)};
+        // Handle normal characters
+        if (c == '"') {
+            callback(range, ResultEsc<MixedUnit>::Err(EscapeError::EscapeOnlyChar));
+        } else if (c == '\r') {
+            callback(range, ResultEsc<MixedUnit>::Err(EscapeError::BareCarriageReturn));
+        } else if (!allow_unicode && c >= 128) {
+            callback(range, ResultEsc<MixedUnit>::Err(EscapeError::NonAsciiCharInByte));
+        } else {
+            callback(range, ResultEsc<MixedUnit>::Ok(MixedUnit::from_char(c)));
+        }
+    }
+}
+
+
+/*
+Takes a contents of a string literal (without quotes) and produces a sequence of characters or errors.
+NOTE: Raw strings do not perform any explicit character escaping, here we only produce errors on bare CR.
+*/
+template <typename Callback>
+void check_raw_common(std::string_view src, Mode mode, Callback&& callback) {
+    const char* const begin = src.data();
+    const char* const end = begin + src.size();
+    const char* it = begin;
+    const bool allow_unicode = allow_unicode_chars(mode);
+
+    while (it != end) {
+        const size_t start = static_cast<size_t>(it - begin);
+        const char32_t c = escape_detail::next_char(it, end);
+        const EscapeRange range{start, static_cast<size_t>(it - begin)};
+
+        if (c == '\r') {
+            callback(range, ResultEsc<MixedUnit>::Err(EscapeError::BareCarriageReturnInRawString));
+        } else if (!allow_unicode && c >= 128) {
+            callback(range, ResultEsc<MixedUnit>::Err(EscapeError::NonAsciiCharInByte));
+        } else {
+            callback(range, ResultEsc<MixedUnit>::Ok(MixedUnit::from_char(c)));
+        }
+    }
+}
+
+
+/*
+Takes the contents of a C string literal (without quotes) and produces a
+sequence of characters, high bytes or errors. NUL is not allowed anywhere.
+*/
+template <typename Callback>
+void unescape_mixed(std::string_view src, Mode mode, Callback&& callback) {
+    auto reject_nul = [&](EscapeRange range, const ResultEsc<MixedUnit>& result) {
+        if (result.is_ok() && result.unwrap() == MixedUnit::from_char('\0')) {
+            callback(range, ResultEsc<MixedUnit>::Err(EscapeError::NulInCStr));
+        } else {
+            callback(range, result);
+        }
+    };
+
+    switch (mode) {
+        case Mode::CStr:
+            unescape_non_raw_common(src, mode, reject_nul);
+            break;
+        case Mode::RawCStr:
+            check_raw_common(src, mode, reject_nul);
+            break;
+        default:
+            UNREACHABLE();
+    }
+}
+
+
+/*
+Takes the contents of a literal (without quotes) and calls `callback` with
+the byte range and value of every character, or the error found there.
+C strings go through `unescape_mixed`.
+*/
+template <typename Callback>
+void unescape_unicode(std::string_view src, Mode mode, Callback&& callback) {
+    switch (mode)
+    {
+        case Mode::Char:
+        case Mode::Byte: {
+            ResultEsc<char32_t> res = unescape_char_or_byte(src, mode);
+            const EscapeRange range{0, src.size()};
+            if (res.is_err()) {
+                callback(range, ResultEsc<MixedUnit>::Err(res.unwrap_err()));
+            } else if (mode == Mode::Byte && res.unwrap() > 127) {
+                callback(range, ResultEsc<MixedUnit>::Ok(MixedUnit::high_byte(static_cast<uint8_t>(res.unwrap()))));
+            } else {
+                callback(range, ResultEsc<MixedUnit>::Ok(MixedUnit::from_char(res.unwrap())));
+            }
+            break;
+        }
+
+        case Mode::Str:
+        case Mode::ByteStr:
+            unescape_non_raw_common(src, mode, callback);
+            break;
+
+        case Mode::RawStr:
+        case Mode::RawByteStr:
+            check_raw_common(src, mode, callback);
+            break;
+
+        case Mode::CStr:
+        case Mode::RawCStr:
+            UNREACHABLE();
+    }
+}
+
+
+/*
+The value of a string literal whose contents need no unescaping, i.e. `src`
+itself, or nullopt if it has to go through `unescape_into_arena`. Looks for
+`\` and `\r` with the SIMD scanners; byte strings are also checked for
+non-ASCII and C strings for NUL. `src` is expected to come from the lexer,
+so it can't hold an unescaped `"`.
+*/
+inline std::optional<std::string_view> unescaped_borrowed(std::string_view src, Mode mode) {
+    const char* const begin = src.data();
+    const char* const end = begin + src.size();
+
+    if (!in_double_quotes(mode)) {
+        return std::nullopt;
+    }
+    const bool clean = is_raw(mode)
+        ? simd::find_byte(begin, end, '\r') == end
+        : simd::find_either(begin, end, '\\', '\r') == end;
+    if (!clean) {
+        return std::nullopt;
+    }
+    if (!allow_unicode_chars(mode) && simd::find_non_ascii(begin, end) != end) {
+        return std::nullopt;
+    }
+    if ((mode == Mode::CStr || mode == Mode::RawCStr) && std::memchr(begin, '\0', src.size())) {
+        return std::nullopt;
+    }
+    return src;
+}
+
+
+/*
+Unescapes the contents of a string literal (without quotes) and returns its
+value. Literals that need no unescaping are returned as `src`, without a
+copy; everything else is written to `arena`. Unescaping never makes a
+literal longer, so the output is allocated once, up front. Warnings are
+ignored; the first error is returned.
+*/
+inline ResultEsc<std::string_view> unescape_into_arena(std::string_view src, Mode mode, DroplessArena& arena) {
+    using Res = ResultEsc<std::string_view>;
+    assert(in_double_quotes(mode));
+
+    if (std::optional<std::string_view> borrowed = unescaped_borrowed(src, mode)) {
+        return Res::Ok(*borrowed);
+    }
+
+    // Raw literals are never rewritten, they can only be invalid.
+    if (is_raw(mode)) {
+        std::optional<EscapeError> error;
+        auto first_error = [&](EscapeRange, const ResultEsc<MixedUnit>& result) {
+            if (!error && result.is_err()) {
+                error = result.unwrap_err();
+            }
+        };
+        if (mode == Mode::RawCStr) {
+            unescape_mixed(src, mode, first_error);
+        } else {
+            check_raw_common(src, mode, first_error);
+        }
+        return error ? Res::Err(*error) : Res::Ok(src);
+    }
+
+    const char* it = src.data();
+    const char* const end = it + src.size();
+    const bool byte_str = !allow_unicode_chars(mode);
+    const bool c_str = mode == Mode::CStr;
+    char* const out = static_cast<char*>(arena.allocate(src.size(), 1));
+    size_t len = 0;
+
+    while (it != end) {
+        // Copy everything up to the next escape or CR in one go.
+        const char* run_end = simd::find_either(it, end, '\\', '\r');
+        const size_t run = static_cast<size_t>(run_end - it);
+        if (byte_str && simd::find_non_ascii(it, run_end) != run_end) {
+            return Res::Err(EscapeError::NonAsciiCharInByte);
+        }
+        if (c_str && std::memchr(it, '\0', run)) {
+            return Res::Err(EscapeError::NulInCStr);
+        }
+        std::memcpy(out + len, it, run);
+        len += run;
+        it = run_end;
+        if (it == end) {
+            break;
+        }
+
+        if (*it == '\r') {
+            return Res::Err(EscapeError::BareCarriageReturn);
+        }
+
+        ++it;
+        if (it != end && *it == '\n') {
+            // Line continuation: drop the newline and the indentation after it.
+            while (it != end && (*it == ' ' || *it == '\t' || *it == '\n' || *it == '\r')) {
+                ++it;
+            }
+            continue;
+        }
+
+        ResultEsc<MixedUnit> unit = scan_escape(it, end, mode);
+        if (unit.is_err()) {
+            return Res::Err(unit.unwrap_err());
+        }
+        if (c_str && unit.unwrap() == MixedUnit::from_char('\0')) {
+            return Res::Err(EscapeError::NulInCStr);
+        }
+        len += unit.unwrap().encode(out + len);
+    }
+
+    return Res::Ok(std::string_view(out, len));
+}
+
+} // namespace lexer
+} // namespace amyr
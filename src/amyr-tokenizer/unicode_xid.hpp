@@ -0,0 +1,49 @@
+/*
+XID_Start / XID_Continue lookup for identifiers.
+
+ASCII is answered from the lexer's character-class table. Everything else goes through
+a two-level trie generated at build time by tools/gen_xid_tables.cpp: the
+root maps a 512 code point block to a leaf, and the leaf is a 512-bit set.
+Two loads and a shift, no ICU at run time.
+*/
+#pragma once
+
+#include<cstdint>
+
+#include "amyr-tokenizer/char_class.hpp"
+#include "amyr-tokenizer/xid_tables.hpp"
+
+namespace amyr {
+namespace unicode {
+
+namespace xid_detail {
+
+    template <typename Root>
+    inline bool lookup(const Root& root, char32_t c) {
+        if (c > 0x10FFFF) {
+            return false;
+        }
+        const uint64_t* leaf = xid_tables::LEAVES[root[c >> xid_tables::LEAF_BITS]];
+        const uint32_t bit = c & ((1u << xid_tables::LEAF_BITS) - 1);
+        return (leaf[bit >> 6] >> (bit & 63)) & 1;
+    }
+
+} // namespace xid_detail
+
+inline bool is_xid_start(char32_t c) {
+    if (c < 0x80) {
+        // `_` may start an identifier but is not XID_Start.
+        return c != '_' && amyr::lexer::is_ascii_id_start(c);
+    }
+    return xid_detail::lookup(xid_tables::START_ROOT, c);
+}
+
+inline bool is_xid_continue(char32_t c) {
+    if (c < 0x80) {
+        return amyr::lexer::is_ascii_id_continue(c);
+    }
+    return xid_detail::lookup(xid_tables::CONTINUE_ROOT, c);
+}
+
+} // namespace unicode
+} // namespace amyr
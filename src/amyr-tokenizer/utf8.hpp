@@ -0,0 +1,126 @@
+/*
+UTF-8 decoding and validation.
+
+Source text is validated once, when the SourceFile is loaded, so the lexers
+can decode without checking every byte again. Validation skips ASCII runs
+with the SIMD scanners and only walks multi-byte sequences one at a time.
+*/
+#pragma once
+
+#include<cstddef>
+#include<optional>
+#include<string_view>
+
+#include "simd_scan.hpp"
+
+namespace amyr {
+namespace unicode {
+
+inline constexpr char32_t REPLACEMENT_CHAR = 0xFFFD;
+
+// Length of the sequence `lead` starts. Stray continuation bytes count as 1.
+constexpr size_t sequence_length(unsigned char lead) {
+    if (lead < 0xC0) return 1;
+    if (lead < 0xE0) return 2;
+    if (lead < 0xF0) return 3;
+    return 4;
+}
+
+/*
+Decodes the code point starting at `p` and stores its length in bytes in `len`.
+Expects validated text, but never reads past `end`: a truncated sequence or a
+stray continuation byte decodes to U+FFFD.
+*/
+inline char32_t decode(const char* p, const char* end, size_t& len) {
+    const unsigned char lead = static_cast<unsigned char>(*p);
+    if (lead < 0x80) {
+        len = 1;
+        return lead;
+    }
+    len = sequence_length(lead);
+    if (lead < 0xC0 || static_cast<size_t>(end - p) < len) {
+        len = 1;
+        return REPLACEMENT_CHAR;
+    }
+    char32_t c = lead & (0x7F >> len);
+    for (size_t i = 1; i < len; ++i) {
+        c = (c << 6) | (static_cast<unsigned char>(p[i]) & 0x3F);
+    }
+    return c;
+}
+
+/*
+Writes `c` to `out` as UTF-8 and returns the number of bytes written (1-4).
+`c` must be a scalar value.
+*/
+inline size_t encode(char32_t c, char* out) {
+    if (c < 0x80) {
+        out[0] = static_cast<char>(c);
+        return 1;
+    }
+    if (c < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (c >> 6));
+        out[1] = static_cast<char>(0x80 | (c & 0x3F));
+        return 2;
+    }
+    if (c < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (c >> 12));
+        out[1] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (c & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (c >> 18));
+    out[1] = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (c & 0x3F));
+    return 4;
+}
+
+/*
+Offset of the first byte of `text` that isn't part of well-formed UTF-8, or
+nullopt if all of it is. Overlong forms, surrogates and code points past
+U+10FFFF are rejected.
+*/
+inline std::optional<size_t> find_invalid_utf8(std::string_view text) {
+    const char* const begin = text.data();
+    const char* const end = begin + text.size();
+    const char* p = begin;
+    while (true) {
+        p = simd::find_non_ascii(p, end);
+        if (p == end) {
+            return std::nullopt;
+        }
+
+        const unsigned char lead = static_cast<unsigned char>(*p);
+        size_t len;
+        char32_t min;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            len = 2, min = 0x80;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            len = 3, min = 0x800;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            len = 4, min = 0x10000;
+        } else {
+            return static_cast<size_t>(p - begin);
+        }
+        if (static_cast<size_t>(end - p) < len) {
+            return static_cast<size_t>(p - begin);
+        }
+
+        char32_t c = lead & (0x7F >> len);
+        for (size_t i = 1; i < len; ++i) {
+            const unsigned char byte = static_cast<unsigned char>(p[i]);
+            if ((byte & 0xC0) != 0x80) {
+                return static_cast<size_t>(p - begin);
+            }
+            c = (c << 6) | (byte & 0x3F);
+        }
+        if (c < min || (c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF) {
+            return static_cast<size_t>(p - begin);
+        }
+        p += len;
+    }
+}
+
+} // namespace unicode
+} // namespace amyr
@@ -69,24 +69,14 @@ public:
         return FilterIterator(static_cast<Derived*>(this), pred);
     }
 
+    // Returns true if `pred` holds for every remaining element. Consumes the iterator.
     template<typename Pred>
     bool all(Pred pred) {
-        struct AllIterator: Iterator<AllIterator, U> {
-            Derived* base;
-            Pred pred;
-
-            AllIterator(Derived* base, Pred pred)
-                : base(base), pred(pred)
-
-            //Lazily apply a predicate to all members
-            bool next() {
-                while (auto val = base->next()) {
-                    if(!pred(*val)) {
-                        return false;
-                    }
-                }
-                return true;
+        while (auto val = static_cast<Derived*>(this)->next()) {
+            if (!pred(*val)) {
+                return false;
             }
         }
+        return true;
     }
 };
\ No newline at end of file
@@ -51,7 +51,7 @@ public:
 
     //Access the value with safety checks
     inline T unwrap() const {
-        if(!is_ok) {
+        if(!is_ok()) {
             throw std::runtime_error("Called unwrap on an Err value");
         }
 
@@ -0,0 +1,86 @@
+/*
+Fixed-size worker pool.
+
+Jobs are plain callables; `submit` hands back a std::future for the result.
+The pool joins its workers on destruction after draining the queue.
+*/
+#pragma once
+
+#include<algorithm>
+#include<condition_variable>
+#include<cstddef>
+#include<functional>
+#include<future>
+#include<memory>
+#include<mutex>
+#include<queue>
+#include<thread>
+#include<type_traits>
+#include<vector>
+
+class ThreadPool {
+public:
+    // `threads == 0` means one worker per hardware thread.
+    explicit ThreadPool(size_t threads = 0) {
+        if (threads == 0) {
+            threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        workers_.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { work(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            stopping_ = true;
+        }
+        ready_.notify_all();
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers_.size(); }
+
+    template <typename Func>
+    auto submit(Func&& func) -> std::future<std::invoke_result_t<Func>> {
+        using R = std::invoke_result_t<Func>;
+        // std::function needs a copyable target, so the move-only task lives behind a shared_ptr.
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<Func>(func));
+        std::future<R> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            jobs_.emplace([task] { (*task)(); });
+        }
+        ready_.notify_one();
+        return result;
+    }
+
+private:
+    void work() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> guard(lock_);
+                ready_.wait(guard, [this] { return stopping_ || !jobs_.empty(); });
+                if (jobs_.empty()) {
+                    return;
+                }
+                job = std::move(jobs_.front());
+                jobs_.pop();
+            }
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> jobs_;
+    std::mutex lock_;
+    std::condition_variable ready_;
+    bool stopping_ = false;
+};
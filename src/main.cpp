@@ -0,0 +1,2 @@
+// Driver for the amayori-llvm executable; main() lives in amayori-llvm.hpp.
+#include "amayori-llvm.hpp"
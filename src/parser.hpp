@@ -1,248 +1,557 @@
-#pragma once
-
-#include "./AmayoriAST.hpp"
-#include "./amyr-tokenizer/tokenizer.hpp"
-#include "./amyr-borrow-check/BorrowChecker.hpp"
-#include "./amyr-parser/arena.hpp"
-#include "./amyr-utils/result.hpp"
-
-#include <string_view>
-#include <vector>
-#include <stdexcept>
-#include <unordered_set>
-#include <memory> // For shared_ptr
-
-namespace node {
-
-class ExprAST {
-public:
-    virtual ~ExprAST() = default;
-};
-
-class IntExprAST : public ExprAST {
-    int value;
-public:
-    explicit IntExprAST(int val) : value(val) {}
-    int getValue() const { return value; }
-};
-
-class BinaryExprAST : public ExprAST {
-    ExprAST* LHS;
-    ExprAST* RHS;
-    char op;
-public:
-    BinaryExprAST(ExprAST* lhs, ExprAST* rhs, char op) 
-        : LHS(lhs), RHS(rhs), op(op) {}
-    ExprAST* getLHS() const { return LHS; }
-    ExprAST* getRHS() const { return RHS; }
-    char getOp() const { return op; }
-};
-
-class VariableExprAST : public ExprAST {
-    std::string_view name;
-    amyr::borrow::BorrowKind borrow_type;
-public:
-    explicit VariableExprAST(std::string_view n) : name(n) {}
-    const std::string_view& getName() const { return name; }
-    void setBorrowType(amyr::borrow::BorrowKind type) { borrow_type = type; }
-};
-
-class LetExprAST : public ExprAST {
-    std::string_view name;
-    bool is_mutable;
-    ExprAST* init;
-public:
-    LetExprAST(std::string_view n, bool is_mut, ExprAST* init)
-        : name(n), is_mutable(is_mut), init(init) {}
-    const std::string_view& getName() const { return name; }
-    bool isMutable() const { return is_mutable; }
-    const ExprAST* getInitExpr() const { return init; }
-};
-
-class BlockExprAST : public ExprAST {
-    std::vector<std::shared_ptr<ExprAST>> expressions;
-public:
-    explicit BlockExprAST(std::vector<std::shared_ptr<ExprAST>> exprs)
-        : expressions(std::move(exprs)) {}
-};
-
-class Parser {
-private:
-    std::vector<Token> tokens;
-    size_t current = 0;
-    amyr::borrow::BorrowChecker borrow_checker;
-    std::unordered_set<std::string_view> declared_variables;
-    int scope_depth = 0;
-
-    TypedArena<ExprAST> arena; // Arena allocator for AST nodes
-
-    Token peek() const {
-        return tokens[current];
-    }
-
-    Token previous() const {
-        return tokens[current - 1];
-    }
-
-    bool isAtEnd() const {
-        return peek().type == TokenType::EOF_TOKEN;
-    }
-
-    Token advance() {
-        if (!isAtEnd()) current++;
-        return previous();
-    }
-
-    bool check_type(TokenType type) const {
-        if (isAtEnd()) return false;
-        return peek().type == type;
-    }
-
-    bool match(TokenType type) {
-        if (check_type(type)) {
-            advance();
-            return true;
-        }
-        return false;
-    }
-
-    void enter_scope() {
-        scope_depth++;
-    }
-
-    void exit_scope() {
-        scope_depth--;
-    }
-
-    std::shared_ptr<ExprAST> parse_primary() {
-        if (match(TokenType::Integer)) {
-            int value = std::stoi(previous().lexeme);
-            return std::make_shared<IntExprAST>(value);
-        }
-
-        if (match(TokenType::Identifier)) {
-            std::string_view var_name = previous().lexeme;
-            if (declared_variables.find(var_name) == declared_variables.end()) {
-                throw std::runtime_error("Use of undeclared variable: " + std::string(var_name));
-            }
-            auto expr = std::make_shared<VariableExprAST>(var_name);
-            expr->setBorrowType(amyr::borrow::BorrowKind::Shared); // Default to shared borrow
-            return expr;
-        }
-
-        if (match(TokenType::LeftParen)) {
-            auto expr = parse_expression();
-            if (!match(TokenType::RightParen)) {
-                throw std::runtime_error("Expect ')' after expression.");
-            }
-            return expr;
-        }
-
-        if (match(TokenType::Let)) {
-            // Handle variable declaration
-            if (!match(TokenType::Identifier)) {
-                throw std::runtime_error("Expect identifier after 'let'.");
-            }
-            std::string_view var_name = previous().lexeme;
-
-            bool is_mutable = false;
-            if (match(TokenType::Mut)) {
-                is_mutable = true;
-            }
-
-            if (!match(TokenType::Equals)) {
-                throw std::runtime_error("Expect '=' after variable name.");
-            }
-
-            auto init_expr = parse_expression();
-            declared_variables.insert(var_name);
-            return std::make_shared<LetExprAST>(var_name, is_mutable, init_expr.get());
-        }
-
-        throw std::runtime_error("Expect expression.");
-    }
-
-    std::shared_ptr<ExprAST> parse_term() {
-        auto expr = parse_primary();
-
-        while (match(TokenType::Star) || match(TokenType::Slash)) {
-            char op = previous().lexeme[0];
-            auto right = parse_primary();
-            expr = std::make_shared<BinaryExprAST>(op, expr.get(), right.get());
-        }
-
-        return expr;
-    }
-
-    std::shared_ptr<ExprAST> parse_expression() {
-        auto expr = parse_term();
-
-        while (match(TokenType::Plus) || match(TokenType::Minus)) {
-            char op = previous().lexeme[0];
-            auto right = parse_term();
-            expr = std::make_shared<BinaryExprAST>(op, expr.get(), right.get());
-        }
-
-        return expr;
-    }
-
-    void check_borrow_violations(const ExprAST* ast) {
-        if (!borrow_checker.check(ast)) {
-            const auto& errors = borrow_checker.get_errors();
-            if (!errors.empty()) {
-                throw std::runtime_error(errors[0].message); // Throw first error
-            }
-        }
-    }
-
-public:
-    explicit Parser(std::vector<Token> tokens) : tokens(std::move(tokens)) {}
-
-    std::shared_ptr<ExprAST> parse() {
-        try {
-            auto ast = parse_expression();
-            check_borrow_violations(ast.get());
-            return ast;
-        } catch (const std::runtime_error& e) {
-            throw std::runtime_error("Line " + std::to_string(peek().line) + ": " + e.what());
-        }
-    }
-
-    std::shared_ptr<ExprAST> parse_block() {
-        enter_scope();
-        std::vector<std::shared_ptr<ExprAST>> expressions;
-
-        while (!isAtEnd() && !check_type(TokenType::RightBrace)) {
-            auto expr = parse();
-            expressions.push_back(expr);
-            match(TokenType::Semicolon); // Optional semicolon
-        }
-
-        if (!match(TokenType::RightBrace)) {
-            throw std::runtime_error("Expect '}' after block.");
-        }
-
-        exit_scope();
-        return std::make_shared<BlockExprAST>(std::move(expressions));
-    }
-};
-
-} // namespace node
-
-// Add TokenType enum if not already defined
-enum class TokenType {
-    Let,
-    Mut,
-    Identifier,
-    Integer,
-    Equals,
-    RightBrace,
-    Plus,
-    Minus,
-    Star,
-    Slash,
-    LeftParen,
-    RightParen,
-    Semicolon,
-    EOF_TOKEN
-};
\ No newline at end of file
+#pragma once
+
+#include "./AmayoriAST.hpp"
+#include "./amyr-tokenizer/tokenizer.hpp"
+#include "./amyr-tokenizer/token_source.hpp"
+#include "./amyr-borrow-check/BorrowChecker.hpp"
+#include "./amyr-parser/arena.hpp"
+#include "./amyr-utils/result.hpp"
+#include "./amyr-utils/thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include <stdexcept>
+#include <unordered_set>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace node {
+
+enum class Assoc : uint8_t {
+    Left,
+    Right,
+    // Chaining is an error, e.g. `a < b < c`.
+    None
+};
+
+// How a binary operator token binds. `prec` is 0 for tokens that aren't binary operators.
+struct BinOpInfo {
+    BinOp op = BinOp::Add;
+    uint8_t prec = 0;
+    Assoc assoc = Assoc::Left;
+};
+
+/*
+Binary operators by token, with Rust's precedence levels from loosest to
+tightest: `||`, `&&`, comparisons, `|`, `^`, `&`, shifts, `+ -`, `* / %`.
+*/
+constexpr std::array<BinOpInfo, 256> make_binop_table() {
+    std::array<BinOpInfo, 256> table{};
+    auto set = [&table](TokenType type, BinOp op, uint8_t prec, Assoc assoc = Assoc::Left) {
+        table[static_cast<uint8_t>(type)] = BinOpInfo{op, prec, assoc};
+    };
+    set(TokenType::OrOr, BinOp::Or, 1);
+    set(TokenType::AndAnd, BinOp::And, 2);
+    set(TokenType::EqEq, BinOp::Eq, 3, Assoc::None);
+    set(TokenType::Ne, BinOp::Ne, 3, Assoc::None);
+    set(TokenType::Lt, BinOp::Lt, 3, Assoc::None);
+    set(TokenType::Le, BinOp::Le, 3, Assoc::None);
+    set(TokenType::Gt, BinOp::Gt, 3, Assoc::None);
+    set(TokenType::Ge, BinOp::Ge, 3, Assoc::None);
+    set(TokenType::Or, BinOp::BitOr, 4);
+    set(TokenType::Caret, BinOp::BitXor, 5);
+    set(TokenType::And, BinOp::BitAnd, 6);
+    set(TokenType::Shl, BinOp::Shl, 7);
+    set(TokenType::Shr, BinOp::Shr, 7);
+    set(TokenType::Plus, BinOp::Add, 8);
+    set(TokenType::Minus, BinOp::Sub, 8);
+    set(TokenType::Star, BinOp::Mul, 9);
+    set(TokenType::Slash, BinOp::Div, 9);
+    set(TokenType::Percent, BinOp::Rem, 9);
+    return table;
+}
+
+inline constexpr std::array<BinOpInfo, 256> BINOP_TABLE = make_binop_table();
+
+constexpr BinOpInfo binop_info(TokenType type) {
+    return BINOP_TABLE[static_cast<uint8_t>(type)];
+}
+
+// Whether `func` bodies are parsed with the rest of the program or only when first asked for.
+enum class FunctionBodies : uint8_t {
+    Eager,
+    Lazy
+};
+
+/*
+A function body skipped by a lazy parse: its brace-delimited byte range and
+the parameters in scope inside it. parse() runs a Parser over a fresh token
+source for just that range, so the body comes out exactly as an eager parse
+would have built it, in the arena of the tree it belongs to. The source
+text must outlive the tree.
+*/
+class DeferredBody : public LazyBody {
+public:
+    DeferredBody(AstArena* arena, std::unique_ptr<TokenSource> source, uint32_t start, uint32_t end,
+                 std::vector<amyr::span::Symbol> params)
+        : arena(arena), source(std::move(source)), start(start), end(end), params(std::move(params)) {}
+
+    ExprAST* parse() override;
+
+    // Parses into `into` rather than the tree's arena. Different bodies can be parsed at once this way.
+    ExprAST* parse_into(AstArena& into) const;
+
+private:
+    // A parallel parse fills in `source` once the skim is done.
+    friend class Parser;
+
+    AstArena* arena;
+    std::unique_ptr<TokenSource> source;
+    uint32_t start;
+    uint32_t end;
+    std::vector<amyr::span::Symbol> params;
+};
+
+class Parser {
+private:
+    friend class DeferredBody;
+
+    // Pulled on demand; only a few tokens around the current one are held.
+    TokenBuffer tokens;
+    FunctionBodies bodies = FunctionBodies::Eager;
+    // Set during the skim of a parallel parse: skipped bodies are listed here and their tokens kept.
+    std::vector<std::pair<FunctionAST*, DeferredBody*>>* skimmed = nullptr;
+    TokenStream* skimmed_tokens = nullptr;
+    amyr::borrow::BorrowChecker borrow_checker;
+    std::unordered_set<amyr::span::Symbol> declared_variables;
+    int scope_depth = 0;
+
+    // Unfinished expressions around the current operand; see parse_expression.
+    struct Pending {
+        enum Kind : uint8_t { Operator, Paren, Let } kind;
+        uint8_t min_prec;
+        bool is_mutable = false;
+        BinOpInfo info{};
+        ExprAST* lhs = nullptr;
+        amyr::span::Symbol name{0};
+    };
+    std::vector<Pending> pending;
+
+    // Nodes of the tree being built. Handed to the caller with the root, then replaced.
+    std::unique_ptr<AstArena> owned_arena = std::make_unique<AstArena>();
+    // Where new nodes go: owned_arena, or the tree of a deferred body.
+    AstArena* arena = owned_arena.get();
+
+    // Tokens are 16-byte spans, so returning them by value is free.
+    Token peek() const {
+        return tokens.peek().token;
+    }
+
+    Token previous() const {
+        return tokens.previous().token;
+    }
+
+    std::string_view lexeme(const Token& token) const {
+        return token.lexeme(tokens.text());
+    }
+
+    bool isAtEnd() const {
+        return peek().type == TokenType::EOF_TOKEN;
+    }
+
+    Token advance() {
+        if (!isAtEnd()) tokens.bump();
+        return previous();
+    }
+
+    bool check_type(TokenType type) const {
+        if (isAtEnd()) return false;
+        return peek().type == type;
+    }
+
+    bool match(TokenType type) {
+        if (check_type(type)) {
+            advance();
+            return true;
+        }
+        return false;
+    }
+
+    void enter_scope() {
+        scope_depth++;
+    }
+
+    void exit_scope() {
+        scope_depth--;
+    }
+
+    // An integer or a variable. Parentheses and `let` wrap a whole expression, so parse_expression handles them.
+    ExprAST* parse_primary() {
+        if (match(TokenType::Integer)) {
+            std::optional<int> value = tokens.previous().literal.as_int();
+            if (!value) {
+                throw std::runtime_error("Integer literal out of range: " + std::string(lexeme(previous())));
+            }
+            return arena->make<IntExprAST>(*value);
+        }
+
+        if (match(TokenType::Identifier)) {
+            amyr::span::Symbol var_name(previous().index);
+            if (declared_variables.find(var_name) == declared_variables.end()) {
+                throw std::runtime_error("Use of undeclared variable: " + std::string(var_name.as_str()));
+            }
+            // VariableExprAST defaults to a shared borrow
+            return arena->make<VariableExprAST>(var_name);
+        }
+
+        if (check_type(TokenType::Unknown)) {
+            // The lexer has already recorded why; the parser can only stop here.
+            throw std::runtime_error("Invalid token '" + std::string(lexeme(peek())) + "'.");
+        }
+
+        throw std::runtime_error("Expect expression.");
+    }
+
+    /*
+    Precedence climbing over BINOP_TABLE, with the recursion replaced by
+    `pending`: each entry is an operator still waiting for its right operand,
+    an open '(' or a `let` waiting for its initializer, together with the
+    `min_prec` to go back to once it's complete. Nesting depth costs heap,
+    not native stack, so 100k-deep chains and parentheses parse like any
+    other input.
+    */
+    ExprAST* parse_expression() {
+        pending.clear();
+        uint8_t min_prec = 1;
+
+        for (;;) {
+            // Open every '(' and `let` in front of the next operand.
+            ExprAST* expr;
+            for (;;) {
+                if (match(TokenType::LeftParen)) {
+                    pending.push_back(Pending{Pending::Paren, min_prec});
+                } else if (match(TokenType::Let)) {
+                    if (!match(TokenType::Identifier)) {
+                        throw std::runtime_error("Expect identifier after 'let'.");
+                    }
+                    Pending let{Pending::Let, min_prec};
+                    let.name = amyr::span::Symbol(previous().index);
+                    let.is_mutable = match(TokenType::Mut);
+                    if (!match(TokenType::Equals)) {
+                        throw std::runtime_error("Expect '=' after variable name.");
+                    }
+                    pending.push_back(let);
+                } else {
+                    expr = parse_primary();
+                    break;
+                }
+                min_prec = 1;
+            }
+
+            // Fold `expr` into what's pending until an operator needs a right operand.
+            for (;;) {
+                const BinOpInfo info = binop_info(peek().type);
+                if (info.prec != 0 && info.prec >= min_prec) {
+                    advance();
+                    Pending op{Pending::Operator, min_prec};
+                    op.info = info;
+                    op.lhs = expr;
+                    pending.push_back(op);
+                    min_prec = info.assoc == Assoc::Right ? info.prec : info.prec + 1;
+                    break;
+                }
+
+                if (pending.empty()) {
+                    return expr;
+                }
+                const Pending top = pending.back();
+                pending.pop_back();
+                min_prec = top.min_prec;
+
+                switch (top.kind) {
+                    case Pending::Operator:
+                        if (top.info.assoc == Assoc::None && binop_info(peek().type).prec == top.info.prec) {
+                            throw std::runtime_error("Comparison operators cannot be chained.");
+                        }
+                        expr = arena->make<BinaryExprAST>(top.info.op, top.lhs, expr);
+                        break;
+                    case Pending::Paren:
+                        if (!match(TokenType::RightParen)) {
+                            throw std::runtime_error("Expect ')' after expression.");
+                        }
+                        break;
+                    case Pending::Let:
+                        declared_variables.insert(top.name);
+                        expr = arena->make<LetExprAST>(top.name, top.is_mutable, expr);
+                        break;
+                }
+            }
+        }
+    }
+
+    void check_borrow_violations(const ExprAST* ast) {
+        if (!borrow_checker.check(ast)) {
+            const auto& errors = borrow_checker.get_errors();
+            if (!errors.empty()) {
+                throw std::runtime_error(errors[0].message); // Throw first error
+            }
+        }
+    }
+
+    ExprAST* parse_checked_expression() {
+        ExprAST* ast = parse_expression();
+        check_borrow_violations(ast);
+        return ast;
+    }
+
+    ExprAST* parse_statement() {
+        try {
+            return match(TokenType::Func) ? parse_function() : parse_checked_expression();
+        } catch (const std::runtime_error& e) {
+            throw std::runtime_error("Line " + std::to_string(tokens.line()) + ": " + e.what());
+        }
+    }
+
+    // `func name(a, b) { ... }`, after the `func`.
+    ExprAST* parse_function() {
+        if (!match(TokenType::Identifier)) {
+            throw std::runtime_error("Expect function name after 'func'.");
+        }
+        amyr::span::Symbol name(previous().index);
+        if (!match(TokenType::LeftParen)) {
+            throw std::runtime_error("Expect '(' after function name.");
+        }
+
+        std::vector<std::string> args;
+        std::vector<amyr::span::Symbol> params;
+        if (!check_type(TokenType::RightParen)) {
+            do {
+                if (!match(TokenType::Identifier)) {
+                    throw std::runtime_error("Expect parameter name.");
+                }
+                args.emplace_back(lexeme(previous()));
+                params.emplace_back(previous().index);
+            } while (match(TokenType::Comma));
+        }
+        if (!match(TokenType::RightParen)) {
+            throw std::runtime_error("Expect ')' after parameters.");
+        }
+        if (!check_type(TokenType::LeftBrace)) {
+            throw std::runtime_error("Expect '{' before function body.");
+        }
+
+        auto* proto = arena->make<FuncPrototypeAST>(name, std::move(args));
+        if (bodies == FunctionBodies::Eager) {
+            return arena->make<FunctionAST>(proto, parse_function_body(params));
+        }
+        const uint32_t start = peek().start;
+        skip_braces(skimmed_tokens);
+        const uint32_t end = previous().start + previous().len;
+        // The skim of a parallel parse sets up a source over the kept tokens afterwards.
+        std::unique_ptr<TokenSource> source = skimmed ? nullptr : tokens.range(start, end);
+        auto* body = static_cast<DeferredBody*>(
+            arena->keep(std::make_unique<DeferredBody>(arena, std::move(source), start, end, std::move(params))));
+        auto* function = arena->make<FunctionAST>(proto, body);
+        if (skimmed) {
+            skimmed->emplace_back(function, body);
+        }
+        return function;
+    }
+
+    /*
+    `{ statements }`. A body sees its parameters and its own `let`s and
+    nothing from around it, so parsing it later on its own gives the same
+    tree.
+    */
+    ExprAST* parse_function_body(const std::vector<amyr::span::Symbol>& params) {
+        match(TokenType::LeftBrace);
+        std::unordered_set<amyr::span::Symbol> outer(params.begin(), params.end());
+        std::swap(outer, declared_variables);
+        enter_scope();
+
+        std::vector<ExprAST*> expressions;
+        while (!isAtEnd() && !check_type(TokenType::RightBrace)) {
+            expressions.push_back(parse_checked_expression());
+            match(TokenType::Semicolon);
+        }
+        if (!match(TokenType::RightBrace)) {
+            throw std::runtime_error("Expect '}' after function body.");
+        }
+
+        exit_scope();
+        std::swap(outer, declared_variables);
+        return arena->make<BlockExprAST>(arena->make_list(expressions));
+    }
+
+    // Moves past a balanced `{ ... }` by counting braces, without building anything. Tokens go to `keep` if given.
+    void skip_braces(TokenStream* keep) {
+        size_t depth = 0;
+        do {
+            const BufferedToken& token = tokens.peek();
+            switch (token.token.type) {
+                case TokenType::LeftBrace: depth++; break;
+                case TokenType::RightBrace: depth--; break;
+                case TokenType::EOF_TOKEN: throw std::runtime_error("Expect '}' after function body.");
+                default: break;
+            }
+            if (keep) {
+                const bool numeric = token.token.type == TokenType::Integer || token.token.type == TokenType::Float;
+                keep->push(token.token.type, token.token.start, token.token.len,
+                           numeric ? keep->add_literal(token.literal) : token.token.index);
+            }
+            advance();
+        } while (depth > 0);
+    }
+
+    // For a deferred body: builds into the arena of the tree the body belongs to.
+    Parser(std::unique_ptr<TokenSource> source, AstArena& into)
+        : tokens(std::move(source)), owned_arena(nullptr), arena(&into) {}
+
+    // Hands the finished tree over together with its nodes.
+    ParsedAst finish(ExprAST* root) {
+        ParsedAst ast(std::move(owned_arena), root);
+        owned_arena = std::make_unique<AstArena>();
+        arena = owned_arena.get();
+        return ast;
+    }
+
+public:
+    explicit Parser(std::unique_ptr<TokenSource> source, FunctionBodies bodies = FunctionBodies::Eager)
+        : tokens(std::move(source)), bodies(bodies) {}
+
+    explicit Parser(TokenStream tokens, FunctionBodies bodies = FunctionBodies::Eager)
+        : Parser(std::make_unique<StoredTokenSource>(std::move(tokens)), bodies) {}
+
+    ParsedAst parse() {
+        return finish(parse_statement());
+    }
+
+    // Parses statements up to EOF, each optionally followed by ';'.
+    ParsedAst parse_program() {
+        std::vector<ExprAST*> expressions;
+
+        while (!isAtEnd()) {
+            expressions.push_back(parse_statement());
+            match(TokenType::Semicolon);
+        }
+
+        return finish(arena->make<BlockExprAST>(arena->make_list(expressions)));
+    }
+
+    /*
+    Same result as parse_program(), with `func` bodies parsed on `pool`.
+
+    A skim on this thread parses everything but the bodies, finding each
+    body by brace matching and keeping its tokens. The bodies are then cut
+    into contiguous batches, each parsed by one job into an arena of its
+    own, and merged back in source order; the tree keeps the batch arenas.
+    Whatever the timing, the tree is the same, and so is the error: the
+    first one in source order, as parse_program() would have thrown it.
+    */
+    ParsedAst parse_program(ThreadPool& pool) {
+        std::vector<std::pair<FunctionAST*, DeferredBody*>> functions;
+        TokenStream body_tokens(tokens.text());
+        const FunctionBodies mode = bodies;
+        bodies = FunctionBodies::Lazy;
+        skimmed = &functions;
+        skimmed_tokens = &body_tokens;
+
+        std::vector<ExprAST*> expressions;
+        std::exception_ptr skim_error;
+        try {
+            while (!isAtEnd()) {
+                expressions.push_back(parse_statement());
+                match(TokenType::Semicolon);
+            }
+        } catch (const std::runtime_error&) {
+            // Only reported if every body before it parses.
+            skim_error = std::current_exception();
+        }
+        bodies = mode;
+        skimmed = nullptr;
+        skimmed_tokens = nullptr;
+
+        // Workers replay the kept tokens instead of lexing the bodies again.
+        body_tokens.push(TokenType::EOF_TOKEN, static_cast<uint32_t>(tokens.text().size()), 0);
+        const StoredTokenSource all_bodies(std::move(body_tokens));
+        for (auto& function : functions) {
+            DeferredBody* body = function.second;
+            body->source = all_bodies.range(body->start, body->end);
+        }
+
+        struct Batch {
+            std::unique_ptr<AstArena> arena;
+            std::vector<ExprAST*> bodies;
+        };
+        const size_t n_batches = std::min(functions.size(), pool.size() * 4);
+        std::vector<std::future<Batch>> batches;
+        batches.reserve(n_batches);
+        for (size_t i = 0; i < n_batches; ++i) {
+            const size_t first = functions.size() * i / n_batches;
+            const size_t last = functions.size() * (i + 1) / n_batches;
+            batches.push_back(pool.submit([&functions, first, last] {
+                Batch batch{std::make_unique<AstArena>(), {}};
+                batch.bodies.reserve(last - first);
+                for (size_t f = first; f < last; ++f) {
+                    batch.bodies.push_back(functions[f].second->parse_into(*batch.arena));
+                }
+                return batch;
+            }));
+        }
+
+        // Every job has to finish before anything is thrown: they read nodes of this tree.
+        std::exception_ptr body_error;
+        for (size_t i = 0; i < n_batches; ++i) {
+            try {
+                Batch batch = batches[i].get();
+                const size_t first = functions.size() * i / n_batches;
+                for (size_t f = 0; f < batch.bodies.size(); ++f) {
+                    functions[first + f].first->setBody(batch.bodies[f]);
+                }
+                arena->adopt(std::move(batch.arena));
+            } catch (const std::runtime_error&) {
+                if (!body_error) {
+                    body_error = std::current_exception();
+                }
+            }
+        }
+        if (body_error) {
+            std::rethrow_exception(body_error);
+        }
+        if (skim_error) {
+            std::rethrow_exception(skim_error);
+        }
+
+        return finish(arena->make<BlockExprAST>(arena->make_list(expressions)));
+    }
+
+    ParsedAst parse_block() {
+        enter_scope();
+        std::vector<ExprAST*> expressions;
+
+        while (!isAtEnd() && !check_type(TokenType::RightBrace)) {
+            expressions.push_back(parse_statement());
+            match(TokenType::Semicolon); // Optional semicolon
+        }
+
+        if (!match(TokenType::RightBrace)) {
+            throw std::runtime_error("Expect '}' after block.");
+        }
+
+        exit_scope();
+        return finish(arena->make<BlockExprAST>(arena->make_list(expressions)));
+    }
+};
+
+inline ExprAST* DeferredBody::parse() {
+    return parse_into(*arena);
+}
+
+inline ExprAST* DeferredBody::parse_into(AstArena& into) const {
+    // The range source is left untouched, so a body that failed to parse fails the same way again.
+    Parser parser(source->range(start, end), into);
+    try {
+        return parser.parse_function_body(params);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error("Line " + std::to_string(parser.tokens.line()) + ": " + e.what());
+    }
+}
+
+} // namespace node
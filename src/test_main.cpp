@@ -1,12 +1,24 @@
 
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "amyr-ast/ast.hpp"
+#include "amyr-span/source_map.hpp"
 #include "amyr-tokenizer/tokenizer.hpp"
+#include "amyr-tokenizer/parallel_lexer.hpp"
+#include "amyr-tokenizer/relex.hpp"
+#include "amyr-tokenizer/token_source.hpp"
+#include "amyr-tokenizer/unicode_escape.hpp"
 #include "amyr-borrow-check/BorrowChecker.hpp"
+#include "parser.hpp"
+#include "FlatAST.hpp"
 #include "amayori-llvm.hpp"
 
 // Tokenizer Tests
 class TokenizerTest : public ::testing::Test {
 protected:
-    std::vector<Token> tokenize(const std::string& source) {
+    TokenStream tokenize(const std::string& source) {
         Tokenizer tokenizer(source);
         return tokenizer.tokenize();
     }
@@ -15,19 +27,597 @@ protected:
 TEST_F(TokenizerTest, BasicTokenization) {
     auto tokens = tokenize("let x = 42;");
     
-    ASSERT_EQ(tokens.size(), 5); // Including EOF
+    ASSERT_EQ(tokens.size(), 6); // Including EOF
     EXPECT_EQ(tokens[0].type, TokenType::Let);
     EXPECT_EQ(tokens[1].type, TokenType::Identifier);
-    EXPECT_EQ(tokens[1].lexeme, "x");
+    EXPECT_EQ(tokens.lexeme(1), "x");
     EXPECT_EQ(tokens[2].type, TokenType::Equals);
     EXPECT_EQ(tokens[3].type, TokenType::Integer);
-    EXPECT_EQ(tokens[3].lexeme, "42");
+    EXPECT_EQ(tokens.lexeme(3), "42");
+    EXPECT_EQ(tokens.literal(3).as_int(), 42);
+    EXPECT_EQ(tokens[4].type, TokenType::Semicolon);
+    EXPECT_EQ(tokens.symbol(1), amyr::span::Symbol::intern("x"));
+}
+
+TEST_F(TokenizerTest, TokensAreSpansIntoSource) {
+    const std::string source = "let answer = 42;";
+    auto tokens = tokenize(source);
+
+    Token ident = tokens[1];
+    EXPECT_EQ(ident.start, 4u);
+    EXPECT_EQ(ident.len, 6u);
+    EXPECT_EQ(ident.lexeme(source), "answer");
+    EXPECT_EQ(tokens[0].index, Token::NO_INDEX);
+}
+
+TEST_F(TokenizerTest, NumericLiterals) {
+    auto tokens = tokenize("0xFF_u8 0o17 0b1010_1010 1_000_000 340282366920938463463374607431768211455 2.5e3 1f32");
+
+    EXPECT_EQ(tokens.type(0), TokenType::Integer);
+    EXPECT_EQ(tokens.literal(0).as_int(), 255);
+    EXPECT_EQ(tokens.literal(0).suffix, amyr::lexer::NumericSuffix::U8);
+    EXPECT_EQ(tokens.literal(1).as_int(), 15);
+    EXPECT_EQ(tokens.literal(2).as_int(), 170);
+    EXPECT_EQ(tokens.literal(3).as_int(), 1000000);
+    EXPECT_TRUE(tokens.literal(4).integer == ~amyr::lexer::u128(0));
+    EXPECT_FALSE(tokens.literal(4).as_int().has_value());
+    EXPECT_EQ(tokens.type(5), TokenType::Float);
+    EXPECT_EQ(tokens.literal(5).floating, 2500.0);
+    EXPECT_EQ(tokens.type(6), TokenType::Float);
+    EXPECT_EQ(tokens.literal(6).floating, 1.0);
+
+    auto separated = tokenize("1_000.2_5e1_0");
+    EXPECT_EQ(separated.type(0), TokenType::Float);
+    EXPECT_EQ(separated.literal(0).floating, 1000.25e10);
+
+    const std::string long_float = "1_" + std::string(200, '0') + ".5";
+    for (const char* bad : {"340282366920938463463374607431768211456", "256u8", "0b102", "1.5u32", "0x",
+                            long_float.c_str()}) {
+        const std::string source = bad;
+        Tokenizer tokenizer(source);
+        auto bad_tokens = tokenizer.tokenize();
+        EXPECT_EQ(bad_tokens.type(0), TokenType::Unknown) << bad;
+        EXPECT_EQ(bad_tokens.lexeme(0), source) << bad;
+        EXPECT_EQ(tokenizer.diagnostics().size(), 1u) << bad;
+    }
+}
+
+TEST_F(TokenizerTest, UnicodeIdentifiers) {
+    const std::string source = "let café = 1;\nlet 变量 = café;";
+    auto tokens = tokenize(source);
+    ASSERT_EQ(tokens[1].type, TokenType::Identifier);
+    EXPECT_EQ(tokens.lexeme(1), "café");
+    EXPECT_EQ(tokens[6].type, TokenType::Identifier);
+    EXPECT_EQ(tokens.lexeme(6), "变量");
+    EXPECT_EQ(tokens[8].index, tokens[1].index);
+
+    const std::string bad = "let x = \u00a7;";
+    Tokenizer tokenizer(bad);
+    auto bad_tokens = tokenizer.tokenize();
+    EXPECT_EQ(bad_tokens.type(3), TokenType::Unknown);
+    EXPECT_EQ(bad_tokens.lexeme(3), "\u00a7");
+    EXPECT_EQ(bad_tokens.type(4), TokenType::Semicolon);
+}
+
+TEST(SourceFileTest, RejectsInvalidUtf8) {
+    using amyr::span::SourceFile;
+    EXPECT_NO_THROW(SourceFile::from_string("ok", "let \u00e9 = \U0001F600;"));
+    // Overlong '/', lone continuation byte, UTF-16 surrogate, truncated sequence.
+    for (const char* bad : {"a\xC0\xAF", "a\x80", "\xED\xA0\x80", "let x\xE6\x97"}) {
+        EXPECT_THROW(SourceFile::from_string("bad", bad), std::runtime_error) << bad;
+    }
+}
+
+TEST_F(TokenizerTest, RelexMatchesFullRetokenize) {
+    std::string text;
+    for (int i = 0; i < 100; ++i) {
+        text += "let x" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+    }
+    TokenStream tokens = tokenize(text);
+
+    struct Case { std::string needle; std::string replacement; };
+    const std::vector<Case> edits = {
+        {"x42", "x42y"},               // grows a token
+        {" = 7;", " = 7.5;"},          // integer becomes float
+        {"x9 ", "x9 + 1 "},            // inserts tokens
+        {"let x50 = 50;\n", ""},       // deletes a line
+        {"x60 = 60", "x60 = 60 // gone"}, // turns the tail of a line into a comment
+    };
+    std::vector<std::string> texts{text};
+    texts.reserve(edits.size() + 1);  // tokens view into these strings
+    for (const Case& c : edits) {
+        const std::string& before = texts.back();
+        const size_t at = before.find(c.needle);
+        ASSERT_NE(at, std::string::npos) << c.needle;
+        std::string after = before;
+        after.replace(at, c.needle.size(), c.replacement);
+        texts.push_back(after);
+
+        TextEdit edit{static_cast<uint32_t>(at), static_cast<uint32_t>(at + c.needle.size()), c.replacement};
+        RelexResult result = relex(std::move(tokens), texts.back(), edit);
+        tokens = std::move(result.tokens);
+        EXPECT_LT(result.old_end - result.first, 8u) << c.needle;
+
+        TokenStream expected = tokenize(texts.back());
+        ASSERT_EQ(tokens.size(), expected.size()) << c.needle;
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            ASSERT_EQ(tokens.type(i), expected.type(i)) << c.needle << ", token " << i;
+            ASSERT_EQ(tokens.start(i), expected.start(i)) << c.needle << ", token " << i;
+            ASSERT_EQ(tokens.lexeme(i), expected.lexeme(i)) << c.needle << ", token " << i;
+            if (tokens.type(i) == TokenType::Identifier) {
+                EXPECT_EQ(tokens.symbol(i), expected.symbol(i));
+            }
+        }
+    }
+    EXPECT_EQ(tokens.literal(tokens.size() - 3).as_int(), 99);
+}
+
+TEST_F(TokenizerTest, RelexCoversLexerLookahead) {
+    // `1.` only lexes as a float when the byte after the dot allows it, so an
+    // edit two bytes past the end of `1` can still change that token.
+    const std::string before = "}1._||";
+    const std::string after = "}1.,let ||";
+    TextEdit edit{3, 4, ",let "};
+    RelexResult result = relex(tokenize(before), after, edit);
+
+    TokenStream expected = tokenize(after);
+    ASSERT_EQ(result.tokens.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(result.tokens.type(i), expected.type(i)) << "token " << i;
+        EXPECT_EQ(result.tokens.lexeme(i), expected.lexeme(i)) << "token " << i;
+    }
+    ASSERT_EQ(expected.type(1), TokenType::Float);
+    EXPECT_TRUE(result.tokens.literal(1).is_float);
+    EXPECT_EQ(result.tokens.literal(1).floating, 1.0);
+}
+
+TEST_F(TokenizerTest, RelexDropsReplacedLiterals) {
+    // Rewrites the middle literal of `1 + 10 + 3` over and over.
+    std::vector<std::string> texts{"1 + 10 + 3"};
+    texts.reserve(101);  // tokens view into these strings
+    TokenStream tokens = tokenize(texts.back());
+    for (int i = 11; i <= 110; ++i) {
+        texts.push_back("1 + " + std::to_string(i) + " + 3");
+        const uint32_t old_len = static_cast<uint32_t>(std::to_string(i - 1).size());
+        TextEdit edit{4, 4 + old_len, std::string_view(texts.back()).substr(4, texts.back().size() - 8)};
+        tokens = relex(std::move(tokens), texts.back(), edit).tokens;
+    }
+    EXPECT_LE(tokens.literal_count(), 6u);
+    EXPECT_EQ(tokens.literal(0).as_int(), 1);
+    EXPECT_EQ(tokens.literal(2).as_int(), 110);
+    EXPECT_EQ(tokens.literal(4).as_int(), 3);
+}
+
+// Applies `edit` to `before`, relexes, and compares with a full tokenize of the result.
+testing::AssertionResult relex_matches_tokenize(const std::string& before, uint32_t start, uint32_t end,
+                                                const std::string& replacement) {
+    const std::string after = before.substr(0, start) + replacement + before.substr(end);
+    TokenStream tokens = relex(Tokenizer(before).tokenize(), after, TextEdit{start, end, replacement}).tokens;
+    TokenStream expected = Tokenizer(after).tokenize();
+    if (tokens.size() != expected.size()) {
+        return testing::AssertionFailure() << tokens.size() << " tokens instead of " << expected.size();
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (tokens.type(i) != expected.type(i) || tokens.start(i) != expected.start(i) ||
+            tokens.lexeme(i) != expected.lexeme(i)) {
+            return testing::AssertionFailure() << "token " << i << " is '" << tokens.lexeme(i)
+                                               << "' instead of '" << expected.lexeme(i) << "'";
+        }
+    }
+    return testing::AssertionSuccess();
+}
+
+TEST(RelexTest, EditsInTrivia) {
+    // Insertion into whitespace, insertion into a comment, deletion that uncomments code.
+    EXPECT_TRUE(relex_matches_tokenize("aaaa      b", 8, 8, "c"));
+    EXPECT_TRUE(relex_matches_tokenize("aaaa  // xy\nb", 9, 9, "\nc "));
+    EXPECT_TRUE(relex_matches_tokenize("aaaa    //x\nb", 8, 10, ""));
+}
+
+TEST(RelexTest, RandomEditsMatchFullTokenize) {
+    const std::vector<std::string> pieces = {"a", "b1", " ", "  ", "\n", "//", "1", ".", "_", "+", "=", "<", "|", "let"};
+    std::mt19937 rng(12345);
+    auto pick = [&](size_t n) { return static_cast<size_t>(rng() % n); };
+    auto random_text = [&](size_t count) {
+        std::string text;
+        for (size_t i = 0; i < count; ++i) {
+            text += pieces[pick(pieces.size())];
+        }
+        return text;
+    };
+    for (int round = 0; round < 2000; ++round) {
+        const std::string before = random_text(1 + pick(30));
+        const uint32_t start = static_cast<uint32_t>(pick(before.size() + 1));
+        const uint32_t end = start + static_cast<uint32_t>(pick(before.size() - start + 1));
+        const std::string replacement = random_text(pick(4));
+        ASSERT_TRUE(relex_matches_tokenize(before, start, end, replacement))
+            << "'" << before << "' [" << start << ", " << end << ") -> '" << replacement << "'";
+    }
+}
+
+TEST(TokenSourceTest, LexersReportTheSameErrors) {
+    const std::string source = "let x = !1 . 2 @ # ? : ~ $ [ ] \u00a7 != 0xZ;";
+    LowLexerTokenSource low(source);
+    LexingTokenSource lexing(source);
+    while (low.next().token.type != TokenType::EOF_TOKEN) {}
+    while (lexing.next().token.type != TokenType::EOF_TOKEN) {}
+
+    ASSERT_EQ(low.diagnostics().size(), lexing.diagnostics().size());
+    ASSERT_FALSE(low.diagnostics().empty());
+    for (size_t i = 0; i < low.diagnostics().size(); ++i) {
+        EXPECT_EQ(low.diagnostics()[i].start, lexing.diagnostics()[i].start) << i;
+        EXPECT_EQ(low.diagnostics()[i].len, lexing.diagnostics()[i].len) << i;
+        EXPECT_STREQ(low.diagnostics()[i].what, lexing.diagnostics()[i].what) << i;
+    }
+}
+
+TEST(TokenSourceTest, StreamingMatchesStoredTokens) {
+    std::string source;
+    for (int i = 0; i < 50; ++i) {
+        source += "let x" + std::to_string(i) + " = " + std::to_string(i) + " * 2.5; // note\n";
+    }
+    StoredTokenSource stored(Tokenizer(source).tokenize());
+    LexingTokenSource streaming(source);
+
+    for (;;) {
+        BufferedToken expected = stored.next();
+        BufferedToken actual = streaming.next();
+        ASSERT_EQ(actual.token.type, expected.token.type);
+        ASSERT_EQ(actual.token.start, expected.token.start);
+        ASSERT_EQ(actual.token.len, expected.token.len);
+        if (expected.token.type == TokenType::Float) {
+            ASSERT_EQ(actual.literal.floating, expected.literal.floating);
+        }
+        if (expected.token.type == TokenType::EOF_TOKEN) {
+            break;
+        }
+    }
+    // Both sources stay on EOF.
+    EXPECT_EQ(streaming.next().token.type, TokenType::EOF_TOKEN);
+    EXPECT_EQ(stored.next().token.type, TokenType::EOF_TOKEN);
+}
+
+// Low-level Lexer Tests
+TEST(LowLexerTest, TokensCarryPayload) {
+    using namespace amyr::lexer;
+    using Token = amyr::lexer::Token;
+    std::vector<Token> tokens;
+    TokenIterator iter("0x1F_u8 r#\"raw\"# /// doc\n/* open 'a'");
+    while (auto token = iter.next()) {
+        if (token->kind != TokenKind::Whitespace) {
+            tokens.push_back(*token);
+        }
+    }
+
+    ASSERT_EQ(tokens.size(), 4u);
+    EXPECT_EQ(tokens[0].kind, TokenKind::Literal);
+    EXPECT_EQ(tokens[0].literal_kind, LiteralKind::Int);
+    EXPECT_EQ(tokens[0].base(), Base::Hexadecimal);
+    EXPECT_EQ(tokens[0].suffix_start(), 5u);
+    EXPECT_EQ(tokens[1].literal_kind, LiteralKind::RawStr);
+    EXPECT_EQ(tokens[1].n_hashes(), std::optional<uint8_t>(1));
+    EXPECT_EQ(tokens[2].kind, TokenKind::LineComment);
+    EXPECT_EQ(tokens[2].doc_style(), DocStyle::Outer);
+    EXPECT_EQ(tokens[3].kind, TokenKind::BlockComment);
+    EXPECT_FALSE(tokens[3].terminated());
+}
+
+TEST(LowLexerTest, UnicodeIdentifiersAndWhitespace) {
+    using namespace amyr::lexer;
+    using Token = amyr::lexer::Token;
+    // NEL and LINE SEPARATOR are whitespace; CJK, accented and Greek letters are XID.
+    const std::string source = "日本\u0085caf\u00e9\u2028\u03b1\u00b2 x\U0001F600 \u00a7";
+    std::vector<Token> tokens;
+    TokenIterator iter(source);
+    while (auto token = iter.next()) {
+        tokens.push_back(*token);
+    }
+
+    const std::vector<std::pair<TokenKind, unsigned>> expected = {
+        {TokenKind::Ident, 6}, {TokenKind::Whitespace, 2}, {TokenKind::Ident, 5},
+        {TokenKind::Whitespace, 3}, {TokenKind::Ident, 2}, {TokenKind::Unknown, 2},
+        {TokenKind::Whitespace, 1}, {TokenKind::InvalidIdent, 5}, {TokenKind::Whitespace, 1},
+        {TokenKind::Unknown, 2},
+    };
+    ASSERT_EQ(tokens.size(), expected.size());
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        EXPECT_EQ(tokens[i].kind, expected[i].first) << "token " << i;
+        EXPECT_EQ(tokens[i].len, expected[i].second) << "token " << i;
+    }
+    EXPECT_TRUE(is_ident("ñandú_2"));
+    EXPECT_FALSE(is_ident("2ñ"));
+}
+
+TEST(CharClassTest, TableMatchesTheLanguage) {
+    using namespace amyr::lexer;
+    int digits = 0, hex = 0, id_start = 0, id_continue = 0, whitespace = 0;
+    for (int b = 0; b < 256; ++b) {
+        const char c = static_cast<char>(b);
+        digits += is_ascii_digit(static_cast<unsigned char>(c));
+        hex += is_ascii_hex_digit(static_cast<unsigned char>(c));
+        id_start += is_ascii_id_start(static_cast<unsigned char>(c));
+        id_continue += is_ascii_id_continue(static_cast<unsigned char>(c));
+        whitespace += is_ascii_whitespace(static_cast<unsigned char>(c));
+        // A negative char must not index past the table.
+        EXPECT_EQ(char_class::of(c), b < 0x80 ? char_class::TABLE[b] : 0) << b;
+    }
+    EXPECT_EQ(digits, 10);
+    EXPECT_EQ(hex, 22);
+    EXPECT_EQ(id_start, 53);
+    EXPECT_EQ(id_continue, 63);
+    EXPECT_EQ(whitespace, 6);
+    // Every punctuation byte lexes as a token of its own.
+    for (char c : std::string_view(";,.(){}[]@#~?:$=!<>-&|+*/^%")) {
+        const std::string text(1, c);
+        auto token = TokenIterator(text).next();
+        EXPECT_NE(token->kind, TokenKind::Unknown) << c;
+        EXPECT_EQ(token->len, 1u) << c;
+    }
+
+    // `_` starts identifiers but isn't XID_Start.
+    EXPECT_TRUE(is_id_start('_'));
+    EXPECT_FALSE(amyr::unicode::is_xid_start('_'));
+    EXPECT_TRUE(amyr::unicode::is_xid_continue('_'));
+}
+
+// Byte-at-a-time scans of a block comment (`s` starts with `/*`) and of a raw
+// string (`s` starts with `r`), returning the token length and whether it ends.
+std::pair<size_t, bool> reference_block_comment(std::string_view s) {
+    size_t depth = 1;
+    for (size_t i = 2; i < s.size();) {
+        if (i + 1 < s.size() && s[i] == '/' && s[i + 1] == '*') {
+            depth++;
+            i += 2;
+        } else if (i + 1 < s.size() && s[i] == '*' && s[i + 1] == '/') {
+            i += 2;
+            if (--depth == 0) return {i, true};
+        } else {
+            i++;
+        }
+    }
+    return {s.size(), false};
+}
+
+std::pair<size_t, bool> reference_raw_string(std::string_view s) {
+    const size_t hashes = s.find('"') - 1;
+    for (size_t i = hashes + 2; i < s.size(); ++i) {
+        if (s[i] != '"') continue;
+        size_t closing = 0;
+        while (closing < hashes && i + 1 + closing < s.size() && s[i + 1 + closing] == '#') closing++;
+        if (closing == hashes) return {i + 1 + hashes, true};
+        i += closing;
+    }
+    return {s.size(), false};
+}
+
+TEST(LowLexerTest, DelimiterDenseCommentsAndRawStrings) {
+    using namespace amyr::lexer;
+    std::vector<std::string> comments = {
+        "/*" + std::string(5000, '*') + "*/",
+        "/*" + std::string(5000, '/') + "*/",
+        "/*" + std::string(3000, '/') + std::string(3000, '*'),
+        "/*/*/**/*/",
+        "/**/*/",
+    };
+    std::string nested = "/*";
+    for (int i = 0; i < 500; ++i) nested += "/*/";
+    for (int i = 0; i < 501; ++i) nested += "**/";
+    comments.push_back(nested);
+
+    std::vector<std::string> raw_strings = {
+        "r#\"" + std::string(5000, '"') + "\"#",
+        "r##\"" + std::string(4000, '#') + "\"#" + std::string(4000, '"') + "\"##",
+        "r###\"{\"a\":\"#\",\"b\":\"##\"}\"##",
+        "r\"" + std::string(100, '#') + "\"",
+    };
+    std::string chained = "r###\"";
+    for (int i = 0; i < 2000; ++i) chained += i % 3 == 0 ? "\"#" : "\"##";
+    raw_strings.push_back(chained + "\"###");
+
+    // Random mixes of the delimiter bytes, long enough to cross vector blocks.
+    uint32_t seed = 12345;
+    auto next = [&seed] { seed = seed * 1103515245u + 12345u; return seed >> 16; };
+    for (int n = 0; n < 300; ++n) {
+        std::string comment = "/*";
+        std::string raw = "r" + std::string(next() % 4, '#') + "\"";
+        const size_t len = next() % 120;
+        for (size_t i = 0; i < len; ++i) {
+            comment += "*/ \n"[next() % 4];
+            raw += "\"# \n"[next() % 4];
+        }
+        comments.push_back(comment);
+        raw_strings.push_back(raw);
+    }
+
+    for (auto level : {amyr::simd::Level::Scalar, amyr::simd::Level::SSE2, amyr::simd::Level::AVX2}) {
+        amyr::simd::set_level(level);
+        for (const std::string& comment : comments) {
+            const auto [len, terminated] = reference_block_comment(comment);
+            auto token = TokenIterator(comment).next();
+            ASSERT_EQ(token->kind, TokenKind::BlockComment) << comment;
+            EXPECT_EQ(token->len, len) << comment;
+            EXPECT_EQ(token->terminated(), terminated) << comment;
+        }
+        for (const std::string& raw : raw_strings) {
+            const auto [len, terminated] = reference_raw_string(raw);
+            auto token = TokenIterator(raw).next();
+            ASSERT_EQ(token->literal_kind, LiteralKind::RawStr) << raw;
+            EXPECT_EQ(token->len, len) << raw;
+            EXPECT_EQ(token->n_hashes().has_value(), terminated) << raw;
+        }
+    }
+    amyr::simd::set_level(amyr::simd::detect_level());
+}
+
+// Unescaping Tests
+TEST(UnescapeTest, ReportsEveryCharacterWithItsRange) {
+    using namespace amyr::lexer;
+    std::vector<std::pair<EscapeRange, char32_t>> units;
+    unescape_unicode("a\\t\\u{e9}\u00e9", Mode::Str, [&](EscapeRange range, const ResultEsc<MixedUnit>& res) {
+        ASSERT_TRUE(res.is_ok());
+        units.emplace_back(range, res.unwrap().as_char());
+    });
+    const std::vector<std::pair<EscapeRange, char32_t>> expected = {
+        {{0, 1}, U'a'}, {{1, 3}, U'\t'}, {{3, 9}, U'\u00e9'}, {{9, 11}, U'\u00e9'},
+    };
+    EXPECT_EQ(units, expected);
+
+    EXPECT_EQ(unescape_char_or_byte("\u00e9", Mode::Char).unwrap(), U'\u00e9');
+    EXPECT_EQ(unescape_char_or_byte("\\xff", Mode::Byte).unwrap(), 0xFFu);
+    EXPECT_EQ(unescape_char_or_byte("ab", Mode::Char).unwrap_err(), EscapeError::MoreThanOneChar);
+    EXPECT_EQ(unescape_char_or_byte("\u00e9", Mode::Byte).unwrap_err(), EscapeError::NonAsciiCharInByte);
+}
+
+TEST(UnescapeTest, ArenaUnescapingBorrowsPlainLiterals) {
+    using namespace amyr::lexer;
+    DroplessArena arena;
+
+    const std::string plain = "no escapes here, just text \u00e9";
+    auto borrowed = unescape_into_arena(plain, Mode::Str, arena);
+    ASSERT_TRUE(borrowed.is_ok());
+    EXPECT_EQ(borrowed.unwrap().data(), plain.data());
+
+    EXPECT_EQ(unescape_into_arena("a\\n\\x41\\u{1F_600}\\\n    b", Mode::Str, arena).unwrap(),
+              "a\nA\U0001F600b");
+    EXPECT_EQ(unescape_into_arena("\\xff\\\"", Mode::ByteStr, arena).unwrap(), "\xff\"");
+    EXPECT_EQ(unescape_into_arena("\\d", Mode::RawStr, arena).unwrap(), "\\d");
+
+    EXPECT_EQ(unescape_into_arena("\\u{D800}", Mode::Str, arena).unwrap_err(), EscapeError::LoneSurrogateUnicodeEscape);
+    EXPECT_EQ(unescape_into_arena("\\u{1234567}", Mode::Str, arena).unwrap_err(), EscapeError::OverlongUnicodeEscape);
+    EXPECT_EQ(unescape_into_arena("\\xff", Mode::Str, arena).unwrap_err(), EscapeError::OutOfRangeHexEscape);
+    EXPECT_EQ(unescape_into_arena("a\\0", Mode::CStr, arena).unwrap_err(), EscapeError::NulInCStr);
+    EXPECT_EQ(unescape_into_arena("\u00e9", Mode::ByteStr, arena).unwrap_err(), EscapeError::NonAsciiCharInByte);
+    EXPECT_EQ(unescape_into_arena("a\rb", Mode::RawStr, arena).unwrap_err(), EscapeError::BareCarriageReturnInRawString);
+}
+
+// Parallel Lexing Tests
+TEST(ParallelLexerTest, MatchesSequentialAcrossMultilineTokens) {
+    // Strings, block comments and raw strings that span lines put newline
+    // boundaries inside tokens, which the stitcher has to detect and repair.
+    std::string source;
+    for (int i = 0; i < 200; ++i) {
+        source += "let x" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+        if (i % 7 == 0) source += "/* outer\n /* nested\n */\n still comment\n */\n";
+        if (i % 11 == 0) source += "let s = \"line one\nline two\nline three\";\n";
+        if (i % 13 == 0) source += "let r = r#\"raw\n\"quoted\"\n text\"#;\n";
+    }
+
+    std::vector<amyr::lexer::Token> sequential;
+    amyr::lexer::TokenIterator iter(source);
+    while (auto token = iter.next()) {
+        sequential.push_back(*token);
+    }
+
+    ThreadPool pool(4);
+    for (size_t chunk_size : {16, 64, 333, 4096}) {
+        auto parallel = amyr::lexer::tokenize_parallel(source, pool, chunk_size);
+        ASSERT_EQ(parallel.size(), sequential.size()) << "chunk size " << chunk_size;
+        for (size_t i = 0; i < parallel.size(); ++i) {
+            ASSERT_EQ(parallel[i].kind, sequential[i].kind) << "token " << i;
+            ASSERT_EQ(parallel[i].len, sequential[i].len) << "token " << i;
+        }
+    }
+}
+
+// Source Map Tests
+TEST(SourceMapTest, ResolvesPositionsAcrossFiles) {
+    using namespace amyr::span;
+    SourceMap map;
+    const SourceMap::File& a = map.add(SourceFile::from_string("a.amy", "let x = 1;\nlet y = 2;\n"));
+    std::string long_text;
+    for (int i = 0; i < 100; ++i) {
+        long_text += "let v" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+    }
+    long_text += "let \u00e9t\u00e9 = 3;";
+    const SourceMap::File& b = map.add(SourceFile::from_string("b.amy", long_text));
+
+    EXPECT_GT(b.start_pos(), a.end_pos());
+    EXPECT_EQ(&map.lookup_file(a.end_pos()), &a);
+    EXPECT_EQ(&map.lookup_file(b.start_pos()), &b);
+
+    EXPECT_EQ(a.lookup(a.pos(0)), (LineCol{1, 1}));
+    EXPECT_EQ(a.lookup(a.pos(15)), (LineCol{2, 5}));
+    EXPECT_EQ(map.describe(b.pos(static_cast<uint32_t>(long_text.find("v42")))), "b.amy:43:5");
+
+    // Columns count characters: `=` is the 9th character but the 11th byte.
+    const uint32_t eq = static_cast<uint32_t>(long_text.rfind('='));
+    EXPECT_EQ(b.lookup(b.pos(eq)), (LineCol{101, 9}));
+    EXPECT_EQ(line_col(long_text, eq), (LineCol{101, 9}));
+    EXPECT_EQ(b.lines().line_count(), 101u);
+}
+
+// Symbol Interner Tests
+TEST(SymbolTest, InterningIsIdempotent) {
+    using amyr::span::Symbol;
+    Symbol foo = Symbol::intern("foo");
+    EXPECT_EQ(foo, Symbol::intern(std::string("foo")));
+    EXPECT_NE(foo, Symbol::intern("bar"));
+    EXPECT_EQ(foo.as_str(), "foo");
+    EXPECT_FALSE(foo.is_keyword());
+}
+
+TEST(SymbolTest, KeywordsArePreinterned) {
+    using amyr::span::Symbol;
+    namespace kw = amyr::span::kw;
+    EXPECT_EQ(Symbol::intern("let"), kw::Let);
+    EXPECT_EQ(kw::Mut.as_str(), "mut");
+    EXPECT_TRUE(kw::Func.is_keyword());
+    EXPECT_FALSE(kw::Empty.is_keyword());
+}
+
+// AST Arena Tests
+TEST(AstArenaTest, OwnsNodesAndSlices) {
+    using namespace amyr::ast;
+    static int live = 0;
+    struct Counted {
+        int value;
+        explicit Counted(int value) : value(value) { ++live; }
+        Counted(Counted&& other) : value(other.value) { ++live; }
+        ~Counted() { --live; }
+    };
+
+    {
+        Arena arena;
+        std::vector<P<Expr>> statements;
+        for (int i = 0; i < 3; ++i) {
+            statements.push_back(arena.alloc<BinaryExpr>(arena.alloc<LiteralExpr>(i), arena.alloc<LiteralExpr>(i + 1), "+"));
+        }
+        P<Expr> block = arena.alloc<BlockExpr>(arena.alloc_slice(std::move(statements)));
+
+        // P only moves; the moved-from pointer is left empty.
+        P<Expr> owner = std::move(block);
+        EXPECT_EQ(block, nullptr);
+        auto& stmts = static_cast<BlockExpr&>(*owner).statements;
+        ASSERT_EQ(stmts.size(), 3u);
+        auto& last = static_cast<BinaryExpr&>(*stmts.back());
+        EXPECT_EQ(std::get<int>(static_cast<LiteralExpr&>(*last.rhs).value), 3);
+
+        std::vector<P<PathSegment>> segments;
+        segments.push_back(arena.alloc<PathSegment>("std"));
+        segments.push_back(arena.alloc<PathSegment>("cmp"));
+        Path path(arena.alloc_slice(std::move(segments)));
+        EXPECT_EQ(path.getSegments()[1]->getIdent(), "cmp");
+
+        // Destructors run when the arena goes, for nodes and for slice elements.
+        std::vector<Counted> counted;
+        counted.reserve(100);
+        for (int i = 0; i < 100; ++i) {
+            counted.emplace_back(i);
+        }
+        Slice<Counted> run = arena.alloc_slice(std::move(counted));
+        counted.clear();
+        arena.alloc<Counted>(7);
+        EXPECT_EQ(live, 101);
+        EXPECT_EQ(run[99].value, 99);
+        EXPECT_GT(arena.allocated_bytes(), 0u);
+    }
+    EXPECT_EQ(live, 0);
 }
 
 // Parser Tests
 class ParserTest : public ::testing::Test {
 protected:
-    std::shared_ptr<node::ExprAST> parse(const std::string& source) {
+    node::ParsedAst parse(const std::string& source) {
         Tokenizer tokenizer(source);
         auto tokens = tokenizer.tokenize();
         node::Parser parser(std::move(tokens));
@@ -41,19 +631,352 @@ TEST_F(ParserTest, BasicParsing) {
     
     auto* let_expr = dynamic_cast<node::LetExprAST*>(ast.get());
     ASSERT_NE(let_expr, nullptr);
-    EXPECT_EQ(let_expr->getName(), "x");
+    EXPECT_EQ(let_expr->getName().as_str(), "x");
     
-    auto* init_expr = dynamic_cast<node::IntExprAST*>(let_expr->getInitExpr().get());
+    auto* init_expr = dynamic_cast<node::IntExprAST*>(let_expr->getInitExpr());
     ASSERT_NE(init_expr, nullptr);
     EXPECT_EQ(init_expr->getVal(), 42);
 }
 
+TEST_F(ParserTest, StreamingParsing) {
+    const std::string source = "let x = 40 + 2;";
+    node::Parser parser(std::make_unique<LexingTokenSource>(source));
+    auto ast = parser.parse();
+
+    auto* let_expr = dynamic_cast<node::LetExprAST*>(ast.get());
+    ASSERT_NE(let_expr, nullptr);
+    EXPECT_EQ(let_expr->getName().as_str(), "x");
+}
+
+TEST_F(ParserTest, TreesOwnTheirNodes) {
+    node::ParsedAst first;
+    node::ParsedAst program;
+    {
+        const std::string source = "let a = 1 + 2 * 3\nlet b = a - 4; a / b";
+        node::Parser parser(std::make_unique<LowLexerTokenSource>(source));
+        first = parser.parse();
+        program = parser.parse_program();
+    }
+
+    // Both trees outlive the parser, and each keeps only its own nodes alive.
+    auto* let_a = dynamic_cast<node::LetExprAST*>(first.get());
+    ASSERT_NE(let_a, nullptr);
+    auto* sum = dynamic_cast<node::BinaryExprAST*>(let_a->getInitExpr());
+    ASSERT_NE(sum, nullptr);
+    EXPECT_EQ(sum->getOp(), node::BinOp::Add);
+    auto* product = dynamic_cast<node::BinaryExprAST*>(sum->getRHS());
+    ASSERT_NE(product, nullptr);
+    EXPECT_EQ(dynamic_cast<node::IntExprAST*>(product->getRHS())->getVal(), 3);
+
+    auto* block = dynamic_cast<node::BlockExprAST*>(program.get());
+    ASSERT_NE(block, nullptr);
+    ASSERT_EQ(block->getExpressions().size(), 2u);
+    EXPECT_NE(dynamic_cast<node::LetExprAST*>(block->getExpressions()[0]), nullptr);
+    auto* quotient = dynamic_cast<node::BinaryExprAST*>(block->getExpressions()[1]);
+    ASSERT_NE(quotient, nullptr);
+    EXPECT_EQ(quotient->getOp(), node::BinOp::Div);
+}
+
+// Fully parenthesized form of a binary expression tree.
+std::string render(const node::ExprAST* expr) {
+    if (auto* binary = dynamic_cast<const node::BinaryExprAST*>(expr)) {
+        return "(" + render(binary->getLHS()) + " " + amyr::ast::BinOpKind(binary->getOp()).asStr() + " " +
+               render(binary->getRHS()) + ")";
+    }
+    if (auto* int_expr = dynamic_cast<const node::IntExprAST*>(expr)) {
+        return std::to_string(int_expr->getVal());
+    }
+    return "?";
+}
+
+TEST_F(ParserTest, OperatorPrecedence) {
+    const std::vector<std::pair<std::string, std::string>> cases = {
+        {"1 - 2 - 3", "((1 - 2) - 3)"},
+        {"1 + 2 * 3 % 4", "(1 + ((2 * 3) % 4))"},
+        {"1 << 2 + 3", "(1 << (2 + 3))"},
+        {"1 | 2 ^ 3 & 4", "(1 | (2 ^ (3 & 4)))"},
+        {"1 == 2 | 3", "(1 == (2 | 3))"},
+        {"1 < 2 && 3 >= 4 || 5 != 6", "(((1 < 2) && (3 >= 4)) || (5 != 6))"},
+        {"(1 || 2) * 3", "((1 || 2) * 3)"},
+    };
+    for (const auto& [source, expected] : cases) {
+        EXPECT_EQ(render(parse(source).get()), expected) << source;
+        node::Parser fused(std::make_unique<LowLexerTokenSource>(source));
+        EXPECT_EQ(render(fused.parse().get()), expected) << source;
+    }
+
+    EXPECT_THROW(parse("1 < 2 < 3"), std::runtime_error);
+    EXPECT_THROW(parse("1 == 2 != 3"), std::runtime_error);
+    EXPECT_NO_THROW(parse("1 < 2 && 2 < 3"));
+}
+
+TEST_F(ParserTest, DeeplyNestedExpressions) {
+    // Far deeper than one native stack frame per level would allow.
+    constexpr int DEPTH = 200000;
+    std::string source = "let x = 1";
+    for (int i = 0; i < DEPTH; ++i) {
+        source += " + 1";
+    }
+    source += ";\n";
+    for (int i = 0; i < DEPTH; ++i) {
+        source += "x * (";
+    }
+    source += "x" + std::string(DEPTH, ')');
+
+    node::Parser parser(std::make_unique<LowLexerTokenSource>(source));
+    node::ParsedAst program;
+    ASSERT_NO_THROW(program = parser.parse_program());
+    const node::ExprList items = static_cast<node::BlockExprAST&>(*program).getExpressions();
+    ASSERT_EQ(items.size(), 2u);
+
+    // The chain leans left, the parentheses lean right.
+    const node::ExprAST* expr = static_cast<node::LetExprAST*>(items[0])->getInitExpr();
+    int depth = 0;
+    while (auto* binary = dynamic_cast<const node::BinaryExprAST*>(expr)) {
+        expr = binary->getLHS();
+        ++depth;
+    }
+    EXPECT_EQ(depth, DEPTH);
+    expr = items[1];
+    depth = 0;
+    while (auto* binary = dynamic_cast<const node::BinaryExprAST*>(expr)) {
+        EXPECT_EQ(binary->getOp(), node::BinOp::Mul);
+        expr = binary->getRHS();
+        ++depth;
+    }
+    EXPECT_EQ(depth, DEPTH);
+
+    amyr::borrow::BorrowChecker checker;
+    EXPECT_TRUE(checker.check(items[1]));
+    node::FlatAst flat;
+    const node::ExprId root = flat.add(program.get());
+    EXPECT_EQ(flat.size(), 4u * DEPTH + 4);
+    EXPECT_EQ(flat.op(flat.init(flat.items(root)[0])), node::BinOp::Add);
+}
+
+TEST_F(ParserTest, FusedParsingMatchesTwoPass) {
+    const std::string source = "let x = 40 + 2; // answer\nlet y = x * 0x10;\n"
+                               "let z = x<<1 >= y>>2 || x != y && x%3 == 1 | y ^ 2 & x || x <= y && y < x || x > 0;";
+
+    Tokenizer tokenizer(source);
+    TokenBuffer stored(std::make_unique<StoredTokenSource>(tokenizer.tokenize()));
+    TokenBuffer fused(std::make_unique<LowLexerTokenSource>(source));
+    while (true) {
+        const BufferedToken& a = stored.peek();
+        const BufferedToken& b = fused.peek();
+        ASSERT_EQ(a.token.type, b.token.type);
+        EXPECT_EQ(a.token.start, b.token.start);
+        EXPECT_EQ(a.token.len, b.token.len);
+        if (a.token.type == TokenType::Identifier) {
+            EXPECT_EQ(a.token.index, b.token.index);
+        } else if (a.token.type == TokenType::Integer) {
+            EXPECT_EQ(a.literal.as_int(), b.literal.as_int());
+        }
+        if (a.token.type == TokenType::EOF_TOKEN) {
+            break;
+        }
+        stored.bump();
+        fused.bump();
+    }
+
+    // The fused source also drops block comments, which the Tokenizer doesn't know.
+    const std::string program = source + " /* block /* nested */ */ y - 1;";
+    node::Parser parser(std::make_unique<LowLexerTokenSource>(program));
+    auto ast = parser.parse_program();
+    ASSERT_NE(dynamic_cast<node::BlockExprAST*>(ast.get()), nullptr);
+
+    node::Parser bad(std::make_unique<LowLexerTokenSource>("let x = 1 @ 2;"));
+    EXPECT_THROW(bad.parse_program(), std::runtime_error);
+
+    // An unterminated comment must not leave a program that parses on its own.
+    node::Parser truncated(std::make_unique<LowLexerTokenSource>("let x = 1; /* let y = 2;"));
+    EXPECT_THROW(truncated.parse_program(), std::runtime_error);
+}
+
+TEST_F(ParserTest, LazyFunctionBodies) {
+    const std::string source = "let g = 1;\n"
+                               "func add(a, b) {\n  let c = a + b * 2;\n  c - (a % b)\n}\n"
+                               "func none() { 7 }\n"
+                               "func bad(x) {\n  x +\n  { y } }\n"
+                               "g";
+
+    const std::string valid = source.substr(0, source.find("func bad"));
+    node::Parser eager(std::make_unique<LowLexerTokenSource>(valid));
+    const node::ParsedAst expected = eager.parse_program();
+    const node::ExprList expected_items = static_cast<node::BlockExprAST&>(*expected).getExpressions();
+
+    Tokenizer tokenizer(source);
+    std::vector<std::unique_ptr<TokenSource>> sources;
+    sources.push_back(std::make_unique<LowLexerTokenSource>(source));
+    sources.push_back(std::make_unique<LexingTokenSource>(source));
+    sources.push_back(std::make_unique<StoredTokenSource>(tokenizer.tokenize()));
+    while (!sources.empty()) {
+        node::Parser parser(std::move(sources.back()), node::FunctionBodies::Lazy);
+        sources.pop_back();
+        const node::ParsedAst program = parser.parse_program();
+        const node::ExprList items = static_cast<node::BlockExprAST&>(*program).getExpressions();
+        ASSERT_EQ(items.size(), 5u);
+
+        // Signatures are there before any body is parsed.
+        auto* add = dynamic_cast<node::FunctionAST*>(items[1]);
+        ASSERT_NE(add, nullptr);
+        EXPECT_EQ(add->getProto()->getName().as_str(), "add");
+        EXPECT_EQ(add->getProto()->getArgs(), (std::vector<std::string>{"a", "b"}));
+        EXPECT_FALSE(add->isBodyParsed());
+        EXPECT_TRUE(dynamic_cast<node::FunctionAST*>(items[2])->getProto()->getArgs().empty());
+
+        // Bodies parse on first use, the same as an eager parse builds them.
+        for (size_t i = 1; i <= 2; ++i) {
+            const auto* lazy_body = static_cast<node::FunctionAST*>(items[i])->getBody();
+            const auto* eager_body = static_cast<node::FunctionAST*>(expected_items[i])->getBody();
+            const node::ExprList lazy_statements = static_cast<const node::BlockExprAST*>(lazy_body)->getExpressions();
+            const node::ExprList eager_statements = static_cast<const node::BlockExprAST*>(eager_body)->getExpressions();
+            ASSERT_EQ(lazy_statements.size(), eager_statements.size());
+            for (size_t j = 0; j < lazy_statements.size(); ++j) {
+                const node::ExprAST* lazy_expr = lazy_statements[j];
+                const node::ExprAST* eager_expr = eager_statements[j];
+                if (auto* let = dynamic_cast<const node::LetExprAST*>(lazy_expr)) {
+                    lazy_expr = let->getInitExpr();
+                    eager_expr = static_cast<const node::LetExprAST*>(eager_expr)->getInitExpr();
+                }
+                EXPECT_EQ(render(lazy_expr), render(eager_expr));
+            }
+        }
+        EXPECT_TRUE(add->isBodyParsed());
+        EXPECT_EQ(add->getBody(), add->getBody());
+
+        // The nested braces were skipped by matching them; the error only shows once the body is needed.
+        auto* bad = static_cast<node::FunctionAST*>(items[3]);
+        try {
+            bad->getBody();
+            ADD_FAILURE() << "expected a parse error";
+        } catch (const std::runtime_error& e) {
+            EXPECT_STREQ(e.what(), "Line 9: Expect expression.");
+        }
+        EXPECT_FALSE(bad->isBodyParsed());
+        EXPECT_THROW(bad->getBody(), std::runtime_error);
+    }
+
+    // Bodies only see their parameters and their own variables.
+    node::Parser outer(std::make_unique<LowLexerTokenSource>("let g = 1; func f() { g }"));
+    EXPECT_THROW(outer.parse_program(), std::runtime_error);
+    node::Parser unclosed(std::make_unique<LowLexerTokenSource>("func f(a) { a"), node::FunctionBodies::Lazy);
+    EXPECT_THROW(unclosed.parse_program(), std::runtime_error);
+}
+
+TEST_F(ParserTest, ParallelItemsMatchSequential) {
+    std::string source;
+    for (int i = 0; i < 300; ++i) {
+        source += "let g" + std::to_string(i) + " = " + std::to_string(i) + ";\n";
+        source += "func f" + std::to_string(i) + "(a, b) {\n  let c = a * " + std::to_string(i) +
+                  " + b;\n  c << 1 | a % (b + 1)\n}\n";
+    }
+
+    node::Parser sequential(std::make_unique<LowLexerTokenSource>(source));
+    const node::ParsedAst expected = sequential.parse_program();
+    const node::ExprList expected_items = static_cast<node::BlockExprAST&>(*expected).getExpressions();
+
+    ThreadPool pool(4);
+    node::Parser parser(std::make_unique<LowLexerTokenSource>(source));
+    const node::ParsedAst program = parser.parse_program(pool);
+    const node::ExprList items = static_cast<node::BlockExprAST&>(*program).getExpressions();
+    ASSERT_EQ(items.size(), expected_items.size());
+
+    for (size_t i = 1; i < items.size(); i += 2) {
+        auto* function = dynamic_cast<node::FunctionAST*>(items[i]);
+        ASSERT_NE(function, nullptr);
+        EXPECT_TRUE(function->isBodyParsed());
+        EXPECT_EQ(function->getProto()->getName(), static_cast<node::FunctionAST*>(expected_items[i])->getProto()->getName());
+        const node::ExprList body = static_cast<node::BlockExprAST*>(function->getBody())->getExpressions();
+        const node::ExprList expected_body =
+            static_cast<node::BlockExprAST*>(static_cast<node::FunctionAST*>(expected_items[i])->getBody())->getExpressions();
+        ASSERT_EQ(body.size(), 2u);
+        EXPECT_EQ(render(static_cast<node::LetExprAST*>(body[0])->getInitExpr()),
+                  render(static_cast<node::LetExprAST*>(expected_body[0])->getInitExpr()));
+        EXPECT_EQ(render(body[1]), render(expected_body[1]));
+    }
+
+    // With several errors, the one thrown is the first in source order, as in a sequential parse.
+    const std::string bad = source + "func late() { 1 + }\n" + source + "func later() { ) }\nlet x = ;";
+    auto message = [&bad](auto parse) {
+        try {
+            parse(bad);
+        } catch (const std::runtime_error& e) {
+            return std::string(e.what());
+        }
+        return std::string("no error");
+    };
+    const std::string first = message([](const std::string& text) {
+        node::Parser parser(std::make_unique<LowLexerTokenSource>(text));
+        parser.parse_program();
+    });
+    EXPECT_EQ(first, "Line 1501: Expect expression.");
+    for (int run = 0; run < 3; ++run) {
+        EXPECT_EQ(message([&pool](const std::string& text) {
+            node::Parser parser(std::make_unique<LowLexerTokenSource>(text));
+            parser.parse_program(pool);
+        }), first);
+    }
+}
+
+// Flat AST Tests
+TEST(FlatAstTest, MatchesPointerTree) {
+    const std::string source = "let a = 1 + 2 * 3; let b = (a - 4) / a; b";
+    node::Parser parser(std::make_unique<LowLexerTokenSource>(source));
+    node::ParsedAst program = parser.parse_program();
+
+    node::FlatAst flat;
+    const node::ExprId root = flat.add(program.get());
+    ASSERT_EQ(flat.size(), 14u);
+    ASSERT_EQ(flat.kind(root), node::ExprKind::Block);
+    EXPECT_EQ(flat.first(root), 0u);
+
+    const node::ExprIds items = flat.items(root);
+    ASSERT_EQ(items.size(), 3u);
+    const node::ExprId let_a = items[0];
+    ASSERT_EQ(flat.kind(let_a), node::ExprKind::Let);
+    EXPECT_EQ(flat.symbol(let_a).as_str(), "a");
+    EXPECT_FALSE(flat.is_mutable(let_a));
+
+    // Children come first, so `1 + 2 * 3` is ids 0..4 with `+` last.
+    const node::ExprId sum = flat.init(let_a);
+    EXPECT_EQ(sum, 4u);
+    EXPECT_EQ(flat.op(sum), node::BinOp::Add);
+    EXPECT_EQ(flat.int_value(flat.lhs(sum)), 1);
+    EXPECT_EQ(flat.op(flat.rhs(sum)), node::BinOp::Mul);
+    EXPECT_EQ(flat.first(let_a), 0u);
+
+    const node::ExprId let_b = items[1];
+    EXPECT_EQ(flat.first(let_b), let_a + 1);
+    EXPECT_EQ(flat.op(flat.init(let_b)), node::BinOp::Div);
+    EXPECT_EQ(flat.kind(items[2]), node::ExprKind::Variable);
+
+    // Borrow info and errors are side tables with the pointer tree's defaults.
+    EXPECT_EQ(flat.borrow_kind(items[2]), node::BorrowKind::Shared);
+    EXPECT_EQ(flat.borrow_kind(let_b), node::BorrowKind::None);
+    flat.set_error(sum, "bad sum");
+    EXPECT_TRUE(flat.has_error(sum));
+    EXPECT_FALSE(flat.has_error(let_a));
+    EXPECT_EQ(flat.error_message(sum), "bad sum");
+
+    amyr::borrow::BorrowChecker checker;
+    for (size_t i = 0; i < items.size(); ++i) {
+        auto* block = static_cast<node::BlockExprAST*>(program.get());
+        EXPECT_EQ(checker.check(flat, items[i]), checker.check(block->getExpressions()[i]));
+    }
+
+    const node::ExprId let_m = flat.add_let(amyr::span::Symbol::intern("m"), true, flat.add_int(-7));
+    EXPECT_TRUE(flat.is_mutable(let_m));
+    EXPECT_EQ(flat.int_value(flat.init(let_m)), -7);
+    EXPECT_EQ(flat.first(let_m), root + 1);
+}
+
 // Borrow Checker Tests
 class BorrowCheckerTest : public ::testing::Test {
 protected:
     amyr::borrow::BorrowChecker checker;
     
-    std::shared_ptr<node::ExprAST> parse(const std::string& source) {
+    node::ParsedAst parse(const std::string& source) {
         Tokenizer tokenizer(source);
         auto tokens = tokenizer.tokenize();
         node::Parser parser(std::move(tokens));
@@ -68,18 +991,21 @@ protected:
 
 TEST_F(BorrowCheckerTest, BasicBorrowChecking) {
     EXPECT_TRUE(checkCode("let x = 42;"));
-    EXPECT_FALSE(checkCode("let x = y;")); // undefined variable
+    // The parser rejects undefined variables before the checker sees them.
+    EXPECT_THROW(checkCode("let x = y;"), std::runtime_error);
     
-    // Test mutable borrow
-    EXPECT_TRUE(checkCode("let mut x = 42;"));
+    // Test mutable binding; `mut` follows the name in this grammar
+    EXPECT_TRUE(checkCode("let x mut = 42;"));
     
-    // Test multiple borrows
+    // Borrow expressions aren't in the grammar yet, so conflicting borrows
+    // can't reach the checker; the parser stops at the `&`.
     const char* code = R"(
-        let mut x = 42;
+        let x mut = 42;
         let y = &x;  // OK: shared borrow
         let z = &mut x;  // Error: cannot have mutable borrow while shared
     )";
-    EXPECT_FALSE(checkCode(code));
+    node::Parser parser(Tokenizer(code).tokenize());
+    EXPECT_THROW(parser.parse_program(), std::runtime_error);
 }
 
 // LLVM IR Generation Tests
@@ -102,6 +1028,28 @@ TEST_F(IRGeneratorTest, BasicIRGeneration) {
     verifyIR("let x = 42;");
 }
 
+TEST_F(IRGeneratorTest, DeeplyNestedExpressions) {
+    std::string source = "1";
+    for (int i = 0; i < 100000; ++i) {
+        source += " - (1";
+    }
+    verifyIR(source + std::string(100000, ')'));
+}
+
+TEST_F(IRGeneratorTest, FlatTreeMatchesPointerTree) {
+    Tokenizer tokenizer("(1 + 2) * 3 - 8 / 4");
+    node::Parser parser(tokenizer.tokenize());
+    auto ast = parser.parse();
+    node::FlatAst flat;
+    const node::ExprId root = flat.add(ast.get());
+
+    // Constants are uniqued per context, so equal values are the same pointer.
+    IRGenerator generator;
+    auto* value = generator.generateIR(ast.get());
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(generator.generateIR(flat, root), value);
+}
+
 // Integration Tests
 TEST(IntegrationTest, CompleteCompilation) {
     const char* source = R"(
@@ -116,7 +1064,7 @@ TEST(IntegrationTest, CompleteCompilation) {
     ASSERT_FALSE(tokens.empty());
     
     node::Parser parser(std::move(tokens));
-    auto ast = parser.parse();
+    auto ast = parser.parse_program();
     ASSERT_NE(ast, nullptr);
     
     amyr::borrow::BorrowChecker checker;
@@ -125,12 +1073,43 @@ TEST(IntegrationTest, CompleteCompilation) {
     IRGenerator generator;
     auto* ir = generator.generateIR(ast.get());
     ASSERT_NE(ir, nullptr);
+    // The block's value is its last expression, folded to a constant.
+    auto* constant = llvm::dyn_cast<llvm::ConstantInt>(ir);
+    ASSERT_NE(constant, nullptr);
+    EXPECT_EQ(constant->getSExtValue(), 42);
+
+    // The flat tree lowers to the same value.
+    node::FlatAst flat;
+    const node::ExprId root = flat.add(ast.get());
+    EXPECT_EQ(generator.generateIR(flat, root), ir);
 }
 
 // Error Handling Tests
 TEST(ErrorHandlingTest, TokenizerErrors) {
     Tokenizer tokenizer("@"); // Invalid character
-    EXPECT_THROW(tokenizer.tokenize(), std::runtime_error);
+    auto tokens = tokenizer.tokenize();
+    EXPECT_EQ(tokens.type(0), TokenType::Unknown);
+    ASSERT_EQ(tokenizer.diagnostic_messages().size(), 1u);
+    EXPECT_EQ(tokenizer.diagnostic_messages()[0], "Unexpected character '@' at line 1");
+}
+
+TEST(ErrorHandlingTest, TokenizerReportsEveryErrorInOnePass) {
+    std::string source;
+    for (int i = 0; i < 1000; ++i) {
+        source += "let x" + std::to_string(i) + " = $ + 0b2 + 1;\n";
+    }
+    Tokenizer tokenizer(source);
+    auto tokens = tokenizer.tokenize();
+
+    EXPECT_EQ(tokens.size(), 1000u * 9 + 1);
+    ASSERT_EQ(tokenizer.diagnostics().size(), 2000u);
+    const std::vector<std::string> messages = tokenizer.diagnostic_messages();
+    EXPECT_EQ(messages[0], "Unexpected character '$' at line 1");
+    EXPECT_EQ(messages[1999], "Invalid digit for the base of number literal '0b2' at line 1000");
+
+    // The streaming source hands the same error tokens to the parser.
+    node::Parser parser(std::make_unique<LexingTokenSource>(source));
+    EXPECT_THROW(parser.parse(), std::runtime_error);
 }
 
 TEST(ErrorHandlingTest, ParserErrors) {
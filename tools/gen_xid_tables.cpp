@@ -0,0 +1,96 @@
+/*
+Generates the XID_Start/XID_Continue tables used by amyr-tokenizer/unicode_xid.hpp.
+
+The code space is cut into leaves of 512 code points, stored as 512-bit
+bitsets. Identical leaves are stored once; per property, a root array maps
+`cp >> 9` to its leaf. Most of the code space is unassigned or all-letters,
+so only a few hundred distinct leaves remain.
+
+Run by the build: `amyr-gen-xid <output header>`.
+*/
+#include<cstdint>
+#include<cstdio>
+#include<map>
+#include<vector>
+
+#include <unicode/uchar.h>
+#include <unicode/uversion.h>
+
+namespace {
+
+constexpr uint32_t MAX_CODE_POINT = 0x10FFFF;
+constexpr unsigned LEAF_BITS = 9;
+constexpr uint32_t LEAF_SIZE = 1u << LEAF_BITS;
+constexpr uint32_t WORDS_PER_LEAF = LEAF_SIZE / 64;
+constexpr uint32_t ROOT_SIZE = (MAX_CODE_POINT + 1) / LEAF_SIZE;
+
+using Leaf = std::vector<uint64_t>;
+
+std::vector<uint32_t> build_root(UProperty property, std::vector<Leaf>& leaves, std::map<Leaf, uint32_t>& index) {
+    std::vector<uint32_t> root(ROOT_SIZE);
+    for (uint32_t block = 0; block < ROOT_SIZE; ++block) {
+        Leaf leaf(WORDS_PER_LEAF, 0);
+        for (uint32_t i = 0; i < LEAF_SIZE; ++i) {
+            const UChar32 c = static_cast<UChar32>(block * LEAF_SIZE + i);
+            if (u_hasBinaryProperty(c, property)) {
+                leaf[i / 64] |= uint64_t(1) << (i % 64);
+            }
+        }
+        auto [it, inserted] = index.emplace(leaf, static_cast<uint32_t>(leaves.size()));
+        if (inserted) {
+            leaves.push_back(leaf);
+        }
+        root[block] = it->second;
+    }
+    return root;
+}
+
+void write_root(FILE* out, const char* name, const char* type, const std::vector<uint32_t>& root) {
+    std::fprintf(out, "inline constexpr %s %s[%u] = {", type, name, ROOT_SIZE);
+    for (size_t i = 0; i < root.size(); ++i) {
+        std::fprintf(out, "%s%u,", i % 24 == 0 ? "\n    " : " ", root[i]);
+    }
+    std::fprintf(out, "\n};\n\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        std::fprintf(stderr, "usage: %s <output header>\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Leaf> leaves;
+    std::map<Leaf, uint32_t> index;
+    const std::vector<uint32_t> start = build_root(UCHAR_XID_START, leaves, index);
+    const std::vector<uint32_t> cont = build_root(UCHAR_XID_CONTINUE, leaves, index);
+
+    FILE* out = std::fopen(argv[1], "w");
+    if (!out) {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    const char* index_type = leaves.size() <= 256 ? "uint8_t" : "uint16_t";
+    std::fprintf(out, "// Generated by tools/gen_xid_tables.cpp from Unicode %s (ICU %s). Do not edit.\n",
+                 U_UNICODE_VERSION, U_ICU_VERSION);
+    std::fprintf(out, "#pragma once\n\n#include<cstdint>\n\n");
+    std::fprintf(out, "namespace amyr {\nnamespace unicode {\nnamespace xid_tables {\n\n");
+    std::fprintf(out, "inline constexpr unsigned LEAF_BITS = %u;\n\n", LEAF_BITS);
+    write_root(out, "START_ROOT", index_type, start);
+    write_root(out, "CONTINUE_ROOT", index_type, cont);
+
+    std::fprintf(out, "inline constexpr uint64_t LEAVES[%zu][%u] = {\n", leaves.size(), WORDS_PER_LEAF);
+    for (const Leaf& leaf : leaves) {
+        std::fprintf(out, "    {");
+        for (uint32_t w = 0; w < WORDS_PER_LEAF; ++w) {
+            std::fprintf(out, "%s0x%016llxull", w == 0 ? "" : ", ", static_cast<unsigned long long>(leaf[w]));
+        }
+        std::fprintf(out, "},\n");
+    }
+    std::fprintf(out, "};\n\n} // namespace xid_tables\n} // namespace unicode\n} // namespace amyr\n");
+
+    std::fclose(out);
+    return 0;
+}